@@ -0,0 +1,84 @@
+// Fills an atlas page with random image sizes, then churns it (evict some,
+// insert new ones) and reports how full the page stays and how long inserts
+// take. CPU only, no pixels.
+//
+//   ./AtlasBench [page size] [churn rounds]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "AtlasPacker.hpp"
+
+#include <vector>
+
+static Uint32 randomSide() { return 8 + (Uint32)SDL_rand(57); }
+
+int main(int argc, char **argv) {
+  Uint32 pageSize = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 2048;
+  int rounds = argc > 2 ? SDL_atoi(argv[2]) : 20;
+
+  AtlasPacker packer;
+  packer.init(pageSize, pageSize);
+  std::vector<AtlasRect> placed;
+
+  Uint64 start = SDL_GetTicksNS();
+  AtlasRect rect;
+  // Stop after a few misses in a row; the page is as good as full then.
+  for (int misses = 0; misses < 32;) {
+    if (packer.insert(randomSide(), randomSide(), rect)) {
+      placed.push_back(rect);
+      misses = 0;
+    } else {
+      misses++;
+    }
+  }
+  Uint64 fillNS = SDL_GetTicksNS() - start;
+  SDL_Log("fill:  %zu images, %.1f%% occupied, %.2f us per insert, "
+          "%u free rects",
+          placed.size(), packer.occupancy() * 100.0f,
+          fillNS / 1e3 / placed.size(), packer.freeRectCount());
+
+  // Every round evicts a quarter of the images and refills the page.
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < placed.size() / 4; i++) {
+      size_t victim = (size_t)SDL_rand((Sint32)placed.size());
+      packer.free(placed[victim]);
+      placed[victim] = placed.back();
+      placed.pop_back();
+    }
+
+    start = SDL_GetTicksNS();
+    size_t inserted = 0;
+    for (int misses = 0; misses < 32;) {
+      if (packer.insert(randomSide(), randomSide(), rect)) {
+        placed.push_back(rect);
+        inserted++;
+        misses = 0;
+      } else {
+        misses++;
+      }
+    }
+    Uint64 refillNS = SDL_GetTicksNS() - start;
+    if (round == rounds - 1 || round % 5 == 0) {
+      SDL_Log("churn %2d: %zu images, %.1f%% occupied, %.2f us per insert, "
+              "%u free rects",
+              round, placed.size(), packer.occupancy() * 100.0f,
+              inserted ? refillNS / 1e3 / inserted : 0.0,
+              packer.freeRectCount());
+    }
+  }
+
+  // Sanity check: no two placed rects may overlap.
+  for (size_t i = 0; i < placed.size(); i++) {
+    for (size_t j = i + 1; j < placed.size(); j++) {
+      const AtlasRect &a = placed[i], &b = placed[j];
+      if (a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h &&
+          b.y < a.y + a.h) {
+        SDL_Log("OVERLAP between images %zu and %zu", i, j);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "SDL3/SDL_timer.h"
+
+// Runs fn() `runs` times and returns the fastest time in nanoseconds. The
+// fastest run is the one least disturbed by the OS, which is what we want
+// when comparing kernels against each other.
+template <typename Fn> Uint64 bestOfNS(int runs, Fn fn) {
+  Uint64 best = ~(Uint64)0;
+  for (int i = 0; i < runs; i++) {
+    Uint64 start = SDL_GetTicksNS();
+    fn();
+    Uint64 elapsed = SDL_GetTicksNS() - start;
+    if (elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best;
+}
+
+inline double gigabytesPerSecond(Uint64 bytes, Uint64 ns) {
+  return ns == 0 ? 0.0 : (double)bytes / (double)ns;
+}
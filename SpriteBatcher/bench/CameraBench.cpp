@@ -0,0 +1,104 @@
+// Transforms points between world and screen with a rotated, zoomed Camera2D
+// and compares three ways of doing it: rebuilding the view for every point
+// (what a helper that takes the camera's state instead of its matrix ends up
+// doing), the cached matrix one point at a time, and the cached matrix over
+// whole arrays with SSE. Also times a camera update and checks that
+// worldFromScreen really is the inverse and the round trip comes back where
+// it started. Exits nonzero if either is off.
+//
+//   ./CameraBench [points]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "Camera2D.hpp"
+
+#include <vector>
+
+static const int RUNS = 20;
+static const float WIDTH = 1920.0f;
+static const float HEIGHT = 1080.0f;
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? SDL_max((Uint32)SDL_atoi(argv[1]), 1u) : 1000000;
+
+  Camera2D camera;
+  camera.setViewport(WIDTH, HEIGHT);
+  camera.setPosition(1234.5f, -678.25f);
+  camera.setZoom(1.75f);
+  camera.setRotation(0.3f);
+  camera.setCullMargin(64.0f);
+
+  std::vector<float> x(count), y(count), outX(count), outY(count);
+  for (Uint32 i = 0; i < count; i++) {
+    x[i] = camera.x() + (SDL_randf() - 0.5f) * 4096.0f;
+    y[i] = camera.y() + (SDL_randf() - 0.5f) * 4096.0f;
+  }
+
+  // Moving the camera costs one rebuild, however many points use it after.
+  Uint32 updates = 10000;
+  Uint64 updateNS = bestOfNS(RUNS, [&] {
+    for (Uint32 i = 0; i < updates; i++) {
+      camera.setRotation(0.3f + (i & 1) * 1e-3f);
+      camera.version();
+    }
+  });
+  camera.setRotation(0.3f);
+  SDL_Log("camera update %8.1f ns (matrices, inverse and bounds)",
+          (double)updateNS / updates);
+
+  float zoom = camera.zoom(), rotation = camera.rotation();
+  float centerX = camera.x(), centerY = camera.y();
+  Uint64 rebuildNS = bestOfNS(RUNS, [&] {
+    for (Uint32 i = 0; i < count; i++) {
+      Mat4 matrix = mat4Multiply(
+          mat4Multiply(mat4Translation(WIDTH * 0.5f, HEIGHT * 0.5f, 0.0f),
+                       mat4Scale(zoom, zoom, 1.0f)),
+          mat4Multiply(mat4RotationZ(-rotation),
+                       mat4Translation(-centerX, -centerY, 0.0f)));
+      mat4TransformPoint(matrix, x[i], y[i], outX[i], outY[i]);
+    }
+  });
+  const Mat4 &screenFromWorld = camera.screenFromWorld();
+  Uint64 singleNS = bestOfNS(RUNS, [&] {
+    for (Uint32 i = 0; i < count; i++) {
+      mat4TransformPoint(screenFromWorld, x[i], y[i], outX[i], outY[i]);
+    }
+  });
+  Uint64 batchNS = bestOfNS(RUNS, [&] {
+    camera.worldToScreen(x.data(), y.data(), count, outX.data(), outY.data());
+  });
+  SDL_Log("%u points, world to screen", count);
+  SDL_Log("rebuilt view  %8.2f ns per point", (double)rebuildNS / count);
+  SDL_Log("cached matrix %8.2f ns per point", (double)singleNS / count);
+  SDL_Log("batched       %8.2f ns per point  %6.1f M points/s",
+          (double)batchNS / count, count * 1e3 / batchNS);
+
+  // M * inverse(M) should be the identity, to within float rounding of
+  // matrices that hold translations in the thousands.
+  Mat4 product = mat4Multiply(camera.screenFromWorld(),
+                              camera.worldFromScreen());
+  Mat4 identity = mat4Identity();
+  float worstIdentity = 0.0f;
+  for (int i = 0; i < 16; i++) {
+    worstIdentity =
+        SDL_max(worstIdentity, SDL_fabsf(product.m[i] - identity.m[i]));
+  }
+
+  // World -> screen -> world, relative to the size of the world spread.
+  camera.screenToWorld(outX.data(), outY.data(), count, outX.data(),
+                       outY.data());
+  float worstRoundTrip = 0.0f;
+  for (Uint32 i = 0; i < count; i++) {
+    worstRoundTrip = SDL_max(worstRoundTrip, SDL_fabsf(outX[i] - x[i]));
+    worstRoundTrip = SDL_max(worstRoundTrip, SDL_fabsf(outY[i] - y[i]));
+  }
+  SDL_Log("M * inverse(M) off by %g, round trip off by %g world units",
+          worstIdentity, worstRoundTrip);
+  if (worstIdentity > 1e-3f || worstRoundTrip > 0.01f) {
+    SDL_Log("The camera's inverse is wrong");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Compares the 64 byte std140 layout against the 32 byte compact layout:
+// bytes uploaded per frame, packing throughput, and how far the compact
+// values drift from the float ones once the shader unpacks them.
+//
+//   ./CompactBench [sprite count] [world size]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "SpritePacking.hpp"
+#include "SpriteStore.hpp"
+
+#include <cmath>
+#include <vector>
+
+static const int RUNS = 20;
+
+// What vertex.vert's loadSprite does with COMPACT_SPRITES, on the CPU.
+static SpriteData unpack(const CompactSpriteData &packed) {
+  SpriteData sprite{};
+  sprite.x = halfToFloat(packed.positionXY & 0xffff);
+  sprite.y = halfToFloat(packed.positionXY >> 16);
+  sprite.z = halfToFloat(packed.positionZRotation & 0xffff);
+  float rotation = (Sint16)(packed.positionZRotation >> 16) / 32767.0f;
+  sprite.rotation = (rotation < -1.0f ? -1.0f : rotation) * 3.14159265f;
+  sprite.w = halfToFloat(packed.scale & 0xffff);
+  sprite.h = halfToFloat(packed.scale >> 16);
+  sprite.texU = (packed.texUV & 0xffff) / 65535.0f;
+  sprite.texV = (packed.texUV >> 16) / 65535.0f;
+  sprite.texW = (packed.texWH & 0xffff) / 65535.0f;
+  sprite.texH = (packed.texWH >> 16) / 65535.0f;
+  sprite.r = (packed.color & 0xff) / 255.0f;
+  sprite.g = ((packed.color >> 8) & 0xff) / 255.0f;
+  sprite.b = ((packed.color >> 16) & 0xff) / 255.0f;
+  sprite.a = (packed.color >> 24) / 255.0f;
+  return sprite;
+}
+
+// Angles are compared on the circle, 2 pi and 0 are the same rotation.
+static float angleError(float a, float b) {
+  float difference = std::fabs(std::remainder(a - b, 6.28318530718f));
+  return difference;
+}
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 500000;
+  float worldSize = argc > 2 ? (float)SDL_atof(argv[2]) : 1024.0f;
+
+  SpriteStore store;
+  store.reserve(count);
+  for (Uint32 i = 0; i < count; i++) {
+    SpriteData sprite{};
+    sprite.x = SDL_randf() * worldSize;
+    sprite.y = SDL_randf() * worldSize;
+    sprite.z = SDL_randf();
+    sprite.rotation = (SDL_randf() - 0.5f) * 40.0f;
+    sprite.w = 1.0f + SDL_randf() * 63.0f;
+    sprite.h = 1.0f + SDL_randf() * 63.0f;
+    sprite.texU = SDL_randf() * 0.5f;
+    sprite.texV = SDL_randf() * 0.5f;
+    sprite.texW = SDL_randf() * 0.5f;
+    sprite.texH = SDL_randf() * 0.5f;
+    sprite.r = SDL_randf();
+    sprite.g = SDL_randf();
+    sprite.b = SDL_randf();
+    sprite.a = SDL_randf();
+    store.push(sprite);
+  }
+
+  PackKernel kernel = detectPackKernel();
+  SDL_Log("%u sprites, %s kernel", count, packKernelName(kernel));
+
+  std::vector<SpriteData> full(count);
+  std::vector<CompactSpriteData> compact(count);
+
+  Uint64 fullBytes = (Uint64)count * sizeof(SpriteData);
+  Uint64 fullNS = bestOfNS(
+      RUNS,
+      [&] { packSprites(kernel, store, nullptr, 0, count, full.data()); });
+  SDL_Log("std140  %8.3f ms %7.2f GB/s %6.2f MB/frame %7.1f MB/s at 60 fps",
+          fullNS / 1e6, gigabytesPerSecond(fullBytes, fullNS), fullBytes / 1e6,
+          fullBytes * 60 / 1e6);
+
+  Uint64 compactBytes = (Uint64)count * sizeof(CompactSpriteData);
+  Uint64 compactNS = bestOfNS(RUNS, [&] {
+    packCompactSprites(kernel, store, nullptr, 0, count, compact.data());
+  });
+  SDL_Log("compact %8.3f ms %7.2f GB/s %6.2f MB/frame %7.1f MB/s at 60 fps",
+          compactNS / 1e6, gigabytesPerSecond(compactBytes, compactNS),
+          compactBytes / 1e6, compactBytes * 60 / 1e6);
+
+  // Precision against the float path.
+  float position = 0, depth = 0, rotation = 0, scale = 0, tex = 0, color = 0;
+  for (Uint32 i = 0; i < count; i++) {
+    const SpriteData &a = full[i];
+    SpriteData b = unpack(compact[i]);
+    position = SDL_max(position, SDL_max(std::fabs(a.x - b.x),
+                                         std::fabs(a.y - b.y)));
+    depth = SDL_max(depth, std::fabs(a.z - b.z));
+    rotation = SDL_max(rotation, angleError(a.rotation, b.rotation));
+    scale = SDL_max(scale, SDL_max(std::fabs(a.w - b.w), std::fabs(a.h - b.h)));
+    tex = SDL_max(tex, SDL_max(SDL_max(std::fabs(a.texU - b.texU),
+                                       std::fabs(a.texV - b.texV)),
+                               SDL_max(std::fabs(a.texW - b.texW),
+                                       std::fabs(a.texH - b.texH))));
+    color = SDL_max(color, SDL_max(SDL_max(std::fabs(a.r - b.r),
+                                           std::fabs(a.g - b.g)),
+                                   SDL_max(std::fabs(a.b - b.b),
+                                           std::fabs(a.a - b.a))));
+  }
+
+  SDL_Log("max error (world size %.0f):", worldSize);
+  SDL_Log("  position %g units", position);
+  SDL_Log("  depth    %g", depth);
+  SDL_Log("  rotation %g radians", rotation);
+  SDL_Log("  scale    %g units", scale);
+  SDL_Log("  texcoord %g (%g texels of a 4096 texture)", tex, tex * 4096);
+  SDL_Log("  color    %g", color);
+  return 0;
+}
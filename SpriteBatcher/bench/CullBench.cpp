@@ -0,0 +1,101 @@
+// Culls sprites spread over a large map with a camera that only sees part of
+// it, and compares the cost of culling with the cost of packing everything.
+//
+//   ./CullBench [sprite count] [zoom]
+//
+// zoom > 1 looks at a smaller part of the map (mostly frustum culling),
+// zoom < 1 shows all of it with small sprites (mostly sub-pixel culling).
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "SpriteCulling.hpp"
+#include "SpritePacking.hpp"
+#include "SpriteStore.hpp"
+
+#include <vector>
+
+static const int RUNS = 20;
+static const float MAP_SIZE = 16384.0f;
+static const float VIEWPORT_WIDTH = 1920.0f;
+static const float VIEWPORT_HEIGHT = 1080.0f;
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 1000000;
+  float zoom = argc > 2 ? (float)SDL_atof(argv[2]) : 1.0f;
+
+  SpriteStore store;
+  store.reserve(count);
+  for (Uint32 i = 0; i < count; i++) {
+    SpriteData sprite{};
+    sprite.x = SDL_randf() * MAP_SIZE;
+    sprite.y = SDL_randf() * MAP_SIZE;
+    sprite.z = SDL_randf();
+    sprite.rotation = SDL_randf() * 6.28f;
+    sprite.w = 4.0f + SDL_randf() * 28.0f;
+    sprite.h = sprite.w;
+    sprite.texW = 1.0f;
+    sprite.texH = 1.0f;
+    sprite.a = 1.0f;
+    store.push(sprite);
+  }
+
+  // Orthographic camera centered on the map, like main.cpp's but zoomed.
+  float halfWidth = VIEWPORT_WIDTH * 0.5f / zoom;
+  float halfHeight = VIEWPORT_HEIGHT * 0.5f / zoom;
+  float center = MAP_SIZE * 0.5f;
+  float viewProjection[16] = {};
+  viewProjection[0] = 1.0f / halfWidth;
+  viewProjection[5] = -1.0f / halfHeight;
+  viewProjection[10] = 1.0f;
+  viewProjection[12] = -center / halfWidth;
+  viewProjection[13] = center / halfHeight;
+  viewProjection[15] = 1.0f;
+
+  CullParams params;
+  makeCullParams(viewProjection, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, 0.5f,
+                 params);
+
+  std::vector<Uint32> reference(count);
+  Uint32 referenceCount =
+      cullSpritesScalar(store, params, 0, count, reference.data());
+  SDL_Log("%u sprites, zoom %.3f: %u kept, %u culled", count, zoom,
+          referenceCount, count - referenceCount);
+
+  std::vector<Uint32> kept(count);
+  bool allMatch = true;
+  PackKernel best = detectPackKernel();
+  PackKernel kernels[] = {PackKernel::Scalar, PackKernel::SSE41,
+                          PackKernel::AVX2};
+  for (PackKernel kernel : kernels) {
+    if (kernel > best) {
+      continue;
+    }
+
+    Uint32 keptCount = 0;
+    Uint64 ns = bestOfNS(RUNS, [&] {
+      keptCount = cullSprites(kernel, store, params, 0, count, kept.data());
+    });
+
+    bool matches = keptCount == referenceCount &&
+                   SDL_memcmp(kept.data(), reference.data(),
+                              keptCount * sizeof(Uint32)) == 0;
+    SDL_Log("cull %-8s %8.3f ms%s", packKernelName(kernel), ns / 1e6,
+            matches ? "" : "  MISMATCH");
+    allMatch = allMatch && matches;
+  }
+
+  // What culling saves: packing only the kept sprites instead of all of them.
+  SpriteData *out = (SpriteData *)SDL_aligned_alloc(64, (size_t)count * 64);
+  Uint64 allNS = bestOfNS(
+      RUNS / 4, [&] { packSprites(best, store, nullptr, 0, count, out); });
+  Uint64 keptNS = bestOfNS(RUNS / 4, [&] {
+    packSprites(best, store, reference.data(), 0, referenceCount, out);
+  });
+  SDL_Log("pack all  %8.3f ms, %7.2f MB", allNS / 1e6, count * 64 / 1e6);
+  SDL_Log("pack kept %8.3f ms, %7.2f MB", keptNS / 1e6,
+          referenceCount * 64 / 1e6);
+  SDL_aligned_free(out);
+  return allMatch ? 0 : 1;
+}
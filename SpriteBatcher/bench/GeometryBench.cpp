@@ -0,0 +1,59 @@
+// Times the two sprite geometries against each other with the same probe the
+// sample runs at startup, for several sprite counts and sizes and both
+// layouts. Small sprites show the vertex cost, large ones how much of it is
+// hidden behind the fill.
+//
+//   VK_DRIVER_FILES=/path/to/lvp_icd.x86_64.json ./GeometryBench [--frames n]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "GeometryProbe.hpp"
+#include "HeadlessGPU.hpp"
+
+static const Uint32 SPRITE_COUNTS[] = {10000, 100000, 1000000};
+static const float SPRITE_SIZES[] = {2.0f, 8.0f, 16.0f};
+
+int main(int argc, char **argv) {
+  GeometryProbeSettings settings;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--frames") == 0) {
+      settings.frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  SDL_Log("%s driver, %ux%u target, best of %d frames",
+          SDL_GetGPUDeviceDriver(device), settings.targetWidth,
+          settings.targetHeight, settings.frames);
+
+  bool ok = true;
+  for (SpriteLayout layout : {SpriteLayout::Std140, SpriteLayout::Compact}) {
+    for (Uint32 count : SPRITE_COUNTS) {
+      for (float size : SPRITE_SIZES) {
+        settings.sprites = count;
+        settings.spriteSize = size;
+        GeometryProbeResult result;
+        if (!probeSpriteGeometry(device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+                                 layout, SpriteTexturing::Array, settings,
+                                 result)) {
+          ok = false;
+          break;
+        }
+        SDL_Log("%-7s %8u sprites %4.0f px  vertex pulling %8.3f ms  "
+                "instanced %8.3f ms  -> %s",
+                layout == SpriteLayout::Compact ? "compact" : "std140", count,
+                size, result.vertexPullingNS / 1e6, result.instancedNS / 1e6,
+                spriteGeometryName(result.fastest));
+      }
+    }
+  }
+
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
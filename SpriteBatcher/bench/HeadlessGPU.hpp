@@ -0,0 +1,104 @@
+#pragma once
+
+// Shared setup for the benchmarks that render without a window:
+// SpriteBatcherBench and the GPU feature benchmarks after it.
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_hints.h"
+#include "SDL3/SDL_init.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "Mat4.hpp"
+// createWhiteTexture, for the benchmarks that only need something to sample.
+#include "SpritePipeline.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// The GPU device doesn't need a window, but SDL loads Vulkan through the
+// video subsystem. The offscreen video driver needs no display server. The
+// SDL_VIDEO_DRIVER environment variable still wins over this.
+//
+// Returns NULL, with SDL shut down again, on failure.
+inline SDL_GPUDevice *createHeadlessDevice() {
+  SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+  if (!SDL_Init(SDL_INIT_VIDEO)) {
+    SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+    return NULL;
+  }
+  SDL_GPUDevice *device =
+      SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, false, NULL);
+  if (!device) {
+    SDL_Log("Failed to create GPU device: %s", SDL_GetError());
+    SDL_Quit();
+    return NULL;
+  }
+  return device;
+}
+
+// Stands in for the swapchain texture.
+inline SDL_GPUTexture *createOffscreenTarget(SDL_GPUDevice *device,
+                                             Uint32 width, Uint32 height) {
+  SDL_GPUTextureCreateInfo targetInfo{};
+  targetInfo.type = SDL_GPU_TEXTURETYPE_2D;
+  targetInfo.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+  targetInfo.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+  targetInfo.width = width;
+  targetInfo.height = height;
+  targetInfo.layer_count_or_depth = 1;
+  targetInfo.num_levels = 1;
+  return SDL_CreateGPUTexture(device, &targetInfo);
+}
+
+// Copies `size` bytes at `offset` of a GPU buffer into `out`, and waits for
+// it. For checking what a compute shader wrote; far too slow for every frame.
+inline bool downloadBuffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer,
+                           Uint32 offset, Uint32 size, void *out) {
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = size;
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+  SDL_GPUTransferBuffer *transferBuffer =
+      SDL_CreateGPUTransferBuffer(device, &transferInfo);
+  if (!transferBuffer) {
+    SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+
+  SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  SDL_GPUBufferRegion source{};
+  source.buffer = buffer;
+  source.offset = offset;
+  source.size = size;
+  SDL_GPUTransferBufferLocation destination{};
+  destination.transfer_buffer = transferBuffer;
+  SDL_DownloadFromGPUBuffer(copyPass, &source, &destination);
+  SDL_EndGPUCopyPass(copyPass);
+  SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+  bool ok = fence && SDL_WaitForGPUFences(device, true, &fence, 1);
+  SDL_ReleaseGPUFence(device, fence);
+
+  if (ok) {
+    void *data = SDL_MapGPUTransferBuffer(device, transferBuffer, false);
+    SDL_memcpy(out, data, size);
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+  } else {
+    SDL_Log("Failed to download buffer: %s", SDL_GetError());
+  }
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  return ok;
+}
+
+// mat4Orthographic into a plain array, for the benches that push it
+// without a camera. Pixel coordinates, origin at the top left.
+inline void orthographic(float left, float right, float bottom, float top,
+                         float zNear, float zFar, float out[16]) {
+  Mat4 matrix = mat4Orthographic(left, right, bottom, top, zNear, zFar);
+  SDL_memcpy(out, matrix.m, sizeof(matrix.m));
+}
+
+inline Uint64 median(std::vector<Uint64> &samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
@@ -0,0 +1,72 @@
+// Compares the old array-of-structures path (SpriteData records copied with
+// memcpy) against the structure-of-arrays packers writing the same records.
+//
+//   ./PackBench [sprite count]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "SpritePacking.hpp"
+#include "SpriteStore.hpp"
+
+#include <vector>
+
+static const int RUNS = 20;
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 500000;
+  Uint64 bytes = (Uint64)count * sizeof(SpriteData);
+
+  std::vector<SpriteData> aos(count);
+  SpriteStore store;
+  store.reserve(count);
+  for (SpriteData &sprite : aos) {
+    sprite = {};
+    sprite.x = SDL_randf() * 1000.0f;
+    sprite.y = SDL_randf() * 1000.0f;
+    sprite.z = SDL_randf();
+    sprite.rotation = SDL_randf() * 6.28f;
+    sprite.w = 16.0f;
+    sprite.h = 16.0f;
+    sprite.texW = 1.0f;
+    sprite.texH = 1.0f;
+    sprite.r = SDL_randf();
+    sprite.g = SDL_randf();
+    sprite.b = SDL_randf();
+    sprite.a = 1.0f;
+    store.push(sprite);
+  }
+
+  // Stands in for the mapped transfer buffer.
+  SpriteData *out = (SpriteData *)SDL_aligned_alloc(64, bytes);
+
+  Uint64 ns = bestOfNS(RUNS, [&] { SDL_memcpy(out, aos.data(), bytes); });
+  SDL_Log("%-16s %8.3f ms %7.2f GB/s", "AoS memcpy", ns / 1e6,
+          gigabytesPerSecond(bytes, ns));
+
+  std::vector<SpriteData> reference(count);
+  packSpritesScalar(store, nullptr, 0, count, reference.data());
+
+  bool allMatch = true;
+  PackKernel best = detectPackKernel();
+  PackKernel kernels[] = {PackKernel::Scalar, PackKernel::SSE41,
+                          PackKernel::AVX2};
+  for (PackKernel kernel : kernels) {
+    if (kernel > best) {
+      continue;
+    }
+
+    ns = bestOfNS(RUNS,
+                  [&] { packSprites(kernel, store, nullptr, 0, count, out); });
+
+    bool matches = SDL_memcmp(out, reference.data(), bytes) == 0;
+    SDL_Log("SoA %-12s %8.3f ms %7.2f GB/s%s", packKernelName(kernel),
+            ns / 1e6, gigabytesPerSecond(bytes, ns),
+            matches ? "" : "  MISMATCH");
+    allMatch = allMatch && matches;
+  }
+
+  SDL_aligned_free(out);
+  return allMatch ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+// Packs the same sprites with 1..N threads and reports how packing scales.
+// Each thread writes a disjoint slice of the output, exactly like
+// SpriteBatch::upload does with the mapped transfer buffer.
+//
+//   ./PackScalingBench [sprite count] [max threads]
+
+#include "SDL3/SDL_cpuinfo.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "SpritePacking.hpp"
+#include "SpriteStore.hpp"
+#include "WorkerPool.hpp"
+
+static const int RUNS = 20;
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 1000000;
+  int maxThreads = argc > 2 ? SDL_atoi(argv[2]) : SDL_GetNumLogicalCPUCores();
+  Uint64 bytes = (Uint64)count * sizeof(SpriteData);
+
+  SpriteStore store;
+  store.reserve(count);
+  for (Uint32 i = 0; i < count; i++) {
+    SpriteData sprite{};
+    sprite.x = SDL_randf() * 1000.0f;
+    sprite.y = SDL_randf() * 1000.0f;
+    sprite.w = 16.0f;
+    sprite.h = 16.0f;
+    sprite.a = 1.0f;
+    store.push(sprite);
+  }
+
+  SpriteData *out = (SpriteData *)SDL_aligned_alloc(64, bytes);
+  PackKernel kernel = detectPackKernel();
+  SDL_Log("%u sprites, %s kernel", count, packKernelName(kernel));
+
+  auto pack = [&](Uint32 first, Uint32 sliceCount) {
+    packSprites(kernel, store, nullptr, first, sliceCount, out + first);
+  };
+
+  Uint64 singleThreadNS = 0;
+  for (int threads = 1; threads <= maxThreads; threads++) {
+    WorkerPool pool;
+    pool.init((Uint32)threads - 1);
+
+    // Same granularity as SpriteBatch, but small enough that every thread
+    // gets work even at modest counts.
+    Uint64 ns = bestOfNS(RUNS, [&] { pool.parallelFor(count, 1024, pack); });
+    if (threads == 1) {
+      singleThreadNS = ns;
+    }
+
+    SDL_Log("%2d threads %8.3f ms %7.2f GB/s  x%.2f", threads, ns / 1e6,
+            gigabytesPerSecond(bytes, ns), (double)singleThreadNS / ns);
+    pool.shutdown();
+  }
+
+  SDL_aligned_free(out);
+  return 0;
+}
@@ -0,0 +1,201 @@
+// Runs the GPU particle system at 10k up to 4M particles into an offscreen
+// texture, and reports how long the GPU takes per frame for the compute pass
+// and the draw together. The CPU side is a uniform push and two commands,
+// whatever the count, so only the GPU time is interesting.
+//
+// After each count a few thousand of the SpriteData records particles.comp
+// wrote are read back and checked: finite, positive size, alpha in [0, 1],
+// and actually spread out from the emitter. Any failure makes the exit code
+// nonzero, so this doubles as a check that the compute path works on a
+// driver, lavapipe included:
+//
+//   VK_DRIVER_FILES=/path/to/lvp_icd.x86_64.json ./ParticleBench
+//       [--max particles] [--frames n]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "FrameLoop.hpp"
+#include "HeadlessGPU.hpp"
+#include "ParticleSystem.hpp"
+#include "SpriteData.hpp"
+#include "SpritePipeline.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 1920;
+static const Uint32 TARGET_HEIGHT = 1080;
+static const int WARMUP_FRAMES = 3;
+// A fixed step, so every run simulates the same thing.
+static const float TIME_STEP = 1.0f / 60.0f;
+static const Uint32 CHECKED_SPRITES = 4096;
+
+static const Uint32 PARTICLE_COUNTS[] = {10000,  100000,  250000,
+                                         500000, 1000000, 2000000,
+                                         4000000};
+
+struct UniformBlock {
+  float viewProjectionMatrix[16];
+};
+
+static bool isFinite(float value) {
+  return !SDL_isinff(value) && !SDL_isnanf(value);
+}
+
+// Reads back the first sprites the last update wrote and checks them.
+static bool checkSprites(SDL_GPUDevice *device, const ParticleSystem &system) {
+  Uint32 count = SDL_min(system.count(), CHECKED_SPRITES);
+  std::vector<SpriteData> sprites(count);
+  if (!downloadBuffer(device, system.spriteBuffer(), 0,
+                      count * (Uint32)sizeof(SpriteData), sprites.data())) {
+    return false;
+  }
+
+  const ParticleSystemSettings &settings = system.settings();
+  float farthest = 0.0f;
+  for (Uint32 i = 0; i < count; i++) {
+    const SpriteData &sprite = sprites[i];
+    float values[] = {sprite.x, sprite.y, sprite.z, sprite.w, sprite.h,
+                      sprite.r, sprite.g, sprite.b, sprite.a};
+    for (float value : values) {
+      if (!isFinite(value)) {
+        SDL_Log("Particle %u: not a finite number", i);
+        return false;
+      }
+    }
+    if (sprite.w <= 0.0f || sprite.h <= 0.0f) {
+      SDL_Log("Particle %u: size %f x %f", i, sprite.w, sprite.h);
+      return false;
+    }
+    if (sprite.a < 0.0f || sprite.a > 1.0f) {
+      SDL_Log("Particle %u: alpha %f", i, sprite.a);
+      return false;
+    }
+    float dx = sprite.x - settings.emitterX;
+    float dy = sprite.y - settings.emitterY;
+    farthest = SDL_max(farthest, dx * dx + dy * dy);
+  }
+  // After a few frames with random ages, some particle has to be well away
+  // from the emitter, or the integration didn't happen.
+  if (farthest < 100.0f) {
+    SDL_Log("All particles are still at the emitter");
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Uint32 maxParticles = 4000000;
+  int frames = 20;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--max") == 0) {
+      maxParticles = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  // One frame in flight: the fence wait is how long the GPU took.
+  FrameLoop frameLoop;
+  FrameLoopSettings frameLoopSettings;
+  frameLoopSettings.framesInFlight = 1;
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUGraphicsPipeline *pipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140);
+  SDL_GPUTexture *texture = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  if (!frameLoop.init(device, frameLoopSettings) || !target || !pipeline ||
+      !texture || !sampler) {
+    SDL_Log("Failed to create GPU resources: %s", SDL_GetError());
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+
+  UniformBlock uniforms;
+  orthographic(0.0f, (float)TARGET_WIDTH, (float)TARGET_HEIGHT, 0.0f, 0.0f,
+               -1.0f, uniforms.viewProjectionMatrix);
+  SDL_GPUTextureSamplerBinding textureBinding{texture, sampler};
+
+  SDL_Log("%s driver, %dx%d target, %d frames per count",
+          SDL_GetGPUDeviceDriver(device), TARGET_WIDTH, TARGET_HEIGHT, frames);
+
+  std::vector<Uint64> gpuSamples;
+  bool ok = true;
+  for (Uint32 count : PARTICLE_COUNTS) {
+    if (count > maxParticles) {
+      break;
+    }
+    ParticleSystem system;
+    ParticleSystemSettings settings;
+    settings.count = count;
+    settings.emitterX = TARGET_WIDTH * 0.5f;
+    settings.emitterY = TARGET_HEIGHT * 0.9f;
+    if (!system.init(device, settings)) {
+      ok = false;
+      break;
+    }
+
+    gpuSamples.clear();
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+      SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+      if (!commandBuffer) {
+        ok = false;
+        break;
+      }
+      system.update(commandBuffer, TIME_STEP);
+
+      SDL_GPUColorTargetInfo colorTargetInfo{};
+      colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+      colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+      colorTargetInfo.texture = target;
+      SDL_GPURenderPass *renderPass =
+          SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+      SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms,
+                                   sizeof(UniformBlock));
+      system.render(renderPass, pipeline, textureBinding);
+      SDL_EndGPURenderPass(renderPass);
+
+      if (!frameLoop.submit(commandBuffer)) {
+        ok = false;
+        break;
+      }
+      // The wait in begin() was for the previous frame.
+      if (frame >= WARMUP_FRAMES) {
+        gpuSamples.push_back(frameLoop.stats().fenceWaitNS);
+      }
+    }
+    if (ok) {
+      SDL_WaitForGPUIdle(device);
+      ok = checkSprites(device, system);
+    }
+    system.release();
+    if (!ok) {
+      SDL_Log("%8u particles  FAILED", count);
+      break;
+    }
+
+    Uint64 gpuNS = median(gpuSamples);
+    SDL_Log("%8u particles  GPU %8.3f ms/frame  %6.2f ns/particle  checked "
+            "%u",
+            count, gpuNS / 1e6, (double)gpuNS / count,
+            SDL_min(count, CHECKED_SPRITES));
+  }
+
+  frameLoop.release();
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Churns a SpritePool the way a bullet-hell scene does, a destroy and a
+// create per step at a steady population, and reports steps per second and
+// the heap allocations they made (should be 0). Random victims are the worst
+// case, every step misses the cache; a sweep that destroys while iterating is
+// the common one. Then packs the churned pool and compares it with the same
+// live sprites scattered over a sparse slot array, where the packer would
+// have to skip the dead ones.
+//
+//   ./PoolBench [live sprites] [churn steps]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "AllocationCounter.hpp"
+#include "BenchUtil.hpp"
+#include "SpritePacking.hpp"
+#include "SpritePool.hpp"
+
+#include <vector>
+
+static const int RUNS = 20;
+
+static SpriteData randomSprite() {
+  SpriteData sprite{};
+  sprite.x = SDL_randf() * 1920.0f;
+  sprite.y = SDL_randf() * 1080.0f;
+  sprite.z = SDL_randf();
+  sprite.rotation = SDL_randf() * 6.28f;
+  sprite.w = sprite.h = 8.0f;
+  sprite.texW = sprite.texH = 1.0f;
+  sprite.r = sprite.g = sprite.b = sprite.a = 1.0f;
+  return sprite;
+}
+
+int main(int argc, char **argv) {
+  installAllocationCounter();
+  Uint32 live = argc > 1 ? SDL_max((Uint32)SDL_atoi(argv[1]), 1u) : 100000;
+  Uint32 steps = argc > 2 ? (Uint32)SDL_atoi(argv[2]) : 1000000;
+
+  SpritePool pool;
+  pool.init(live);
+  for (Uint32 i = 0; i < live; i++) {
+    pool.create(randomSprite());
+  }
+
+  // Random victims, so the slots and the store get thoroughly shuffled.
+  // Picked from the store by position, which keeps the bench from needing a
+  // list of handles of its own.
+  SpriteData bullet = randomSprite();
+  Uint64 seed = 1;
+  Uint64 allocations = allocationCount();
+  Uint64 churnNS = bestOfNS(RUNS, [&] {
+    for (Uint32 i = 0; i < steps; i++) {
+      Uint32 victim = (Uint32)SDL_rand_r(&seed, (Sint32)pool.size());
+      pool.destroy(pool.handleAt(victim));
+      pool.create(bullet);
+    }
+  });
+  allocations = allocationCount() - allocations;
+  SDL_Log("%u live sprites, %u destroy + create steps", live, steps);
+  SDL_Log("churn        %8.1f ns per step  %6.2f M steps/s  %" SDL_PRIu64
+          " allocations",
+          (double)churnNS / steps, steps * 1e3 / churnNS, allocations);
+
+  // What a frame of bullets does: walk the store from the back, destroy the
+  // ones that left the screen (every eighth here), spawn as many new ones.
+  // The victims are found in order, so this mostly streams through memory.
+  Uint32 sweepSteps = 0;
+  allocations = allocationCount();
+  Uint64 sweepNS = bestOfNS(RUNS, [&] {
+    sweepSteps = 0;
+    for (Uint32 i = pool.size(); i-- > 0;) {
+      if (i % 8 == 0) {
+        pool.destroy(pool.handleAt(i));
+        sweepSteps++;
+      }
+    }
+    for (Uint32 i = 0; i < sweepSteps; i++) {
+      pool.create(bullet);
+    }
+  });
+  allocations = allocationCount() - allocations;
+  SDL_Log("sweep        %8.1f ns per step  %6.2f M steps/s  %" SDL_PRIu64
+          " allocations",
+          (double)sweepNS / sweepSteps, sweepSteps * 1e3 / sweepNS,
+          allocations);
+
+  // A stale handle must not resolve, even after its slot was reused.
+  SpriteHandle stale = pool.handleAt(0);
+  pool.destroy(stale);
+  pool.create(bullet);
+  if (pool.valid(stale)) {
+    SDL_Log("A destroyed handle still resolves");
+    return 1;
+  }
+
+  // The dense pool packs straight from its store, like a SpriteBatch.
+  Uint32 count = pool.size();
+  Uint64 bytes = (Uint64)count * sizeof(SpriteData);
+  SpriteData *out = (SpriteData *)SDL_aligned_alloc(64, bytes);
+  PackKernel kernel = detectPackKernel();
+  Uint64 denseNS = bestOfNS(RUNS, [&] {
+    packSprites(kernel, pool.sprites(), nullptr, 0, count, out);
+  });
+  SDL_Log("dense pack   %8.3f ms %7.2f GB/s (%s)", denseNS / 1e6,
+          gigabytesPerSecond(bytes, denseNS), packKernelName(kernel));
+
+  // Without swap-remove a dead sprite leaves a hole. Here half the slots are
+  // holes, and the same number of live sprites is copied out past them.
+  std::vector<SpriteData> sparse((size_t)count * 2);
+  std::vector<Uint8> alive(sparse.size(), 0);
+  for (Uint32 i = 0; i < count; i++) {
+    Uint32 slot = 2 * i + (SDL_rand(2) == 0 ? 0 : 1);
+    sparse[slot] = pool.sprites().get(i);
+    alive[slot] = 1;
+  }
+  Uint64 sparseNS = bestOfNS(RUNS, [&] {
+    Uint32 written = 0;
+    for (size_t i = 0; i < sparse.size(); i++) {
+      if (alive[i]) {
+        out[written++] = sparse[i];
+      }
+    }
+  });
+  SDL_Log("sparse copy  %8.3f ms %7.2f GB/s (half the slots dead)",
+          sparseNS / 1e6, gigabytesPerSecond(bytes, sparseNS));
+
+  SDL_aligned_free(out);
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Keeps 100k sprites in RetainedSprites and changes a fraction of them every
+// frame, from none to all, either scattered over the whole buffer or as one
+// block (a selection being dragged around). Reports dirty ranges, bytes
+// uploaded per frame next to what re-uploading everything would cost, and
+// the CPU and GPU time of a frame.
+//
+// After each run the storage buffer is read back and compared to the
+// sprites on the CPU. A mismatch means a merged range missed something, and
+// makes the exit code nonzero.
+//
+//   ./RetainedBench [--sprites n] [--frames n] [--merge-gap n]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "FrameLoop.hpp"
+#include "HeadlessGPU.hpp"
+#include "RetainedSprites.hpp"
+#include "SpriteData.hpp"
+#include "SpritePipeline.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 1920;
+static const Uint32 TARGET_HEIGHT = 1080;
+static const int WARMUP_FRAMES = 3;
+
+static const float DIRTY_FRACTIONS[] = {0.0f,  0.001f, 0.01f, 0.05f,
+                                        0.25f, 1.0f};
+
+struct UniformBlock {
+  float viewProjectionMatrix[16];
+};
+
+static SpriteData randomSprite(Uint64 &seed) {
+  SpriteData sprite{};
+  sprite.x = SDL_randf_r(&seed) * TARGET_WIDTH;
+  sprite.y = SDL_randf_r(&seed) * TARGET_HEIGHT;
+  sprite.rotation = SDL_randf_r(&seed) * 2.0f * SDL_PI_F;
+  sprite.w = sprite.h = 4.0f + SDL_randf_r(&seed) * 12.0f;
+  sprite.texW = sprite.texH = 1.0f;
+  sprite.r = sprite.g = sprite.b = sprite.a = 1.0f;
+  return sprite;
+}
+
+// Nudges the sprite, so every set() really changes something.
+static void moveSprite(RetainedSprites &retained, Uint32 index) {
+  SpriteData sprite = retained.get(index);
+  sprite.x += 1.0f;
+  sprite.rotation += 0.01f;
+  retained.set(index, sprite);
+}
+
+static bool checkBuffer(SDL_GPUDevice *device,
+                        const RetainedSprites &retained) {
+  std::vector<SpriteData> gpuSprites(retained.count());
+  if (!downloadBuffer(device, retained.spriteBuffer(), 0,
+                      retained.count() * (Uint32)sizeof(SpriteData),
+                      gpuSprites.data())) {
+    return false;
+  }
+  for (Uint32 i = 0; i < retained.count(); i++) {
+    if (SDL_memcmp(&gpuSprites[i], &retained.get(i), sizeof(SpriteData)) !=
+        0) {
+      SDL_Log("Sprite %u differs from the CPU copy", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Uint32 spriteCount = 100000;
+  int frames = 30;
+  RetainedSpritesSettings retainedSettings;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--sprites") == 0) {
+      spriteCount = SDL_max((Uint32)SDL_atoi(argv[i + 1]), 1u);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    } else if (SDL_strcmp(argv[i], "--merge-gap") == 0) {
+      retainedSettings.mergeGap = (Uint32)SDL_atoi(argv[i + 1]);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  FrameLoop frameLoop;
+  FrameLoopSettings frameLoopSettings;
+  frameLoopSettings.framesInFlight = 1;
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUGraphicsPipeline *pipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140);
+  SDL_GPUTexture *texture = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  if (!frameLoop.init(device, frameLoopSettings) || !target || !pipeline ||
+      !texture || !sampler) {
+    SDL_Log("Failed to create GPU resources: %s", SDL_GetError());
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+
+  UniformBlock uniforms;
+  orthographic(0.0f, (float)TARGET_WIDTH, (float)TARGET_HEIGHT, 0.0f, 0.0f,
+               -1.0f, uniforms.viewProjectionMatrix);
+  SDL_GPUTextureSamplerBinding textureBinding{texture, sampler};
+  Uint64 fullBytes = (Uint64)spriteCount * sizeof(SpriteData);
+
+  SDL_Log("%s driver, %u sprites, merge gap %u, %d frames per run, a full "
+          "upload is %" SDL_PRIu64 " bytes",
+          SDL_GetGPUDeviceDriver(device), spriteCount,
+          retainedSettings.mergeGap, frames, fullBytes);
+
+  std::vector<Uint64> cpuSamples, gpuSamples;
+  bool ok = true;
+  for (int clustered = 0; clustered < 2 && ok; clustered++) {
+    for (float fraction : DIRTY_FRACTIONS) {
+      RetainedSprites retained;
+      retainedSettings.capacity = spriteCount;
+      retainedSettings.framesInFlight = frameLoop.framesInFlight();
+      if (!retained.init(device, retainedSettings)) {
+        ok = false;
+        break;
+      }
+      Uint64 seed = 1;
+      for (Uint32 i = 0; i < spriteCount; i++) {
+        retained.add(randomSprite(seed));
+      }
+
+      Uint32 dirtyCount = (Uint32)(fraction * spriteCount);
+      Uint64 bytes = 0, regions = 0;
+      cpuSamples.clear();
+      gpuSamples.clear();
+      // The first frame uploads everything add()ed, and is a warmup frame.
+      for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+        SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+        if (!commandBuffer) {
+          ok = false;
+          break;
+        }
+        Uint64 start = SDL_GetTicksNS();
+        if (clustered) {
+          Sint32 positions = (Sint32)(spriteCount - dirtyCount + 1);
+          Uint32 first = (Uint32)SDL_rand_r(&seed, positions);
+          for (Uint32 i = 0; i < dirtyCount; i++) {
+            moveSprite(retained, first + i);
+          }
+        } else {
+          for (Uint32 i = 0; i < dirtyCount; i++) {
+            moveSprite(retained,
+                       (Uint32)SDL_rand_r(&seed, (Sint32)spriteCount));
+          }
+        }
+        ok = retained.upload(commandBuffer, frameLoop.frameSlot());
+        Uint64 cpuNS = SDL_GetTicksNS() - start;
+
+        SDL_GPUColorTargetInfo colorTargetInfo{};
+        colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+        colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+        colorTargetInfo.texture = target;
+        SDL_GPURenderPass *renderPass =
+            SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+        SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms,
+                                     sizeof(UniformBlock));
+        retained.render(renderPass, pipeline, textureBinding);
+        SDL_EndGPURenderPass(renderPass);
+
+        if (!frameLoop.submit(commandBuffer) || !ok) {
+          ok = false;
+          break;
+        }
+        if (frame >= WARMUP_FRAMES) {
+          cpuSamples.push_back(cpuNS);
+          // The wait in begin() was for the previous frame.
+          gpuSamples.push_back(frameLoop.stats().fenceWaitNS);
+          bytes += retained.stats().bytesUploaded;
+          regions += retained.stats().regions;
+        }
+      }
+      if (ok) {
+        SDL_WaitForGPUIdle(device);
+        ok = checkBuffer(device, retained);
+      }
+      retained.release();
+      if (!ok) {
+        SDL_Log("%-9s %6.1f%% dirty  FAILED",
+                clustered ? "clustered" : "scattered", fraction * 100.0f);
+        break;
+      }
+
+      Uint64 bytesPerFrame = bytes / frames;
+      SDL_Log("%-9s %6.1f%% dirty  %7" SDL_PRIu64 " regions  %10" SDL_PRIu64
+              " bytes/frame (%5.1f%% of full)  CPU %7.3f ms  GPU %7.3f ms",
+              clustered ? "clustered" : "scattered", fraction * 100.0f,
+              regions / frames, bytesPerFrame,
+              bytesPerFrame * 100.0 / fullBytes, median(cpuSamples) / 1e6,
+              median(gpuSamples) / 1e6);
+    }
+  }
+
+  frameLoop.release();
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
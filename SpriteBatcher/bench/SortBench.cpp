@@ -0,0 +1,130 @@
+// Times BatchKeySorter on a frame's worth of keys and checks the result
+// against std::stable_sort.
+//
+//   ./SortBench [sprite count] [texture count]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BatchKey.hpp"
+#include "BenchUtil.hpp"
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+static const int RUNS = 20;
+
+// Scratch space for the sorts, reset before each one like a frame would.
+static FrameArena arena;
+
+static void fill(BatchKeySorter &sorter, const std::vector<Uint64> &keys) {
+  sorter.clear();
+  for (Uint64 key : keys) {
+    sorter.push(key);
+  }
+}
+
+// Sorts, then checks that the order is the stable order and that the runs
+// cover every sprite exactly where the state changes.
+static bool matchesReference(BatchKeySorter &sorter,
+                             const std::vector<Uint64> &keys) {
+  fill(sorter, keys);
+  arena.reset();
+  sorter.sort(arena);
+
+  Uint32 count = (Uint32)keys.size();
+  std::vector<Uint32> reference(count);
+  std::iota(reference.begin(), reference.end(), 0u);
+  std::stable_sort(reference.begin(), reference.end(),
+                   [&](Uint32 a, Uint32 b) { return keys[a] < keys[b]; });
+
+  const Uint32 *order = sorter.order();
+  for (Uint32 i = 0; i < count; i++) {
+    if ((order ? order[i] : i) != reference[i]) {
+      return false;
+    }
+  }
+
+  Uint32 next = 0;
+  for (const BatchRun &run : sorter.runs()) {
+    if (run.first != next || run.count == 0) {
+      return false;
+    }
+    for (Uint32 i = run.first; i < run.first + run.count; i++) {
+      if (batchKeyState(keys[reference[i]]) != run.state) {
+        return false;
+      }
+    }
+    next = run.first + run.count;
+  }
+  return next == count;
+}
+
+// Returns whether the sort matched std::stable_sort.
+static bool report(const char *name, BatchKeySorter &sorter,
+                   const std::vector<Uint64> &keys) {
+  bool matches = matchesReference(sorter, keys);
+  Uint32 runs = (Uint32)sorter.runs().size();
+
+  // Refilling is part of every frame too, but not of the sort.
+  Uint64 ns = ~(Uint64)0;
+  for (int i = 0; i < RUNS; i++) {
+    fill(sorter, keys);
+    arena.reset();
+    ns = SDL_min(ns, bestOfNS(1, [&] { sorter.sort(arena); }));
+  }
+
+  std::vector<Uint64> copy = keys;
+  Uint64 stdNS = bestOfNS(RUNS / 4, [&] {
+    copy = keys;
+    std::stable_sort(copy.begin(), copy.end());
+  });
+
+  SDL_Log("%-22s %8.3f ms (std::stable_sort %8.3f ms), %u draws%s", name,
+          ns / 1e6, stdNS / 1e6, runs, matches ? "" : "  MISMATCH");
+  return matches;
+}
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 1000000;
+  Uint32 textureCount = argc > 2 ? (Uint32)SDL_atoi(argv[2]) : 16;
+
+  BatchKeySorter sorter;
+  sorter.reserve(count);
+  // Enough for the widest sort: two key and two index arrays.
+  arena.init((Uint64)count * 24 + 256);
+  std::vector<Uint64> keys(count);
+  bool matches = true;
+
+  // Static scene: every key is already in order.
+  for (Uint32 i = 0; i < count; i++) {
+    keys[i] = makeBatchKey(0, 0, (Uint16)(i * textureCount / count), 0.0f);
+  }
+  matches = report("already sorted", sorter, keys) && matches;
+
+  // A flat 2D scene: textures in any order, everything at z = 0.
+  for (Uint64 &key : keys) {
+    key = makeBatchKey(0, 0, (Uint16)SDL_rand((Sint32)textureCount), 0.0f);
+  }
+  matches = report("textures", sorter, keys) && matches;
+
+  // Few distinct depths, which compress into 32 bit items.
+  for (Uint64 &key : keys) {
+    key = makeBatchKey((Uint8)SDL_rand(4), 0,
+                       (Uint16)SDL_rand((Sint32)textureCount),
+                       (float)SDL_rand(8));
+  }
+  matches = report("layers + depth levels", sorter, keys) && matches;
+
+  // Every sprite at its own depth: the full 64 bit sort.
+  for (Uint64 &key : keys) {
+    key = makeBatchKey((Uint8)SDL_rand(4), (Uint8)SDL_rand(2),
+                       (Uint16)SDL_rand((Sint32)textureCount), SDL_randf());
+  }
+  matches = report("random depth", sorter, keys) && matches;
+
+  arena.release();
+  return matches ? 0 : 1;
+}
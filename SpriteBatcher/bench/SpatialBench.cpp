@@ -0,0 +1,111 @@
+// Compares finding the sprites under a view with the spatial grid against
+// culling every sprite, and times moves and point queries.
+//
+//   ./SpatialBench [sprite count] [zoom]
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BenchUtil.hpp"
+#include "SpatialGrid.hpp"
+#include "SpriteCulling.hpp"
+#include "SpriteStore.hpp"
+
+#include <algorithm>
+#include <vector>
+
+static const int RUNS = 20;
+static const float MAP_SIZE = 16384.0f;
+static const float VIEWPORT_WIDTH = 1920.0f;
+static const float VIEWPORT_HEIGHT = 1080.0f;
+
+int main(int argc, char **argv) {
+  Uint32 count = argc > 1 ? (Uint32)SDL_atoi(argv[1]) : 1000000;
+  float zoom = argc > 2 ? (float)SDL_atof(argv[2]) : 1.0f;
+
+  SpatialGridSettings settings;
+  settings.cellSize = 128.0f;
+  settings.columns = (Uint32)(MAP_SIZE / settings.cellSize);
+  settings.rows = settings.columns;
+  SpatialGrid grid;
+  grid.init(settings);
+
+  SpriteStore store;
+  store.reserve(count);
+  Uint64 insertNS = bestOfNS(1, [&] {
+    for (Uint32 i = 0; i < count; i++) {
+      SpriteData sprite{};
+      sprite.x = SDL_randf() * MAP_SIZE;
+      sprite.y = SDL_randf() * MAP_SIZE;
+      sprite.w = 4.0f + SDL_randf() * 28.0f;
+      sprite.h = sprite.w;
+      store.push(sprite);
+      grid.insert(i, spriteBounds(sprite.x, sprite.y, sprite.w, sprite.h));
+    }
+  });
+  SDL_Log("%u sprites, insert (with store push) %.3f ms", count,
+          insertNS / 1e6);
+
+  float halfWidth = VIEWPORT_WIDTH * 0.5f / zoom;
+  float halfHeight = VIEWPORT_HEIGHT * 0.5f / zoom;
+  float center = MAP_SIZE * 0.5f;
+  SpatialRect view = {center - halfWidth, center - halfHeight,
+                      center + halfWidth, center + halfHeight};
+
+  std::vector<Uint32> visible;
+  visible.reserve(count);
+  Uint64 queryNS = bestOfNS(RUNS, [&] { grid.queryRect(view, visible); });
+  SDL_Log("grid query   %8.3f ms, %zu sprites", queryNS / 1e6,
+          visible.size());
+
+  // The same view as a matrix, for the cull kernels.
+  float viewProjection[16] = {};
+  viewProjection[0] = 1.0f / halfWidth;
+  viewProjection[5] = -1.0f / halfHeight;
+  viewProjection[10] = 1.0f;
+  viewProjection[12] = -center / halfWidth;
+  viewProjection[13] = center / halfHeight;
+  viewProjection[15] = 1.0f;
+  CullParams params;
+  makeCullParams(viewProjection, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, 0.0f,
+                 params);
+  std::vector<Uint32> kept(count);
+  Uint32 keptCount = 0;
+  PackKernel kernel = detectPackKernel();
+  Uint64 cullNS = bestOfNS(RUNS, [&] {
+    keptCount = cullSprites(kernel, store, params, 0, count, kept.data());
+  });
+  SDL_Log("cull all     %8.3f ms, %u sprites (%s)", cullNS / 1e6, keptCount,
+          packKernelName(kernel));
+
+  // Both use the same bounds, so the grid has to find the same sprites.
+  std::sort(visible.begin(), visible.end());
+  bool matches = visible.size() == keptCount &&
+                 std::equal(visible.begin(), visible.end(), kept.begin());
+  if (!matches) {
+    SDL_Log("MISMATCH between grid query and culling");
+  }
+
+  // Small moves, like a frame of movement. Most stay in their cell.
+  const Uint32 moveCount = count < 100000 ? count : 100000;
+  Uint64 moveNS = bestOfNS(RUNS, [&] {
+    for (Uint32 i = 0; i < moveCount; i++) {
+      store.x[i] += (SDL_randf() - 0.5f) * 8.0f;
+      store.y[i] += (SDL_randf() - 0.5f) * 8.0f;
+      grid.move(i, spriteBounds(store.x[i], store.y[i], store.w[i],
+                                store.h[i]));
+    }
+  });
+  SDL_Log("move         %8.1f ns per sprite", (double)moveNS / moveCount);
+
+  std::vector<Uint32> picked;
+  picked.reserve(64);
+  const int pointQueries = 10000;
+  Uint64 pointNS = bestOfNS(RUNS, [&] {
+    for (int i = 0; i < pointQueries; i++) {
+      grid.queryPoint(SDL_randf() * MAP_SIZE, SDL_randf() * MAP_SIZE, picked);
+    }
+  });
+  SDL_Log("point query  %8.1f ns", (double)pointNS / pointQueries);
+  return matches ? 0 : 1;
+}
@@ -0,0 +1,733 @@
+// Renders batches of 1k up to 2M sprites into an offscreen texture and
+// reports, per sprite count, how long building the batch, uploading it and
+// waiting for the GPU took. The same sprites are then culled by GPUCullBatch,
+// to compare the GPU's culling time against SpriteBatch's on the CPU, and
+// drawn with the depth tested opaque and translucent passes, to compare
+// their sort and GPU time and the fragments shaded against the plain
+// back to front batch. There's
+// no window, so it runs on machines without a display, and on a software
+// Vulkan driver like lavapipe on machines without a GPU:
+//
+//   VK_DRIVER_FILES=/path/to/lvp_icd.x86_64.json ./SpriteBatcherBench
+//       [--max sprites] [--frames n] [--frames-in-flight n]
+//       [--csv file] [--json file]
+//
+// Like the other benchmarks it has to run from the build directory, where the
+// compiled shaders are.
+//
+// Heap allocations are counted while the measured frames are built and
+// uploaded. Any at all make the exit code nonzero: after the warmup frames,
+// everything a frame needs comes from the FrameArena or from buffers that
+// already have the capacity.
+
+#include "SDL3/SDL_cpuinfo.h"
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "AllocationCounter.hpp"
+#include "FrameArena.hpp"
+#include "FrameLoop.hpp"
+#include "GPUCullBatch.hpp"
+#include "HeadlessGPU.hpp"
+#include "SpriteBatch.hpp"
+#include "SpritePipeline.hpp"
+#include "WorkerPool.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 1920;
+static const Uint32 TARGET_HEIGHT = 1080;
+static const int WARMUP_FRAMES = 3;
+
+static const Uint32 SPRITE_COUNTS[] = {1000,   2000,   5000,   10000,
+                                       20000,  50000,  100000, 200000,
+                                       500000, 1000000, 2000000};
+
+// Medians over the measured frames, in nanoseconds.
+struct SweepResult {
+  Uint32 sprites;
+  Uint32 kept;
+  Uint32 drawCalls;
+  Uint64 bytesUploaded;
+  // begin() and draw() for every sprite.
+  Uint64 buildNS;
+  // SpriteBatch::upload: culling, sorting, packing and the copy pass.
+  Uint64 uploadNS;
+  // The part of uploadNS spent culling on the CPU.
+  Uint64 cullNS;
+  // GPU time of GPUCullBatch::cull's compute passes, measured like
+  // fenceWaitNS with nothing else in the command buffer.
+  Uint64 gpuCullNS;
+  // Waiting in FrameLoop::begin for the fence of the frame framesInFlight
+  // frames back. With one frame in flight that is how long the GPU needed
+  // after the submit.
+  Uint64 fenceWaitNS;
+  // Most bytes a frame took from the FrameArena.
+  Uint64 arenaBytes;
+  // Heap allocations while the measured frames were built and uploaded, all
+  // of them together. Should be 0.
+  Uint64 allocations;
+  // The part of uploadNS spent sorting.
+  Uint64 sortNS;
+  // The same frame as an opaque pass front to back and a translucent pass
+  // back to front (see SpriteDepth): the sprites in the opaque pass, both
+  // batches' upload and sort times, and the fence wait.
+  Uint32 opaque;
+  Uint64 depthUploadNS;
+  Uint64 depthSortNS;
+  Uint64 depthFenceWaitNS;
+  // Fragments that passed the depth test in one frame, which is what a GPU
+  // with early-Z shades. Without a depth test that's every covered pixel of
+  // every sprite.
+  Uint64 fragments;
+  Uint64 depthFragments;
+};
+
+// The pipelines of both ways of drawing a frame. None has no depth target;
+// opaque and translucent render into one, see SpriteDepth.
+struct FramePipelines {
+  SDL_GPUGraphicsPipeline *none;
+  SDL_GPUGraphicsPipeline *opaque;
+  SDL_GPUGraphicsPipeline *translucent;
+};
+
+struct UniformBlock {
+  float viewProjectionMatrix[16];
+};
+
+static void createSprites(Uint32 count, std::vector<SpriteData> &sprites,
+                          std::vector<Uint64> &keys) {
+  sprites.resize(count);
+  keys.resize(count);
+  for (Uint32 i = 0; i < count; i++) {
+    SpriteData &sprite = sprites[i];
+    float size = 4.0f + SDL_randf() * 12.0f;
+    sprite = {};
+    sprite.x = SDL_randf() * TARGET_WIDTH;
+    sprite.y = SDL_randf() * TARGET_HEIGHT;
+    sprite.z = SDL_randf();
+    sprite.rotation = SDL_randf() * 2.0f * SDL_PI_F;
+    sprite.w = size;
+    sprite.h = size;
+    sprite.texW = 1.0f;
+    sprite.texH = 1.0f;
+    sprite.r = SDL_randf();
+    sprite.g = SDL_randf();
+    sprite.b = SDL_randf();
+    // A quarter of them translucent, for the depth tested passes: solid
+    // tiles with effects on top.
+    sprite.a = SDL_rand(4) == 0 ? 0.5f : 1.0f;
+    // Two layers, like the demo scene, so the sort has work to do.
+    keys[i] = makeBatchKey((Uint8)SDL_rand(2), 0, 0, sprite.z);
+  }
+}
+
+// Uploads the sprites into a GPUCullBatch once, then submits only its cull
+// passes every frame. Also checks that the GPU kept as many sprites as the
+// CPU did.
+static bool measureGPUCull(SDL_GPUDevice *device, FrameLoop &frameLoop,
+                           const std::vector<SpriteData> &sprites,
+                           const float viewProjection[16], int frames,
+                           SweepResult &result) {
+  GPUCullBatch batch;
+  GPUCullBatchSettings settings;
+  settings.capacity = (Uint32)sprites.size();
+  if (!batch.init(device, settings)) {
+    return false;
+  }
+
+  std::vector<Uint64> samples;
+  bool ok = true;
+  for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+    SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+    if (!commandBuffer) {
+      ok = false;
+      break;
+    }
+    if (frame == 0 && !batch.upload(commandBuffer, 0, sprites.data(),
+                                    (Uint32)sprites.size())) {
+      frameLoop.cancel(commandBuffer);
+      ok = false;
+      break;
+    }
+    batch.cull(commandBuffer, viewProjection, (float)TARGET_WIDTH,
+               (float)TARGET_HEIGHT);
+    if (!frameLoop.submit(commandBuffer)) {
+      ok = false;
+      break;
+    }
+    // The first measured wait is for the last warmup frame, which has no
+    // upload in it either.
+    if (frame >= WARMUP_FRAMES) {
+      samples.push_back(frameLoop.stats().fenceWaitNS);
+    }
+  }
+
+  SDL_GPUIndirectDrawCommand command{};
+  if (ok) {
+    SDL_WaitForGPUIdle(device);
+    ok = downloadBuffer(device, batch.indirectBuffer(), 0, sizeof(command),
+                        &command);
+  }
+  if (ok && command.num_vertices != result.kept * 6) {
+    SDL_Log("GPU culling kept %u sprites, the CPU kept %u",
+            command.num_vertices / 6, result.kept);
+    ok = false;
+  }
+  batch.release();
+  if (ok) {
+    result.gpuCullNS = median(samples);
+  }
+  return ok;
+}
+
+// With the depth tested passes, opaque sprites go into their own batch with
+// coarse front to back keys, the rest stay back to front. Both get the layer
+// folded into z.
+static void drawDepthPasses(const std::vector<SpriteData> &sprites,
+                            const std::vector<Uint64> &keys,
+                            SpriteBatch &opaqueBatch,
+                            SpriteBatch &translucentBatch) {
+  for (size_t i = 0; i < sprites.size(); i++) {
+    SpriteData sprite = sprites[i];
+    Uint8 layer = (Uint8)(keys[i] >> 56);
+    sprite.z = layeredDepth(layer, sprite.z, 2);
+    if (sprite.a == 1.0f) {
+      opaqueBatch.draw(sprite, makeOpaqueBatchKey(0, 0, sprite.z));
+    } else {
+      translucentBatch.draw(sprite, makeBatchKey(layer, 0, 0, sprite.z));
+    }
+  }
+}
+
+// Uploads both batches and renders them into target, opaque first. Without
+// an opaque batch it's the plain back to front frame, with no depth target.
+static bool recordFrame(SDL_GPUCommandBuffer *commandBuffer,
+                        SpriteBatch *opaqueBatch, SpriteBatch &batch,
+                        SDL_GPUTexture *target, SDL_GPUTexture *depthTarget,
+                        const float viewProjection[16]) {
+  if ((opaqueBatch && !opaqueBatch->upload(commandBuffer)) ||
+      !batch.upload(commandBuffer)) {
+    return false;
+  }
+  SDL_GPUColorTargetInfo colorTargetInfo{};
+  colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+  colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+  colorTargetInfo.texture = target;
+  SDL_GPUDepthStencilTargetInfo depthTargetInfo{};
+  depthTargetInfo.texture = depthTarget;
+  depthTargetInfo.clear_depth = 1.0f;
+  depthTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+  depthTargetInfo.store_op = SDL_GPU_STOREOP_DONT_CARE;
+  depthTargetInfo.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+  depthTargetInfo.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+  depthTargetInfo.cycle = true;
+  SDL_GPURenderPass *renderPass = SDL_BeginGPURenderPass(
+      commandBuffer, &colorTargetInfo, 1,
+      opaqueBatch ? &depthTargetInfo : NULL);
+  SDL_PushGPUVertexUniformData(commandBuffer, 0, viewProjection,
+                               sizeof(float) * 16);
+  if (opaqueBatch) {
+    opaqueBatch->render(renderPass);
+  }
+  batch.render(renderPass);
+  SDL_EndGPURenderPass(renderPass);
+  return true;
+}
+
+// A batch for the sweep's measurements, culling against the full target.
+static bool initBatch(SDL_GPUDevice *device, Uint32 capacity,
+                      WorkerPool &workerPool, Uint32 framesInFlight,
+                      FrameArena &arena, SDL_GPUGraphicsPipeline *pipeline,
+                      const SDL_GPUTextureSamplerBinding &texture,
+                      const float viewProjection[16], SpriteBatch &batch) {
+  SpriteBatchSettings settings;
+  settings.capacity = capacity;
+  settings.workerPool = &workerPool;
+  settings.framesInFlight = framesInFlight;
+  settings.arena = &arena;
+  if (!batch.init(device, settings)) {
+    return false;
+  }
+  batch.addPipeline(pipeline);
+  batch.addTexture(texture);
+  batch.setView(viewProjection, (float)TARGET_WIDTH, (float)TARGET_HEIGHT);
+  return true;
+}
+
+// Draws the sprites with the opaque and translucent passes, like the plain
+// batch in main's sweep.
+static bool measureDepthPasses(SDL_GPUDevice *device, FrameLoop &frameLoop,
+                               WorkerPool &workerPool,
+                               const FramePipelines &pipelines,
+                               const SDL_GPUTextureSamplerBinding &texture,
+                               SDL_GPUTexture *target,
+                               const std::vector<SpriteData> &sprites,
+                               const std::vector<Uint64> &keys,
+                               const float viewProjection[16], int frames,
+                               SweepResult &result) {
+  Uint32 count = (Uint32)sprites.size();
+  SDL_GPUTexture *depthTarget =
+      createSpriteDepthTexture(device, TARGET_WIDTH, TARGET_HEIGHT);
+  FrameArena arena;
+  SpriteBatch opaqueBatch, translucentBatch;
+  bool ok = depthTarget && arena.init((Uint64)count * 32) &&
+            initBatch(device, count, workerPool, frameLoop.framesInFlight(),
+                      arena, pipelines.opaque, texture, viewProjection,
+                      opaqueBatch) &&
+            initBatch(device, count, workerPool, frameLoop.framesInFlight(),
+                      arena, pipelines.translucent, texture, viewProjection,
+                      translucentBatch);
+
+  std::vector<Uint64> uploadSamples, sortSamples, fenceSamples;
+  for (int frame = 0; ok && frame < WARMUP_FRAMES + frames; frame++) {
+    SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+    if (!commandBuffer) {
+      ok = false;
+      break;
+    }
+    arena.reset();
+    opaqueBatch.begin(frameLoop.frameSlot());
+    translucentBatch.begin(frameLoop.frameSlot());
+    drawDepthPasses(sprites, keys, opaqueBatch, translucentBatch);
+    if (!recordFrame(commandBuffer, &opaqueBatch, translucentBatch, target,
+                     depthTarget, viewProjection)) {
+      SDL_CancelGPUCommandBuffer(commandBuffer);
+      ok = false;
+      break;
+    }
+    if (!frameLoop.submit(commandBuffer)) {
+      ok = false;
+      break;
+    }
+    if (frame >= WARMUP_FRAMES) {
+      const SpriteBatchStats &opaqueStats = opaqueBatch.stats();
+      const SpriteBatchStats &translucentStats = translucentBatch.stats();
+      result.opaque = opaqueStats.kept;
+      uploadSamples.push_back(opaqueStats.uploadNS + translucentStats.uploadNS);
+      sortSamples.push_back(opaqueStats.sortNS + translucentStats.sortNS);
+      fenceSamples.push_back(frameLoop.stats().fenceWaitNS);
+    }
+  }
+  SDL_WaitForGPUIdle(device);
+  opaqueBatch.release();
+  translucentBatch.release();
+  SDL_ReleaseGPUTexture(device, depthTarget);
+  if (ok) {
+    result.depthUploadNS = median(uploadSamples);
+    result.depthSortNS = median(sortSamples);
+    result.depthFenceWaitNS = median(fenceSamples);
+  }
+  return ok;
+}
+
+// Renders one frame with fragment counting pipelines into an R16_FLOAT
+// target, reads it back and adds up the fragments. With depth, the opaque
+// and translucent passes, otherwise the plain back to front batch.
+static bool countFragments(SDL_GPUDevice *device, WorkerPool &workerPool,
+                           const FramePipelines &countPipelines, bool depth,
+                           const SDL_GPUTextureSamplerBinding &texture,
+                           const std::vector<SpriteData> &sprites,
+                           const std::vector<Uint64> &keys,
+                           const float viewProjection[16], Uint64 &fragments) {
+  Uint32 count = (Uint32)sprites.size();
+  SDL_GPUTextureCreateInfo targetInfo{};
+  targetInfo.type = SDL_GPU_TEXTURETYPE_2D;
+  targetInfo.format = SDL_GPU_TEXTUREFORMAT_R16_FLOAT;
+  targetInfo.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+  targetInfo.width = TARGET_WIDTH;
+  targetInfo.height = TARGET_HEIGHT;
+  targetInfo.layer_count_or_depth = 1;
+  targetInfo.num_levels = 1;
+  SDL_GPUTexture *target = SDL_CreateGPUTexture(device, &targetInfo);
+  SDL_GPUTexture *depthTarget =
+      depth ? createSpriteDepthTexture(device, TARGET_WIDTH, TARGET_HEIGHT)
+            : NULL;
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = TARGET_WIDTH * TARGET_HEIGHT * 2;
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+  SDL_GPUTransferBuffer *transferBuffer =
+      SDL_CreateGPUTransferBuffer(device, &transferInfo);
+
+  FrameArena arena;
+  SpriteBatch opaqueBatch, batch;
+  bool ok = target && (!depth || depthTarget) && transferBuffer &&
+            arena.init((Uint64)count * 32) &&
+            initBatch(device, count, workerPool, 0, arena,
+                      depth ? countPipelines.translucent : countPipelines.none,
+                      texture, viewProjection, batch) &&
+            (!depth || initBatch(device, count, workerPool, 0, arena,
+                                 countPipelines.opaque, texture,
+                                 viewProjection, opaqueBatch));
+  if (!ok) {
+    SDL_Log("Failed to set up fragment counting: %s", SDL_GetError());
+  }
+
+  if (ok) {
+    batch.begin();
+    if (depth) {
+      opaqueBatch.begin();
+      drawDepthPasses(sprites, keys, opaqueBatch, batch);
+    } else {
+      for (Uint32 i = 0; i < count; i++) {
+        batch.draw(sprites[i], keys[i]);
+      }
+    }
+    SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    ok = recordFrame(commandBuffer, depth ? &opaqueBatch : nullptr, batch,
+                     target, depthTarget, viewProjection);
+    if (ok) {
+      SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+      SDL_GPUTextureRegion source{};
+      source.texture = target;
+      source.w = TARGET_WIDTH;
+      source.h = TARGET_HEIGHT;
+      source.d = 1;
+      SDL_GPUTextureTransferInfo destination{};
+      destination.transfer_buffer = transferBuffer;
+      SDL_DownloadFromGPUTexture(copyPass, &source, &destination);
+      SDL_EndGPUCopyPass(copyPass);
+      SDL_GPUFence *fence =
+          SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+      ok = fence && SDL_WaitForGPUFences(device, true, &fence, 1);
+      SDL_ReleaseGPUFence(device, fence);
+    } else {
+      SDL_CancelGPUCommandBuffer(commandBuffer);
+    }
+  }
+  if (ok) {
+    const Uint16 *texels =
+        (const Uint16 *)SDL_MapGPUTransferBuffer(device, transferBuffer, false);
+    fragments = 0;
+    // halfToFloat from the compact layout's packing.
+    for (Uint32 i = 0; i < TARGET_WIDTH * TARGET_HEIGHT; i++) {
+      fragments += (Uint64)halfToFloat(texels[i]);
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+  }
+
+  batch.release();
+  if (depth) {
+    opaqueBatch.release();
+  }
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  SDL_ReleaseGPUTexture(device, depthTarget);
+  SDL_ReleaseGPUTexture(device, target);
+  return ok;
+}
+
+static bool writeCSV(const char *path, const std::vector<SweepResult> &results) {
+  SDL_IOStream *file = SDL_IOFromFile(path, "w");
+  if (!file) {
+    SDL_Log("Failed to open %s: %s", path, SDL_GetError());
+    return false;
+  }
+  SDL_IOprintf(file, "sprites,kept,draw_calls,bytes_uploaded,build_ms,"
+                     "upload_ms,cpu_cull_ms,gpu_cull_ms,fence_wait_ms,"
+                     "arena_bytes,allocations,sort_ms,opaque,depth_upload_ms,"
+                     "depth_sort_ms,depth_fence_wait_ms,fragments,"
+                     "depth_fragments\n");
+  for (const SweepResult &result : results) {
+    SDL_IOprintf(file,
+                 "%u,%u,%u,%" SDL_PRIu64 ",%.4f,%.4f,%.4f,%.4f,%.4f,"
+                 "%" SDL_PRIu64 ",%" SDL_PRIu64 ",%.4f,%u,%.4f,%.4f,%.4f,"
+                 "%" SDL_PRIu64 ",%" SDL_PRIu64 "\n",
+                 result.sprites, result.kept, result.drawCalls,
+                 result.bytesUploaded, result.buildNS / 1e6,
+                 result.uploadNS / 1e6, result.cullNS / 1e6,
+                 result.gpuCullNS / 1e6, result.fenceWaitNS / 1e6,
+                 result.arenaBytes, result.allocations, result.sortNS / 1e6,
+                 result.opaque, result.depthUploadNS / 1e6,
+                 result.depthSortNS / 1e6, result.depthFenceWaitNS / 1e6,
+                 result.fragments, result.depthFragments);
+  }
+  return SDL_CloseIO(file);
+}
+
+static bool writeJSON(const char *path, const char *driver,
+                      Uint32 framesInFlight,
+                      const std::vector<SweepResult> &results) {
+  SDL_IOStream *file = SDL_IOFromFile(path, "w");
+  if (!file) {
+    SDL_Log("Failed to open %s: %s", path, SDL_GetError());
+    return false;
+  }
+  SDL_IOprintf(file,
+               "{\n  \"driver\": \"%s\",\n  \"width\": %u,\n"
+               "  \"height\": %u,\n  \"frames_in_flight\": %u,\n"
+               "  \"results\": [\n",
+               driver, TARGET_WIDTH, TARGET_HEIGHT, framesInFlight);
+  for (size_t i = 0; i < results.size(); i++) {
+    const SweepResult &result = results[i];
+    SDL_IOprintf(file,
+                 "    {\"sprites\": %u, \"kept\": %u, \"draw_calls\": %u, "
+                 "\"bytes_uploaded\": %" SDL_PRIu64 ", \"build_ms\": %.4f, "
+                 "\"upload_ms\": %.4f, \"cpu_cull_ms\": %.4f, "
+                 "\"gpu_cull_ms\": %.4f, \"fence_wait_ms\": %.4f, "
+                 "\"arena_bytes\": %" SDL_PRIu64 ", \"allocations\": %" SDL_PRIu64
+                 ", \"sort_ms\": %.4f, \"opaque\": %u, "
+                 "\"depth_upload_ms\": %.4f, \"depth_sort_ms\": %.4f, "
+                 "\"depth_fence_wait_ms\": %.4f, \"fragments\": %" SDL_PRIu64
+                 ", \"depth_fragments\": %" SDL_PRIu64 "}%s\n",
+                 result.sprites, result.kept, result.drawCalls,
+                 result.bytesUploaded, result.buildNS / 1e6,
+                 result.uploadNS / 1e6, result.cullNS / 1e6,
+                 result.gpuCullNS / 1e6, result.fenceWaitNS / 1e6,
+                 result.arenaBytes, result.allocations, result.sortNS / 1e6,
+                 result.opaque, result.depthUploadNS / 1e6,
+                 result.depthSortNS / 1e6, result.depthFenceWaitNS / 1e6,
+                 result.fragments, result.depthFragments,
+                 i + 1 < results.size() ? "," : "");
+  }
+  SDL_IOprintf(file, "  ]\n}\n");
+  return SDL_CloseIO(file);
+}
+
+int main(int argc, char **argv) {
+  installAllocationCounter();
+  Uint32 maxSprites = 2000000;
+  int frames = 20;
+  FrameLoopSettings frameLoopSettings;
+  frameLoopSettings.framesInFlight = 1;
+  const char *csvPath = "SpriteBatcherBench.csv";
+  const char *jsonPath = "SpriteBatcherBench.json";
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--max") == 0) {
+      maxSprites = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    } else if (SDL_strcmp(argv[i], "--frames-in-flight") == 0) {
+      frameLoopSettings.framesInFlight = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--csv") == 0) {
+      csvPath = argv[i + 1];
+    } else if (SDL_strcmp(argv[i], "--json") == 0) {
+      jsonPath = argv[i + 1];
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  const char *driver = SDL_GetGPUDeviceDriver(device);
+  FrameLoop frameLoop;
+  if (!frameLoop.init(device, frameLoopSettings)) {
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUGraphicsPipeline *pipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140);
+  FramePipelines depthPipelines;
+  depthPipelines.none = pipeline;
+  depthPipelines.opaque = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140,
+      SpriteTexturing::Array, SpriteGeometry::VertexPulling,
+      SpriteDepth::Opaque);
+  depthPipelines.translucent = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140,
+      SpriteTexturing::Array, SpriteGeometry::VertexPulling,
+      SpriteDepth::Translucent);
+  FramePipelines countPipelines;
+  countPipelines.none = createFragmentCountPipeline(device, SpriteDepth::None);
+  countPipelines.opaque =
+      createFragmentCountPipeline(device, SpriteDepth::Opaque);
+  countPipelines.translucent =
+      createFragmentCountPipeline(device, SpriteDepth::Translucent);
+  SDL_GPUTexture *texture = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  if (!target || !pipeline || !depthPipelines.opaque ||
+      !depthPipelines.translucent || !countPipelines.none ||
+      !countPipelines.opaque || !countPipelines.translucent || !texture ||
+      !sampler) {
+    SDL_Log("Failed to create GPU resources: %s", SDL_GetError());
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+
+  WorkerPool workerPool;
+  int threadCount = SDL_GetNumLogicalCPUCores();
+  workerPool.init(threadCount > 1 ? (Uint32)threadCount - 1 : 0);
+
+  UniformBlock uniforms;
+  orthographic(0.0f, (float)TARGET_WIDTH, (float)TARGET_HEIGHT, 0.0f, 0.0f,
+               -1.0f, uniforms.viewProjectionMatrix);
+
+  SDL_Log("%s driver, %d threads, %dx%d target, %d frames per count, %u in "
+          "flight",
+          driver, threadCount, TARGET_WIDTH, TARGET_HEIGHT, frames,
+          frameLoop.framesInFlight());
+
+  std::vector<SweepResult> results;
+  std::vector<SpriteData> sprites;
+  std::vector<Uint64> keys;
+  std::vector<Uint64> buildSamples, uploadSamples, cullSamples, sortSamples,
+      fenceSamples;
+  bool ok = true;
+  for (Uint32 count : SPRITE_COUNTS) {
+    if (count > maxSprites) {
+      break;
+    }
+    createSprites(count, sprites, keys);
+
+    // A fresh batch per count, sized for it, so no frame pays for growing
+    // the buffers.
+    FrameArena arena;
+    SpriteBatch batch;
+    SpriteBatchSettings settings;
+    settings.capacity = count;
+    settings.workerPool = &workerPool;
+    settings.framesInFlight = frameLoop.framesInFlight();
+    settings.arena = &arena;
+    if (!arena.init((Uint64)count * 32) || !batch.init(device, settings)) {
+      ok = false;
+      break;
+    }
+    batch.addPipeline(pipeline);
+    batch.addTexture({texture, sampler});
+    batch.setView(uniforms.viewProjectionMatrix, (float)TARGET_WIDTH,
+                  (float)TARGET_HEIGHT);
+
+    buildSamples.clear();
+    uploadSamples.clear();
+    cullSamples.clear();
+    sortSamples.clear();
+    fenceSamples.clear();
+    SweepResult result{};
+    result.sprites = count;
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+      SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+      if (!commandBuffer) {
+        ok = false;
+        break;
+      }
+
+      Uint64 allocationsAtStart = allocationCount();
+      Uint64 buildStart = SDL_GetTicksNS();
+      arena.reset();
+      batch.begin(frameLoop.frameSlot());
+      for (Uint32 i = 0; i < count; i++) {
+        batch.draw(sprites[i], keys[i]);
+      }
+      Uint64 buildNS = SDL_GetTicksNS() - buildStart;
+
+      if (!batch.upload(commandBuffer)) {
+        SDL_CancelGPUCommandBuffer(commandBuffer);
+        ok = false;
+        break;
+      }
+      Uint64 allocations = allocationCount() - allocationsAtStart;
+
+      SDL_GPUColorTargetInfo colorTargetInfo{};
+      colorTargetInfo.clear_color = {60 / 255.0f, 60 / 255.0f, 60 / 255.0f,
+                                     255 / 255.0f};
+      colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+      colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+      colorTargetInfo.texture = target;
+      SDL_GPURenderPass *renderPass =
+          SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+      SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms,
+                                   sizeof(UniformBlock));
+      batch.render(renderPass);
+      SDL_EndGPURenderPass(renderPass);
+
+      if (!frameLoop.submit(commandBuffer)) {
+        ok = false;
+        break;
+      }
+
+      if (frame < WARMUP_FRAMES) {
+        continue;
+      }
+      const SpriteBatchStats &stats = batch.stats();
+      result.kept = stats.kept;
+      result.drawCalls = stats.drawCalls;
+      result.bytesUploaded = stats.bytesUploaded;
+      buildSamples.push_back(buildNS);
+      uploadSamples.push_back(stats.uploadNS);
+      cullSamples.push_back(stats.cullNS);
+      sortSamples.push_back(stats.sortNS);
+      fenceSamples.push_back(frameLoop.stats().fenceWaitNS);
+      result.allocations += allocations;
+    }
+    result.arenaBytes = arena.peakBytes();
+    batch.release();
+    if (!ok) {
+      break;
+    }
+
+    result.buildNS = median(buildSamples);
+    result.uploadNS = median(uploadSamples);
+    result.cullNS = median(cullSamples);
+    result.sortNS = median(sortSamples);
+    result.fenceWaitNS = median(fenceSamples);
+    SDL_GPUTextureSamplerBinding binding = {texture, sampler};
+    if (!measureGPUCull(device, frameLoop, sprites,
+                        uniforms.viewProjectionMatrix, frames, result) ||
+        !measureDepthPasses(device, frameLoop, workerPool, depthPipelines,
+                            binding, target, sprites, keys,
+                            uniforms.viewProjectionMatrix, frames, result) ||
+        !countFragments(device, workerPool, countPipelines, false, binding,
+                        sprites, keys, uniforms.viewProjectionMatrix,
+                        result.fragments) ||
+        !countFragments(device, workerPool, countPipelines, true, binding,
+                        sprites, keys, uniforms.viewProjectionMatrix,
+                        result.depthFragments)) {
+      ok = false;
+      break;
+    }
+    results.push_back(result);
+    SDL_Log("%8u sprites  build %8.3f ms  upload %8.3f ms  fence wait %8.3f "
+            "ms  %u draws  cull: CPU %8.3f ms, GPU %8.3f ms  arena %8.1f KB  "
+            "%" SDL_PRIu64 " allocations",
+            count, result.buildNS / 1e6, result.uploadNS / 1e6,
+            result.fenceWaitNS / 1e6, result.drawCalls, result.cullNS / 1e6,
+            result.gpuCullNS / 1e6, result.arenaBytes / 1024.0,
+            result.allocations);
+    SDL_Log("          depth passes: %u opaque  sort %8.3f ms (back to front "
+            "%8.3f ms)  fence wait %8.3f ms  fragments %" SDL_PRIu64
+            " (back to front %" SDL_PRIu64 ", %.0f%% fewer)",
+            result.opaque, result.depthSortNS / 1e6, result.sortNS / 1e6,
+            result.depthFenceWaitNS / 1e6, result.depthFragments,
+            result.fragments,
+            result.fragments > 0
+                ? 100.0 - result.depthFragments * 100.0 / result.fragments
+                : 0.0);
+    if (result.allocations > 0) {
+      SDL_Log("Steady frames allocated on the heap");
+      ok = false;
+      break;
+    }
+  }
+
+  if (ok) {
+    ok = writeCSV(csvPath, results) &&
+         writeJSON(jsonPath, driver, frameLoop.framesInFlight(), results);
+  }
+  if (ok) {
+    SDL_Log("Wrote %s and %s", csvPath, jsonPath);
+  }
+
+  frameLoop.release();
+  workerPool.shutdown();
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+  SDL_ReleaseGPUGraphicsPipeline(device, depthPipelines.opaque);
+  SDL_ReleaseGPUGraphicsPipeline(device, depthPipelines.translucent);
+  SDL_ReleaseGPUGraphicsPipeline(device, countPipelines.none);
+  SDL_ReleaseGPUGraphicsPipeline(device, countPipelines.opaque);
+  SDL_ReleaseGPUGraphicsPipeline(device, countPipelines.translucent);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+// Draws thousands of debug labels into a SpriteBatch with TextRenderer, with
+// none, a tenth or all of them changing their text every frame, and reports
+// the CPU time per frame, the run cache's hit rate and how much of the atlas
+// the glyphs take. For comparison, the same labels laid out and rasterized
+// glyph by glyph every frame, which is what the caches save.
+//
+// Then it draws a sprite from the atlas next to the labels, on the same
+// layer, and checks that it all took a single draw call: text is just
+// sprites on the atlas texture. More than one makes the exit code nonzero.
+//
+//   ./TextBench [--labels n] [--frames n] [--size px]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "BatchKey.hpp"
+#include "BitmapFont.hpp"
+#include "HeadlessGPU.hpp"
+#include "SpriteBatch.hpp"
+#include "SpritePipeline.hpp"
+#include "TextRenderer.hpp"
+#include "TextureAtlas.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 1920;
+static const Uint32 TARGET_HEIGHT = 1080;
+static const int WARMUP_FRAMES = 3;
+static const float CHANGING[] = {0.0f, 0.1f, 1.0f};
+
+// What main.cpp's --labels shows, with a counter in the labels that change.
+static void labelText(Uint32 label, Uint32 changing, int frame, char *text,
+                      size_t size) {
+  if (label < changing) {
+    SDL_snprintf(text, size, "#%u\nframe %d", label, frame);
+  } else {
+    SDL_snprintf(text, size, "#%u\nimage %u", label, label % 64);
+  }
+}
+
+// Without either cache: every glyph of every label rasterized again, and
+// drawn with the white texel instead of an atlas region.
+static void drawUncached(SpriteBatch &batch, const char *text, float x,
+                         float y, Uint32 size, std::vector<Uint8> &pixels) {
+  const BitmapFont &font = builtinFont();
+  GlyphLayout layout = glyphLayout(font, size);
+  float penX = 0.0f, penY = 0.0f;
+  for (const char *c = text; *c; c++) {
+    if (*c == '\n') {
+      penX = 0.0f;
+      penY += layout.lineHeight;
+      continue;
+    }
+    if (rasterizeGlyph(font, (Uint8)*c, size, pixels)) {
+      SpriteData sprite{};
+      sprite.x = x + penX;
+      sprite.y = y + penY;
+      sprite.w = (float)layout.width;
+      sprite.h = (float)layout.height;
+      sprite.texW = sprite.texH = 1.0f;
+      sprite.r = sprite.g = sprite.b = sprite.a = 1.0f;
+      batch.draw(sprite, makeBatchKey(0, 0, 0, 0.0f));
+    }
+    penX += layout.advance;
+  }
+}
+
+int main(int argc, char **argv) {
+  Uint32 labelCount = 10000;
+  int frames = 60;
+  Uint16 size = 14;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--labels") == 0) {
+      labelCount = SDL_max((Uint32)SDL_atoi(argv[i + 1]), 1u);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    } else if (SDL_strcmp(argv[i], "--size") == 0) {
+      size = (Uint16)SDL_clamp(SDL_atoi(argv[i + 1]), 4, 256);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUGraphicsPipeline *pipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140);
+  SDL_GPUTexture *white = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+
+  TextureAtlas atlas;
+  SpriteBatch batch;
+  SpriteBatchSettings batchSettings;
+  batchSettings.capacity = labelCount * 16;
+  batchSettings.cull = false;
+  bool ok = target && pipeline && white && sampler &&
+            atlas.init(device, TextureAtlasSettings{}) &&
+            batch.init(device, batchSettings);
+  if (!ok) {
+    SDL_Log("Failed to create the benchmark's resources: %s", SDL_GetError());
+  }
+  Uint8 pipelineId = batch.addPipeline(pipeline);
+  // Texture 0 is the white texel for the uncached labels, 1 the atlas. With
+  // the texture array every page is the same binding.
+  batch.addTexture({white, sampler});
+  static Uint16 atlasTexture;
+  atlasTexture = batch.addTexture({atlas.pageTexture(0), sampler});
+
+  TextRenderer text;
+  TextRendererSettings textSettings;
+  textSettings.atlas = &atlas;
+  textSettings.pageTexture = [](Uint32, void *) { return atlasTexture; };
+  ok = ok && text.init(textSettings);
+  TextStyle style;
+  style.font = text.addFont(builtinFont());
+  style.size = size;
+  style.pipeline = pipelineId;
+
+  SDL_Log("%s driver, %u labels of %u px, %d frames per run",
+          SDL_GetGPUDeviceDriver(device), labelCount, size, frames);
+
+  // Labels on a grid, wherever they fall; nothing is culled.
+  GlyphLayout layout = glyphLayout(builtinFont(), size);
+  Uint32 columns = SDL_max(TARGET_WIDTH / (layout.advance * 12), 1u);
+  char buffer[32];
+  std::vector<Uint8> pixels;
+  std::vector<Uint64> samples;
+  for (float changingFraction : CHANGING) {
+    if (!ok) {
+      break;
+    }
+    Uint32 changing = (Uint32)(labelCount * changingFraction);
+    for (int uncached = 0; uncached < 2; uncached++) {
+      samples.clear();
+      Uint64 hits = 0, draws = 0, quads = 0, evicted = 0;
+      for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+        batch.begin();
+        Uint64 start = SDL_GetTicksNS();
+        if (!uncached) {
+          text.beginFrame();
+        }
+        for (Uint32 label = 0; label < labelCount; label++) {
+          labelText(label, changing, frame, buffer, sizeof(buffer));
+          float x = (float)(label % columns * layout.advance * 12);
+          float y = (float)(label / columns % 40 * layout.lineHeight * 2);
+          if (uncached) {
+            drawUncached(batch, buffer, x, y, size, pixels);
+          } else {
+            text.draw(batch, style, buffer, x, y);
+          }
+        }
+        Uint64 cpuNS = SDL_GetTicksNS() - start;
+        if (frame >= WARMUP_FRAMES) {
+          samples.push_back(cpuNS);
+          const TextStats &stats = text.stats();
+          hits += stats.runHits;
+          draws += stats.runHits + stats.runMisses;
+          quads += stats.quads;
+          evicted += stats.evictedRuns;
+        }
+      }
+      if (uncached) {
+        SDL_Log("%5.1f%% changing, uncached:  CPU %7.3f ms/frame",
+                changingFraction * 100.0f, median(samples) / 1e6);
+      } else {
+        const TextStats &stats = text.stats();
+        SDL_Log("%5.1f%% changing, cached:    CPU %7.3f ms/frame  %5.1f%% "
+                "hits  %6.0f quads  %5u runs  %6.0f evicted/frame  %u glyphs "
+                "(%" SDL_PRIu64 " texels, atlas %.2f%% full)",
+                changingFraction * 100.0f, median(samples) / 1e6,
+                draws ? hits * 100.0 / draws : 0.0, (double)quads / frames,
+                stats.cachedRuns, (double)evicted / frames,
+                stats.cachedGlyphs, stats.glyphTexels,
+                stats.atlasOccupancy * 100.0f);
+      }
+    }
+  }
+
+  // A sprite showing an atlas image, on the layer the labels are on.
+  std::vector<Uint8> image(32 * 32 * 4, 255);
+  int imageId = atlas.insert(image.data(), 32, 32);
+  if (ok && imageId < 0) {
+    SDL_Log("The atlas has no room for the sprite");
+    ok = false;
+  }
+  if (ok) {
+    const AtlasRegion &region = atlas.region(imageId);
+    SpriteData sprite{};
+    sprite.x = sprite.y = 64.0f;
+    sprite.w = sprite.h = 32.0f;
+    sprite.textureLayer = region.textureLayer;
+    sprite.texU = region.texU;
+    sprite.texV = region.texV;
+    sprite.texW = region.texW;
+    sprite.texH = region.texH;
+    sprite.r = sprite.g = sprite.b = sprite.a = 1.0f;
+
+    batch.begin();
+    text.beginFrame();
+    batch.draw(sprite, makeBatchKey(0, pipelineId, atlasTexture, 0.5f));
+    for (Uint32 label = 0; label < labelCount; label++) {
+      labelText(label, 0, 0, buffer, sizeof(buffer));
+      text.draw(batch, style, buffer, (float)(label % columns * 96),
+                (float)(label / columns % 40 * 24));
+    }
+
+    float viewProjection[16];
+    orthographic(0.0f, (float)TARGET_WIDTH, (float)TARGET_HEIGHT, 0.0f, 0.0f,
+                 -1.0f, viewProjection);
+    SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    ok = commandBuffer && atlas.upload(commandBuffer) &&
+         batch.upload(commandBuffer);
+    if (commandBuffer) {
+      SDL_GPUColorTargetInfo colorTargetInfo{};
+      colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+      colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+      colorTargetInfo.texture = target;
+      SDL_GPURenderPass *renderPass =
+          SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+      SDL_PushGPUVertexUniformData(commandBuffer, 0, viewProjection,
+                                   sizeof(viewProjection));
+      batch.render(renderPass);
+      SDL_EndGPURenderPass(renderPass);
+      ok = SDL_SubmitGPUCommandBuffer(commandBuffer) && ok;
+      SDL_WaitForGPUIdle(device);
+    }
+    Uint32 drawCalls = batch.stats().drawCalls;
+    SDL_Log("1 sprite and %u labels (%u quads) in %u draw call%s%s",
+            labelCount, text.stats().quads, drawCalls,
+            drawCalls == 1 ? "" : "s", drawCalls == 1 ? "" : "  FAILED");
+    ok = ok && drawCalls == 1;
+  }
+
+  text.release();
+  batch.release();
+  atlas.release();
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, white);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
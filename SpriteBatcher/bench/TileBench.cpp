@@ -0,0 +1,241 @@
+// Draws square tile maps from 256 x 256 to 4096 x 4096 tiles, a full ground
+// layer and a sparse detail layer on top, with a 1920 x 1080 view panning
+// diagonally across the map. Reports how long the map took to load and how
+// much of it lives on the GPU, then the CPU time to record a frame, its GPU
+// time, and the chunks and draws it took. The frame shouldn't get slower
+// as the map grows: only the chunks under the view are drawn, and nothing
+// is uploaded.
+//
+// Then it edits one tile and checks that exactly one chunk went up, and that
+// the chunk on the GPU matches the map. A mismatch makes the exit code
+// nonzero.
+//
+//   ./TileBench [--max-size n] [--frames n] [--zoom z]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Camera2D.hpp"
+#include "FrameLoop.hpp"
+#include "HeadlessGPU.hpp"
+#include "SpritePipeline.hpp"
+#include "TileMap.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 1920;
+static const Uint32 TARGET_HEIGHT = 1080;
+static const int WARMUP_FRAMES = 3;
+static const Uint32 MAP_SIZES[] = {256, 512, 1024, 2048, 4096};
+static const Uint16 GROUND_FRAMES = 8;
+static const Uint16 DETAIL_FRAMES = 4;
+
+// Ground everywhere, details on about one tile in twenty.
+static void fillMap(TileMap &map, Uint64 &seed) {
+  for (Uint32 y = 0; y < map.height(); y++) {
+    for (Uint32 x = 0; x < map.width(); x++) {
+      map.set(0, x, y, (Uint16)(1 + SDL_rand_r(&seed, GROUND_FRAMES)));
+      if (SDL_rand_r(&seed, 20) == 0) {
+        map.set(1, x, y,
+                (Uint16)(1 + GROUND_FRAMES + SDL_rand_r(&seed, DETAIL_FRAMES)));
+      }
+    }
+  }
+}
+
+// Reads the ground chunk holding tile (x, y) back and compares it with the
+// map.
+static bool checkChunk(SDL_GPUDevice *device, const TileMap &map, Uint32 x,
+                       Uint32 y) {
+  Uint32 chunksX = (map.width() + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+  Uint32 chunkX = x / TILE_CHUNK_SIZE, chunkY = y / TILE_CHUNK_SIZE;
+  std::vector<Uint16> gpuTiles(TILE_CHUNK_TILES);
+  if (!downloadBuffer(device, map.tileBuffer(),
+                      (chunkY * chunksX + chunkX) * TILE_CHUNK_BYTES,
+                      TILE_CHUNK_BYTES, gpuTiles.data())) {
+    return false;
+  }
+  for (Uint32 row = 0; row < TILE_CHUNK_SIZE; row++) {
+    for (Uint32 column = 0; column < TILE_CHUNK_SIZE; column++) {
+      Uint32 tileX = chunkX * TILE_CHUNK_SIZE + column;
+      Uint32 tileY = chunkY * TILE_CHUNK_SIZE + row;
+      if (tileX >= map.width() || tileY >= map.height()) {
+        continue;
+      }
+      if (gpuTiles[row * TILE_CHUNK_SIZE + column] !=
+          map.get(0, tileX, tileY)) {
+        SDL_Log("Tile (%u, %u) differs from the map", tileX, tileY);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  Uint32 maxSize = 4096;
+  int frames = 60;
+  float zoom = 1.0f;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--max-size") == 0) {
+      maxSize = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    } else if (SDL_strcmp(argv[i], "--zoom") == 0) {
+      zoom = SDL_max((float)SDL_atof(argv[i + 1]), 0.01f);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+  FrameLoop frameLoop;
+  FrameLoopSettings frameLoopSettings;
+  frameLoopSettings.framesInFlight = 1;
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUGraphicsPipeline *pipeline =
+      createTilePipeline(device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM);
+  SDL_GPUTexture *texture = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  if (!frameLoop.init(device, frameLoopSettings) || !target || !pipeline ||
+      !texture || !sampler) {
+    SDL_Log("Failed to create GPU resources: %s", SDL_GetError());
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+  SDL_GPUTextureSamplerBinding textureBinding{texture, sampler};
+
+  Camera2D camera;
+  camera.setViewport((float)TARGET_WIDTH, (float)TARGET_HEIGHT);
+  camera.setZoom(zoom);
+
+  SDL_Log("%s driver, %u x %u view at zoom %.2f, 2 layers of 16 px tiles, "
+          "%d frames per map",
+          SDL_GetGPUDeviceDriver(device), TARGET_WIDTH, TARGET_HEIGHT, zoom,
+          frames);
+
+  std::vector<Uint64> cpuSamples, gpuSamples;
+  bool ok = true;
+  for (Uint32 size : MAP_SIZES) {
+    if (size > maxSize) {
+      break;
+    }
+    TileMap map;
+    TileMapSettings mapSettings;
+    mapSettings.width = mapSettings.height = size;
+    mapSettings.layers = 2;
+    mapSettings.framesInFlight = frameLoop.framesInFlight();
+    if (!map.init(device, mapSettings)) {
+      ok = false;
+      break;
+    }
+    // Which texels they show doesn't matter here, only that they're there.
+    for (Uint16 i = 0; i < GROUND_FRAMES + DETAIL_FRAMES; i++) {
+      map.addFrame(0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
+    }
+    Uint64 seed = 1;
+    fillMap(map, seed);
+
+    // Loaded maxChunksPerUpload chunks at a time.
+    Uint64 loadStart = SDL_GetTicksNS();
+    while (ok && map.dirtyChunks() > 0) {
+      SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+      ok = commandBuffer && map.upload(commandBuffer, frameLoop.frameSlot());
+      ok = commandBuffer && frameLoop.submit(commandBuffer) && ok;
+    }
+    SDL_WaitForGPUIdle(device);
+    Uint64 loadNS = SDL_GetTicksNS() - loadStart;
+
+    float mapWorld = size * mapSettings.tileSize;
+    Uint64 visibleChunks = 0, drawCalls = 0, bytes = 0;
+    cpuSamples.clear();
+    gpuSamples.clear();
+    for (int frame = 0; ok && frame < WARMUP_FRAMES + frames; frame++) {
+      SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+      if (!commandBuffer) {
+        ok = false;
+        break;
+      }
+      float t = (frame + 0.5f) / (WARMUP_FRAMES + frames);
+      camera.setPosition(t * mapWorld, t * mapWorld);
+
+      Uint64 start = SDL_GetTicksNS();
+      ok = map.upload(commandBuffer, frameLoop.frameSlot());
+      SDL_GPUColorTargetInfo colorTargetInfo{};
+      colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+      colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+      colorTargetInfo.texture = target;
+      SDL_GPURenderPass *renderPass =
+          SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+      camera.pushUniform(commandBuffer);
+      map.render(commandBuffer, renderPass, pipeline, textureBinding,
+                 camera.viewBounds());
+      SDL_EndGPURenderPass(renderPass);
+      Uint64 cpuNS = SDL_GetTicksNS() - start;
+
+      if (!frameLoop.submit(commandBuffer) || !ok) {
+        ok = false;
+        break;
+      }
+      camera.submitted();
+      if (frame >= WARMUP_FRAMES) {
+        cpuSamples.push_back(cpuNS);
+        // The wait in begin() was for the previous frame.
+        gpuSamples.push_back(frameLoop.stats().fenceWaitNS);
+        visibleChunks += map.stats().visibleChunks;
+        drawCalls += map.stats().drawCalls;
+        bytes += map.stats().bytesUploaded;
+      }
+    }
+
+    // One edit, one chunk.
+    Uint32 editX = (Uint32)SDL_rand_r(&seed, (Sint32)size);
+    Uint32 editY = (Uint32)SDL_rand_r(&seed, (Sint32)size);
+    map.set(0, editX, editY, (Uint16)(1 + map.get(0, editX, editY) %
+                                              GROUND_FRAMES));
+    if (ok) {
+      SDL_GPUCommandBuffer *commandBuffer = frameLoop.begin();
+      ok = commandBuffer && map.upload(commandBuffer, frameLoop.frameSlot());
+      ok = commandBuffer && frameLoop.submit(commandBuffer) && ok;
+    }
+    if (ok && (map.stats().uploadedChunks != 1 ||
+               map.stats().bytesUploaded != TILE_CHUNK_BYTES)) {
+      SDL_Log("An edit uploaded %u chunks, %" SDL_PRIu64 " bytes",
+              map.stats().uploadedChunks, map.stats().bytesUploaded);
+      ok = false;
+    }
+    if (ok) {
+      SDL_WaitForGPUIdle(device);
+      ok = checkChunk(device, map, editX, editY);
+    }
+    Uint32 chunks = map.chunkCount();
+    map.release();
+    if (!ok) {
+      SDL_Log("%4u x %-4u  FAILED", size, size);
+      break;
+    }
+
+    SDL_Log("%4u x %-4u %6u chunks, %6.1f MB on the GPU, loaded in %8.3f ms "
+            "|  CPU %6.3f ms  GPU %7.3f ms  %5.1f chunks  %5.1f draws  "
+            "%" SDL_PRIu64 " bytes/frame",
+            size, size, chunks, (double)chunks * TILE_CHUNK_BYTES / (1024.0 * 1024.0),
+            loadNS / 1e6, median(cpuSamples) / 1e6, median(gpuSamples) / 1e6,
+            (double)visibleChunks / frames, (double)drawCalls / frames,
+            bytes / frames);
+  }
+
+  frameLoop.release();
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,332 @@
+// Draws large, mostly transparent sprites (particles and foliage) into a 4K
+// target three ways and times the GPU: every sprite as a full quad, every
+// sprite as its trimmed shape, and the automatic choice per sprite that the
+// sample makes (SpriteShapeTable::worthDrawing). Also checks that every
+// visible texel of every image is inside its shape, and exits nonzero if one
+// isn't.
+//
+// The sprites sample a single white texel, since what's measured is the
+// fill, and blending costs the same whatever the texture says.
+//
+//   VK_DRIVER_FILES=/path/to/lvp_icd.x86_64.json ./TrimBench [--sprites n]
+//       [--frames n]
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "BatchKey.hpp"
+#include "BenchUtil.hpp"
+#include "HeadlessGPU.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteShapes.hpp"
+
+#include <vector>
+
+static const Uint32 TARGET_WIDTH = 3840;
+static const Uint32 TARGET_HEIGHT = 2160;
+static const Uint32 IMAGE_SIZE = 128;
+static const float MIN_SPRITE_SIZE = 16.0f;
+static const float MAX_SPRITE_SIZE = 384.0f;
+
+enum class ImageKind { Particle, Leaf, Grass, Spark, Count };
+
+static const char *imageKindName(ImageKind kind) {
+  switch (kind) {
+  case ImageKind::Particle:
+    return "particle";
+  case ImageKind::Leaf:
+    return "leaf";
+  case ImageKind::Grass:
+    return "grass";
+  case ImageKind::Spark:
+    return "spark";
+  case ImageKind::Count:
+    break;
+  }
+  return "?";
+}
+
+// Alpha only; the color doesn't matter here. u and v go from -1 to 1.
+static float imageAlpha(ImageKind kind, float u, float v) {
+  switch (kind) {
+  case ImageKind::Particle: {
+    // The sample's soft disc.
+    float edge = 1.0f - SDL_sqrtf(u * u + v * v);
+    return SDL_clamp(edge * 4.0f, 0.0f, 1.0f);
+  }
+  case ImageKind::Leaf: {
+    // A thin ellipse along the diagonal.
+    float along = (u + v) * 0.7071f, across = (u - v) * 0.7071f;
+    float d = along * along / 0.9f + across * across / 0.04f;
+    return d <= 1.0f ? 1.0f : 0.0f;
+  }
+  case ImageKind::Grass: {
+    // A blade growing up from the bottom, narrowing to a tip.
+    float t = (v + 1.0f) * 0.5f;
+    return t > 0.2f && SDL_fabsf(u) < 0.3f * t ? 1.0f : 0.0f;
+  }
+  case ImageKind::Spark:
+    return u * u + v * v < 0.09f ? 1.0f : 0.0f;
+  case ImageKind::Count:
+    break;
+  }
+  return 0.0f;
+}
+
+static void generateImage(ImageKind kind, std::vector<Uint8> &pixels) {
+  pixels.assign(IMAGE_SIZE * IMAGE_SIZE * 4, 255);
+  for (Uint32 y = 0; y < IMAGE_SIZE; y++) {
+    for (Uint32 x = 0; x < IMAGE_SIZE; x++) {
+      float u = (x + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+      float v = (y + 0.5f) / IMAGE_SIZE * 2.0f - 1.0f;
+      pixels[(y * IMAGE_SIZE + x) * 4 + 3] =
+          (Uint8)(imageAlpha(kind, u, v) * 255.0f);
+    }
+  }
+}
+
+// Every corner of every visible texel has to be inside the shape (on the
+// same side of every edge), or the trimmed sprite would lose it.
+static bool shapeCovers(const SpriteShape &shape, Uint32 corners,
+                        const std::vector<Uint8> &pixels) {
+  for (Uint32 y = 0; y < IMAGE_SIZE; y++) {
+    for (Uint32 x = 0; x < IMAGE_SIZE; x++) {
+      if (pixels[(y * IMAGE_SIZE + x) * 4 + 3] == 0) {
+        continue;
+      }
+      for (Uint32 corner = 0; corner < 4; corner++) {
+        double px = (double)(x + (corner & 1)) / IMAGE_SIZE;
+        double py = (double)(y + (corner >> 1)) / IMAGE_SIZE;
+        int side = 0;
+        for (Uint32 i = 0; i < corners; i++) {
+          const float *a = shape.corners[i];
+          const float *b = shape.corners[(i + 1) % corners];
+          double c = (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+          if (SDL_fabs(c) < 1e-6) {
+            continue;
+          }
+          int edgeSide = c > 0.0 ? 1 : -1;
+          if (side != 0 && edgeSide != side) {
+            return false;
+          }
+          side = edgeSide;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+enum class TrimMode { Quads, Trimmed, Automatic };
+
+struct TrimResult {
+  Uint64 bestNS;
+  Uint32 trimmed;
+  // Pixels covered by what was drawn, quads or shapes, in millions.
+  double coveredMPixels;
+};
+
+struct BenchSprite {
+  SpriteData data;
+  Uint32 shape;
+};
+
+// Uploads the batch once and then renders it frame after frame, like
+// GeometryProbe does, so only the draw is timed.
+static bool timeMode(SDL_GPUDevice *device, SDL_GPUTexture *target,
+                     SpriteBatch &batch, Uint8 quadPipeline,
+                     Uint8 trimmedPipeline, SpriteShapeTable &shapes,
+                     const std::vector<BenchSprite> &sprites, TrimMode mode,
+                     int frames, TrimResult &result) {
+  result = {};
+  batch.begin();
+  for (const BenchSprite &sprite : sprites) {
+    float quadPixels = sprite.data.w * sprite.data.h;
+    bool trim = mode == TrimMode::Trimmed ||
+                (mode == TrimMode::Automatic &&
+                 shapes.worthDrawing(sprite.shape, quadPixels));
+    result.trimmed += trim ? 1 : 0;
+    result.coveredMPixels +=
+        quadPixels *
+        (trim ? 1.0 - shapes.savedFraction(sprite.shape) : 1.0) / 1e6;
+    batch.draw(sprite.data,
+               makeBatchKey(0, trim ? trimmedPipeline : quadPipeline, 0,
+                            sprite.data.z));
+  }
+
+  float viewProjection[16];
+  orthographic(0.0f, (float)TARGET_WIDTH, (float)TARGET_HEIGHT, 0.0f, 0.0f,
+               -1.0f, viewProjection);
+
+  result.bestNS = ~(Uint64)0;
+  bool ok = true;
+  for (int frame = 0; frame < 1 + frames && ok; frame++) {
+    SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (!commandBuffer) {
+      ok = false;
+      break;
+    }
+    if (frame == 0 &&
+        (!shapes.upload(commandBuffer) || !batch.upload(commandBuffer))) {
+      SDL_CancelGPUCommandBuffer(commandBuffer);
+      ok = false;
+      break;
+    }
+
+    SDL_GPUColorTargetInfo colorTargetInfo{};
+    colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+    colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+    colorTargetInfo.texture = target;
+    SDL_GPURenderPass *renderPass =
+        SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+    SDL_PushGPUVertexUniformData(commandBuffer, 0, viewProjection,
+                                 sizeof(viewProjection));
+    batch.render(renderPass);
+    SDL_EndGPURenderPass(renderPass);
+
+    Uint64 start = SDL_GetTicksNS();
+    SDL_GPUFence *fence =
+        SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    ok = fence && SDL_WaitForGPUFences(device, true, &fence, 1);
+    Uint64 elapsed = SDL_GetTicksNS() - start;
+    SDL_ReleaseGPUFence(device, fence);
+
+    // The first frame carries the upload.
+    if (frame > 0 && elapsed < result.bestNS) {
+      result.bestNS = elapsed;
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  Uint32 spriteCount = 20000;
+  int frames = 5;
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--sprites") == 0) {
+      spriteCount = SDL_max((Uint32)SDL_atoi(argv[i + 1]), 1u);
+    } else if (SDL_strcmp(argv[i], "--frames") == 0) {
+      frames = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    }
+  }
+
+  SDL_GPUDevice *device = createHeadlessDevice();
+  if (!device) {
+    return 1;
+  }
+
+  SpriteShapeTable shapes;
+  if (!shapes.init(device, SpriteShapeSettings{})) {
+    SDL_DestroyGPUDevice(device);
+    SDL_Quit();
+    return 1;
+  }
+
+  // Trimming is load time work; time it per image to show it stays there.
+  bool covered = true;
+  std::vector<Uint32> imageShapes;
+  std::vector<Uint8> pixels;
+  for (int kind = 0; kind < (int)ImageKind::Count; kind++) {
+    generateImage((ImageKind)kind, pixels);
+    SpriteShape shape;
+    float areaFraction = 0.0f;
+    Uint32 corners = 0;
+    Uint64 trimNS = bestOfNS(5, [&] {
+      corners = trimSpriteShape(pixels.data(), IMAGE_SIZE, IMAGE_SIZE, 0, 0.5f,
+                                shape, areaFraction);
+    });
+    bool ok = corners > 0 && shapeCovers(shape, corners, pixels);
+    covered = covered && ok;
+    imageShapes.push_back(shapes.add(pixels.data(), IMAGE_SIZE, IMAGE_SIZE));
+    SDL_Log("%-8s %u corners, %5.1f%% of the quad, trimmed in %6.1f us%s",
+            imageKindName((ImageKind)kind), corners, areaFraction * 100.0f,
+            trimNS / 1e3, ok ? "" : "  MISSES VISIBLE TEXELS");
+  }
+
+  SDL_GPUTexture *target =
+      createOffscreenTarget(device, TARGET_WIDTH, TARGET_HEIGHT);
+  SDL_GPUTexture *texture = createWhiteTexture(device);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  SDL_GPUGraphicsPipeline *quadPipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140,
+      SpriteTexturing::Array, SpriteGeometry::VertexPulling);
+  SDL_GPUGraphicsPipeline *trimmedPipeline = createSpritePipeline(
+      device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SpriteLayout::Std140,
+      SpriteTexturing::Array, SpriteGeometry::Trimmed);
+
+  SpriteBatch batch;
+  SpriteBatchSettings batchSettings;
+  batchSettings.capacity = spriteCount;
+  batchSettings.cull = false;
+  batchSettings.shapeBuffer = shapes.buffer();
+  bool ok = target && texture && sampler && quadPipeline && trimmedPipeline &&
+            batch.init(device, batchSettings);
+  if (!ok) {
+    SDL_Log("Failed to create the benchmark's resources: %s", SDL_GetError());
+  }
+  Uint8 quadId = batch.addPipeline(quadPipeline);
+  Uint8 trimmedId = batch.addPipeline(trimmedPipeline, SpriteGeometry::Trimmed);
+  batch.addTexture({texture, sampler});
+
+  // Sizes spread evenly over the range, so the automatic choice has small
+  // sprites to leave as quads as well as large ones to trim.
+  std::vector<BenchSprite> sprites(spriteCount);
+  Uint64 seed = 1;
+  for (BenchSprite &sprite : sprites) {
+    float size = MIN_SPRITE_SIZE +
+                 SDL_randf_r(&seed) * (MAX_SPRITE_SIZE - MIN_SPRITE_SIZE);
+    sprite.shape = imageShapes[SDL_rand_r(&seed, (Sint32)imageShapes.size())];
+    sprite.data = {};
+    sprite.data.x = SDL_randf_r(&seed) * TARGET_WIDTH;
+    sprite.data.y = SDL_randf_r(&seed) * TARGET_HEIGHT;
+    sprite.data.z = SDL_randf_r(&seed);
+    sprite.data.rotation = SDL_randf_r(&seed) * 2.0f * SDL_PI_F;
+    sprite.data.w = sprite.data.h = size;
+    sprite.data.shape = (float)sprite.shape;
+    sprite.data.texW = sprite.data.texH = 1.0f;
+    sprite.data.r = sprite.data.g = sprite.data.b = 1.0f;
+    sprite.data.a = 0.5f;
+  }
+
+  SDL_Log("%s driver, %ux%u target, %u sprites of %.0f to %.0f px, best of "
+          "%d frames",
+          SDL_GetGPUDeviceDriver(device), TARGET_WIDTH, TARGET_HEIGHT,
+          spriteCount, MIN_SPRITE_SIZE, MAX_SPRITE_SIZE, frames);
+  const char *modeNames[] = {"quads", "trimmed", "automatic"};
+  TrimResult quads{};
+  for (int mode = 0; mode < 3 && ok; mode++) {
+    TrimResult result;
+    ok = timeMode(device, target, batch, quadId, trimmedId, shapes, sprites,
+                  (TrimMode)mode, frames, result);
+    if (!ok) {
+      break;
+    }
+    if (mode == 0) {
+      quads = result;
+    }
+    SDL_Log("%-9s %8.3f ms  %6u trimmed  %8.1f M px covered (%5.1f%% of "
+            "the quads)",
+            modeNames[mode], result.bestNS / 1e6, result.trimmed,
+            result.coveredMPixels,
+            result.coveredMPixels * 100.0 / quads.coveredMPixels);
+  }
+
+  batch.release();
+  shapes.release();
+  SDL_ReleaseGPUGraphicsPipeline(device, quadPipeline);
+  SDL_ReleaseGPUGraphicsPipeline(device, trimmedPipeline);
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  SDL_DestroyGPUDevice(device);
+  SDL_Quit();
+
+  if (!covered) {
+    SDL_Log("A shape leaves out visible texels");
+    return 1;
+  }
+  return ok ? 0 : 1;
+}
@@ -5,8 +5,27 @@ layout(location = 1) in vec4 Color;
 
 layout(location = 0) out vec4 FragColor;
 
+#ifdef SINGLE_TEXTURE
+// Fallback for plain 2D textures: every texture switch breaks the batch.
 layout(set = 2, binding = 0) uniform sampler2D Texture;
 
 void main() {
     FragColor = Color * texture(Texture, Texcoord);
 }
+#else
+layout(location = 2) flat in float TextureLayer;
+
+// Sheets of the same size are layers of one texture, so sprites from
+// different sheets can share a draw call. Each sprite picks its layer.
+layout(set = 2, binding = 0) uniform sampler2DArray Texture;
+
+void main() {
+#ifdef COUNT_FRAGMENTS
+    // Adds up to the number of fragments that passed the depth test, with
+    // the additive blending of createFragmentCountPipeline.
+    FragColor = vec4(1.0);
+#else
+    FragColor = Color * texture(Texture, vec3(Texcoord, TextureLayer));
+#endif
+}
+#endif
@@ -0,0 +1,80 @@
+#version 460
+
+// Same quads as vertex.vert, but a tile only needs its frame id: where it
+// is follows from its place in the buffer.
+const uint triangleIndices[6] = uint[6](0, 1, 2, 3, 2, 1);
+const vec2 vertexPos[4] = vec2[4](
+    vec2(0.0f, 0.0f),
+    vec2(1.0f, 0.0f),
+    vec2(0.0f, 1.0f),
+    vec2(1.0f, 1.0f)
+);
+
+// Must match TILE_CHUNK_SIZE in src/TileMap.hpp.
+const uint CHUNK_SIZE = 32;
+const uint CHUNK_TILES = CHUNK_SIZE * CHUNK_SIZE;
+
+// Every chunk's tiles, row by row, chunk after chunk and layer after layer.
+// Tiles are 16 bit frame ids, two to a uint with the first in the low half.
+// 0 is no tile.
+layout(std430, binding = 0, set = 0) readonly buffer TileBuffer {
+    uint Tiles[];
+};
+
+// Must match TileFrame in src/TileMap.hpp.
+struct TileFrame {
+    vec4 TexRect;
+    float TextureLayer;
+    float Padding0, Padding1, Padding2;
+};
+
+layout(std430, binding = 1, set = 0) readonly buffer FrameBuffer {
+    TileFrame Frames[];
+};
+
+layout(std140, binding = 0, set = 1) uniform UniformBlock {
+    mat4 ViewProjectionMatrix;
+};
+
+// Pushed once per layer. Must match TileLayerUniforms in src/TileMap.cpp.
+layout(std140, binding = 1, set = 1) uniform TileLayerBlock {
+    vec2 Origin;
+    float TileSize;
+    float Depth;
+    uint ChunksX;
+    uint FirstChunk;
+};
+
+layout (location = 0) out vec2 Texcoord;
+layout (location = 1) out vec4 Color;
+layout (location = 2) flat out float TextureLayer;
+
+void main() {
+    // gl_VertexIndex includes the draw's first vertex, so this is the tile's
+    // index in the whole buffer.
+    uint id = uint(gl_VertexIndex);
+    uint tileIndex = id / 6;
+    vec2 local = vertexPos[triangleIndices[id % 6]];
+
+    uint tile = (Tiles[tileIndex / 2] >> ((tileIndex % 2) * 16)) & 0xffffu;
+    if (tile == 0) {
+        // All six vertices on one point: no area, nothing rasterized.
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        Texcoord = vec2(0.0);
+        Color = vec4(0.0);
+        TextureLayer = 0.0;
+        return;
+    }
+
+    uint chunk = tileIndex / CHUNK_TILES - FirstChunk;
+    uint inChunk = tileIndex % CHUNK_TILES;
+    uvec2 cell = uvec2(chunk % ChunksX, chunk / ChunksX) * CHUNK_SIZE +
+                 uvec2(inChunk % CHUNK_SIZE, inChunk / CHUNK_SIZE);
+    vec2 position = Origin + (vec2(cell) + local) * TileSize;
+
+    TileFrame frame = Frames[tile];
+    gl_Position = ViewProjectionMatrix * vec4(position, Depth, 1.0);
+    Texcoord = frame.TexRect.xy + frame.TexRect.zw * local;
+    Color = vec4(1.0);
+    TextureLayer = frame.TextureLayer;
+}
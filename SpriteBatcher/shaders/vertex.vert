@@ -15,12 +15,58 @@ struct SpriteData {
     vec3 Position;
     float Rotation;
     vec2 Scale;
-    // The padding needed for std140. Must align to 16 bytes.
-    vec2 Padding;
+    // Layer of the sampler2DArray in fragment.frag, and the entry in
+    // ShapeBuffer (0 is the full quad). Together they fill what used to be
+    // the std140 padding, which still aligns TexU to 16 bytes.
+    float TextureLayer;
+    float Shape;
     float TexU, TexV, TexW, TexH;
     vec4 Color;
 };
 
+#ifdef COMPACT_SPRITES
+const float PI = 3.14159265358979;
+
+// Half the size of SpriteData (32 bytes instead of 64). Must match
+// CompactSpriteData in src/SpriteData.hpp.
+struct PackedSpriteData {
+    uint PositionXY;        // half x, half y
+    uint PositionZRotation; // half z, snorm16 rotation / PI
+    uint Scale;             // half w, half h
+    uint Color;             // unorm8 r, g, b, a
+    uint TexUV;             // unorm16 u, v
+    uint TexWH;             // unorm16 w, h
+    uint TextureLayer;
+    // Also rounds the struct up to the 16 bytes std140 wants.
+    uint Shape;
+};
+
+layout(std140, binding = 0, set = 0) buffer SpriteBuffer {
+    PackedSpriteData DataBuffer[];
+};
+
+// The unpack functions read the low 16 bits into .x and the high 16 bits
+// into .y (the low byte into .x for unpackUnorm4x8).
+SpriteData loadSprite(uint index) {
+    PackedSpriteData packed = DataBuffer[index];
+
+    SpriteData sprite;
+    sprite.Position = vec3(unpackHalf2x16(packed.PositionXY),
+                           unpackHalf2x16(packed.PositionZRotation).x);
+    sprite.Rotation = unpackSnorm2x16(packed.PositionZRotation).y * PI;
+    sprite.Scale = unpackHalf2x16(packed.Scale);
+    sprite.TextureLayer = float(packed.TextureLayer);
+    sprite.Shape = float(packed.Shape);
+    vec2 texUV = unpackUnorm2x16(packed.TexUV);
+    vec2 texWH = unpackUnorm2x16(packed.TexWH);
+    sprite.TexU = texUV.x;
+    sprite.TexV = texUV.y;
+    sprite.TexW = texWH.x;
+    sprite.TexH = texWH.y;
+    sprite.Color = unpackUnorm4x8(packed.Color);
+    return sprite;
+}
+#else
 layout(std140, binding = 0, set = 0) buffer SpriteBuffer {
     // Compared to a uniform buffer, we don't have to specify instance count.
     // The equivalent of a StructuredBuffer (HLSL) in GLSL is Shader Storage Buffer Object.
@@ -30,6 +76,23 @@ layout(std140, binding = 0, set = 0) buffer SpriteBuffer {
     SpriteData DataBuffer[];
 };
 
+SpriteData loadSprite(uint index) {
+    return DataBuffer[index];
+}
+#endif
+
+#ifdef TRIMMED_SHAPES
+// Must match SPRITE_SHAPE_VERTICES in src/SpriteShapes.hpp.
+const uint SHAPE_VERTICES = 8;
+const uint FAN_VERTICES = (SHAPE_VERTICES - 2) * 3;
+
+// The shared vertex table: SHAPE_VERTICES corners per shape, in the sprite's
+// unit square like vertexPos. Must match SpriteShape in src/SpriteShapes.hpp.
+layout(std430, binding = 1, set = 0) readonly buffer ShapeBuffer {
+    vec2 ShapeVertices[];
+};
+#endif
+
 // Used to transfrom the vertex position from world space to screen space.
 layout(std140, binding = 0, set = 1) uniform UniformBlock {
     // In GLSL, variable starts automatically at offset 0.
@@ -38,9 +101,26 @@ layout(std140, binding = 0, set = 1) uniform UniformBlock {
 
 layout (location = 0) out vec2 Texcoord;
 layout (location = 1) out vec4 Color;
+// The same for the whole sprite, so no need to interpolate it.
+layout (location = 2) flat out float TextureLayer;
 
 
 void main() {
+#if defined(TRIMMED_SHAPES)
+    // A fan around the shape's first corner, three vertices per triangle.
+    // Triangle t is corners 0, t + 1 and t + 2. Shapes with fewer corners
+    // repeat the last one, so their extra triangles have no area.
+    uint id = uint(gl_VertexIndex);
+    uint spriteIndex = id / FAN_VERTICES;
+    uint fanVertex = id % FAN_VERTICES;
+    uint corner = fanVertex % 3 == 0 ? 0 : fanVertex / 3 + fanVertex % 3;
+#elif defined(INSTANCED_QUADS)
+    // One instance per sprite, drawn as a 4 vertex triangle strip. The
+    // strip's order is the order of vertexPos, so the vertex index is the
+    // corner. gl_InstanceIndex includes the draw's first instance.
+    uint spriteIndex = uint(gl_InstanceIndex);
+    uint vert = uint(gl_VertexIndex);
+#else
     // The only input we have is the id. It's implicitly defined.
     // by glDrawArrays.
     // This an id that ranges from 0 to the number of vertices in the draw call.
@@ -51,24 +131,28 @@ void main() {
     // Divisible gives texcoords index.
     // e.g. 0 is top left, 1 is top-right, 2 is bottom-left and 3 is bottom-right.
     uint vert = uint(triangleIndices[id % 6]);
+#endif
 
-    SpriteData sprite = DataBuffer[spriteIndex];
+    SpriteData sprite = loadSprite(spriteIndex);
 
-    vec2 texcoord[4] = vec2[4](
-        vec2(sprite.TexU,               sprite.TexV),
-        vec2(sprite.TexU + sprite.TexW, sprite.TexV),
-        vec2(sprite.TexU,               sprite.TexV + sprite.TexH),
-        vec2(sprite.TexU + sprite.TexW, sprite.TexV + sprite.TexH)
-    );
+    // Where the vertex is in the sprite's unit square. Scale takes it to the
+    // sprite's size and the texture rect to its texels.
+#ifdef TRIMMED_SHAPES
+    vec2 local = ShapeVertices[uint(sprite.Shape) * SHAPE_VERTICES + corner];
+#else
+    vec2 local = vertexPos[vert];
+#endif
 
     float c = cos(sprite.Rotation);
     float s = sin(sprite.Rotation);
 
     mat2 rotation = mat2(c, s, -s, c);
-    vec2 coord = rotation * (sprite.Scale * vertexPos[vert]);
+    vec2 coord = rotation * (sprite.Scale * local);
     vec3 coordWithDepth = vec3(coord + sprite.Position.xy, sprite.Position.z);
 
     gl_Position = ViewProjectionMatrix * vec4(coordWithDepth, 1.0);
-    Texcoord = texcoord[vert];
+    Texcoord = vec2(sprite.TexU, sprite.TexV) +
+               vec2(sprite.TexW, sprite.TexH) * local;
     Color = sprite.Color;
+    TextureLayer = sprite.TextureLayer;
 }
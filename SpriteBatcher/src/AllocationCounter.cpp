@@ -0,0 +1,49 @@
+#include "AllocationCounter.hpp"
+
+#include "SDL3/SDL_log.h"
+
+#include <atomic>
+
+static std::atomic<Uint64> allocations{0};
+
+static SDL_malloc_func originalMalloc;
+static SDL_calloc_func originalCalloc;
+static SDL_realloc_func originalRealloc;
+static SDL_free_func originalFree;
+
+static void *SDLCALL countingMalloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return originalMalloc(size);
+}
+
+static void *SDLCALL countingCalloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return originalCalloc(count, size);
+}
+
+static void *SDLCALL countingRealloc(void *memory, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return originalRealloc(memory, size);
+}
+
+void installAllocationCounter() {
+  if (originalMalloc) {
+    return;
+  }
+  // The wrappers forward to SDL's own functions, so memory SDL allocated
+  // before this call can still be freed through them.
+  SDL_GetOriginalMemoryFunctions(&originalMalloc, &originalCalloc,
+                                 &originalRealloc, &originalFree);
+  if (!SDL_SetMemoryFunctions(countingMalloc, countingCalloc, countingRealloc,
+                              originalFree)) {
+    SDL_Log("Failed to install the allocation counter: %s", SDL_GetError());
+  }
+}
+
+Uint64 allocationCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void countAllocation() {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+}
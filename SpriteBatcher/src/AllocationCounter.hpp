@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+// Counts heap allocations: everything that goes through SDL_malloc,
+// SDL_calloc and SDL_realloc once installAllocationCounter() has run. Frees
+// aren't counted; the point is finding code that allocates at all.
+//
+// Programs that link CountingOperatorNew.cpp as well (the
+// SpriteBatcherAllocationCounter library) also count every C++ operator new,
+// std::vector growth included. The sample doesn't, so its allocator stays
+// the standard one.
+void installAllocationCounter();
+
+// Allocations since the program started, from any thread.
+Uint64 allocationCount();
+
+// Adds one allocation, for allocators that don't go through SDL.
+void countAllocation();
@@ -0,0 +1,156 @@
+#include "AtlasPacker.hpp"
+
+static bool overlaps(const AtlasRect &a, const AtlasRect &b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h &&
+         b.y < a.y + a.h;
+}
+
+static bool containsRect(const AtlasRect &outer, const AtlasRect &inner) {
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + inner.w <= outer.x + outer.w &&
+         inner.y + inner.h <= outer.y + outer.h;
+}
+
+void AtlasPacker::init(Uint32 width, Uint32 height) {
+  pageWidth = width;
+  pageHeight = height;
+  usedArea = 0;
+  freeRects.clear();
+  freeRects.push_back({0, 0, width, height});
+}
+
+bool AtlasPacker::insert(Uint32 w, Uint32 h, AtlasRect &out) {
+  if (w == 0 || h == 0) {
+    return false;
+  }
+
+  Uint32 bestShortSide = ~0u;
+  Uint32 bestLongSide = ~0u;
+  int best = -1;
+  for (size_t i = 0; i < freeRects.size(); i++) {
+    const AtlasRect &free = freeRects[i];
+    if (free.w < w || free.h < h) {
+      continue;
+    }
+    Uint32 leftoverX = free.w - w;
+    Uint32 leftoverY = free.h - h;
+    Uint32 shortSide = SDL_min(leftoverX, leftoverY);
+    Uint32 longSide = SDL_max(leftoverX, leftoverY);
+    if (shortSide < bestShortSide ||
+        (shortSide == bestShortSide && longSide < bestLongSide)) {
+      bestShortSide = shortSide;
+      bestLongSide = longSide;
+      best = (int)i;
+    }
+  }
+  if (best < 0) {
+    return false;
+  }
+
+  out = {freeRects[best].x, freeRects[best].y, w, h};
+  splitFreeRects(out);
+  usedArea += (Uint64)w * h;
+  return true;
+}
+
+// Every free rectangle the used rect overlaps is replaced by up to four
+// maximal pieces around it: left, right, above and below.
+void AtlasPacker::splitFreeRects(const AtlasRect &used) {
+  splitRects.clear();
+  for (size_t i = 0; i < freeRects.size();) {
+    AtlasRect free = freeRects[i];
+    if (!overlaps(free, used)) {
+      i++;
+      continue;
+    }
+
+    if (used.x > free.x) {
+      splitRects.push_back({free.x, free.y, used.x - free.x, free.h});
+    }
+    if (used.x + used.w < free.x + free.w) {
+      splitRects.push_back({used.x + used.w, free.y,
+                            free.x + free.w - (used.x + used.w), free.h});
+    }
+    if (used.y > free.y) {
+      splitRects.push_back({free.x, free.y, free.w, used.y - free.y});
+    }
+    if (used.y + used.h < free.y + free.h) {
+      splitRects.push_back({free.x, used.y + used.h, free.w,
+                            free.y + free.h - (used.y + used.h)});
+    }
+
+    freeRects[i] = freeRects.back();
+    freeRects.pop_back();
+  }
+  addFreeRects();
+}
+
+// Adds splitRects to freeRects, dropping every rect that is contained in
+// another one. freeRects is already free of those, so only the new rects
+// have to be compared, which keeps this O(new * all) instead of O(all^2).
+void AtlasPacker::addFreeRects() {
+  for (size_t n = 0; n < splitRects.size(); n++) {
+    const AtlasRect &candidate = splitRects[n];
+    bool contained = false;
+    for (const AtlasRect &free : freeRects) {
+      if (containsRect(free, candidate)) {
+        contained = true;
+        break;
+      }
+    }
+    // Identical new rects are possible; only the first one is kept.
+    for (size_t m = n + 1; m < splitRects.size() && !contained; m++) {
+      contained = containsRect(splitRects[m], candidate);
+    }
+    if (contained) {
+      continue;
+    }
+
+    for (size_t i = 0; i < freeRects.size();) {
+      if (containsRect(candidate, freeRects[i])) {
+        freeRects[i] = freeRects.back();
+        freeRects.pop_back();
+      } else {
+        i++;
+      }
+    }
+    freeRects.push_back(candidate);
+  }
+}
+
+void AtlasPacker::free(const AtlasRect &rect) {
+  usedArea -= (Uint64)rect.w * rect.h;
+  if (usedArea == 0) {
+    // Empty again. Start over with one rect instead of the patchwork.
+    init(pageWidth, pageHeight);
+    return;
+  }
+
+  // Grow the freed rect over free neighbors that share a full edge with it,
+  // until nothing merges anymore.
+  AtlasRect merged = rect;
+  bool grew = true;
+  while (grew) {
+    grew = false;
+    for (const AtlasRect &free : freeRects) {
+      if (free.y == merged.y && free.h == merged.h &&
+          (free.x + free.w == merged.x || merged.x + merged.w == free.x)) {
+        Uint32 x = SDL_min(free.x, merged.x);
+        merged = {x, merged.y, merged.w + free.w, merged.h};
+        grew = true;
+        break;
+      }
+      if (free.x == merged.x && free.w == merged.w &&
+          (free.y + free.h == merged.y || merged.y + merged.h == free.y)) {
+        Uint32 y = SDL_min(free.y, merged.y);
+        merged = {merged.x, y, merged.w, merged.h + free.h};
+        grew = true;
+        break;
+      }
+    }
+  }
+
+  splitRects.clear();
+  splitRects.push_back(merged);
+  addFreeRects();
+}
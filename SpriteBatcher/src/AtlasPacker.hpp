@@ -0,0 +1,47 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include <vector>
+
+struct AtlasRect {
+  Uint32 x, y, w, h;
+};
+
+// MaxRects bin packing for one atlas page (Jukka Jylänki, "A Thousand Ways
+// to Pack the Bin"). The free space is kept as a list of maximal free
+// rectangles that may overlap each other:
+// - insert picks the free rectangle where the image leaves the shortest
+//   leftover side (Best Short Side Fit), then cuts the used rect out of every
+//   free rectangle it overlaps and drops free rectangles contained in others.
+// - free gives a rect back. It's merged with free rectangles that share a
+//   whole edge with it, so a page that is filled and emptied over and over
+//   doesn't crumble into slivers.
+// Only positions are handled here; TextureAtlas owns the pixels.
+class AtlasPacker {
+public:
+  void init(Uint32 width, Uint32 height);
+
+  bool insert(Uint32 w, Uint32 h, AtlasRect &out);
+  void free(const AtlasRect &rect);
+
+  Uint32 width() const { return pageWidth; }
+  Uint32 height() const { return pageHeight; }
+  // Fraction of the page covered by inserted rects.
+  float occupancy() const {
+    return (float)usedArea / ((float)pageWidth * (float)pageHeight);
+  }
+  Uint32 freeRectCount() const { return (Uint32)freeRects.size(); }
+
+private:
+  void splitFreeRects(const AtlasRect &used);
+  void addFreeRects();
+
+  Uint32 pageWidth = 0;
+  Uint32 pageHeight = 0;
+  Uint64 usedArea = 0;
+  std::vector<AtlasRect> freeRects;
+  // New free rects waiting for addFreeRects. Kept to avoid allocating per
+  // insert.
+  std::vector<AtlasRect> splitRects;
+};
@@ -0,0 +1,197 @@
+#include "BatchKey.hpp"
+
+void BatchKeySorter::reserve(Uint32 count) { keys.reserve(count); }
+
+void BatchKeySorter::keepOnly(const Uint32 *kept, Uint32 keptCount) {
+  // kept[i] >= i, so compacting in place never overwrites a key that is
+  // still needed.
+  for (Uint32 i = 0; i < keptCount; i++) {
+    keys[i] = keys[kept[i]];
+  }
+  keys.resize(keptCount);
+}
+
+// Turns digit counts into the position of the first item with each digit.
+static void prefixSum(Uint32 histogram[256]) {
+  Uint32 offset = 0;
+  for (int digit = 0; digit < 256; digit++) {
+    Uint32 digitCount = histogram[digit];
+    histogram[digit] = offset;
+    offset += digitCount;
+  }
+}
+
+void BatchKeySorter::sort(FrameArena &arena) {
+  Uint32 count = size();
+  resultOrder = nullptr;
+  stateRuns.clear();
+  if (count == 0) {
+    return;
+  }
+
+  // First a cheap pass: which bytes differ between keys at all, and are the
+  // keys already sorted?
+  Uint64 first = keys[0];
+  Uint64 differing = 0;
+  bool sorted = true;
+  for (Uint32 i = 1; i < count; i++) {
+    differing |= keys[i] ^ first;
+    sorted &= keys[i] >= keys[i - 1];
+  }
+
+  if (sorted) {
+    findRuns(keys.data(), count);
+    return;
+  }
+
+  // Only bytes that differ need a pass, least significant first.
+  int passBytes[8];
+  int passCount = 0;
+  for (int byte = 0; byte < 8; byte++) {
+    if ((differing >> (byte * 8)) & 0xff) {
+      passBytes[passCount++] = byte;
+    }
+  }
+
+  if (passCount <= 4) {
+    sortCompressed(arena, passBytes, passCount);
+  } else {
+    sortWide(arena, passBytes, passCount);
+  }
+}
+
+void BatchKeySorter::findRuns(const Uint64 *sortedKeys, Uint32 count) {
+  Uint32 runStart = 0;
+  Uint32 runState = batchKeyState(sortedKeys[0]);
+  for (Uint32 i = 1; i < count; i++) {
+    Uint32 state = batchKeyState(sortedKeys[i]);
+    if (state != runState) {
+      stateRuns.push_back({runStart, i - runStart, runState});
+      runStart = i;
+      runState = state;
+    }
+  }
+  stateRuns.push_back({runStart, count - runStart, runState});
+}
+
+void BatchKeySorter::sortCompressed(FrameArena &arena, const int *passBytes,
+                                    int passCount) {
+  Uint32 count = size();
+  Uint64 *scratchA = arena.allocate<Uint64>(count);
+  Uint64 *scratchB = arena.allocate<Uint64>(count);
+  Uint32 *values = arena.allocate<Uint32>(count);
+
+  // Bytes that are equal in every key don't change the order, so the
+  // differing bytes alone (kept in order of significance) sort the same way.
+  // They go in the top 32 bits, the sprite index in the bottom 32.
+  Uint32 histograms[4][256] = {};
+  Uint64 *items = scratchA;
+  for (Uint32 i = 0; i < count; i++) {
+    Uint64 key = keys[i];
+    Uint32 compressed = 0;
+    for (int pass = 0; pass < passCount; pass++) {
+      Uint32 digit = (key >> (passBytes[pass] * 8)) & 0xff;
+      compressed |= digit << (pass * 8);
+      histograms[pass][digit]++;
+    }
+    items[i] = (Uint64)compressed << 32 | i;
+  }
+
+  Uint64 *source = scratchA;
+  Uint64 *destination = scratchB;
+  for (int pass = 0; pass < passCount; pass++) {
+    Uint32 *histogram = histograms[pass];
+    int shift = 32 + pass * 8;
+    prefixSum(histogram);
+
+    for (Uint32 i = 0; i < count; i++) {
+      Uint64 item = source[i];
+      destination[histogram[(item >> shift) & 0xff]++] = item;
+    }
+
+    Uint64 *swap = source;
+    source = destination;
+    destination = swap;
+  }
+
+  // Which compressed bytes came from the state half of the key.
+  Uint32 stateMask = 0;
+  for (int pass = 0; pass < passCount; pass++) {
+    if (passBytes[pass] >= 4) {
+      stateMask |= 0xffu << (pass * 8);
+    }
+  }
+
+  // Split the items back into the order and the runs. The run's real state
+  // is read from the key of its first sprite.
+  Uint32 *order = values;
+  Uint32 runStart = 0;
+  Uint32 runState = (Uint32)(source[0] >> 32) & stateMask;
+  for (Uint32 i = 0; i < count; i++) {
+    Uint64 item = source[i];
+    order[i] = (Uint32)item;
+
+    Uint32 state = (Uint32)(item >> 32) & stateMask;
+    if (state != runState) {
+      stateRuns.push_back(
+          {runStart, i - runStart, batchKeyState(keys[order[runStart]])});
+      runStart = i;
+      runState = state;
+    }
+  }
+  stateRuns.push_back(
+      {runStart, count - runStart, batchKeyState(keys[order[runStart]])});
+
+  resultOrder = order;
+}
+
+void BatchKeySorter::sortWide(FrameArena &arena, const int *passBytes,
+                              int passCount) {
+  Uint32 count = size();
+  Uint64 *scratchA = arena.allocate<Uint64>(count);
+  Uint64 *scratchB = arena.allocate<Uint64>(count);
+  Uint32 *values = arena.allocate<Uint32>(count);
+  Uint32 *valuesScratch = arena.allocate<Uint32>(count);
+
+  // Histograms for all differing bytes in a single read of the keys.
+  Uint32 histograms[8][256] = {};
+  for (Uint32 i = 0; i < count; i++) {
+    Uint64 key = keys[i];
+    for (int pass = 0; pass < passCount; pass++) {
+      histograms[pass][(key >> (passBytes[pass] * 8)) & 0xff]++;
+    }
+  }
+
+  // The keys themselves stay untouched, so the first pass reads them and
+  // writes the scratch arrays. The indices are generated on that first pass
+  // instead of being initialised separately.
+  const Uint64 *sourceKeys = keys.data();
+  Uint64 *destinationKeys = scratchA;
+  Uint64 *spareKeys = scratchB;
+  Uint32 *sourceValues = nullptr;
+  Uint32 *destinationValues = values;
+  Uint32 *spareValues = valuesScratch;
+
+  for (int pass = 0; pass < passCount; pass++) {
+    Uint32 *histogram = histograms[pass];
+    int shift = passBytes[pass] * 8;
+    prefixSum(histogram);
+
+    for (Uint32 i = 0; i < count; i++) {
+      Uint64 key = sourceKeys[i];
+      Uint32 position = histogram[(key >> shift) & 0xff]++;
+      destinationKeys[position] = key;
+      destinationValues[position] = sourceValues ? sourceValues[i] : i;
+    }
+
+    sourceKeys = destinationKeys;
+    sourceValues = destinationValues;
+    destinationKeys = spareKeys;
+    destinationValues = spareValues;
+    spareKeys = (Uint64 *)sourceKeys;
+    spareValues = sourceValues;
+  }
+
+  findRuns(sourceKeys, count);
+  resultOrder = sourceValues;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "FrameArena.hpp"
+
+#include <cstring>
+#include <vector>
+
+// 64 bit sort key for a sprite. Sorting by it groups sprites that can share
+// a draw call, from the most to the least significant bits:
+//   bits 56-63 layer    - layers are always drawn in ascending order
+//   bits 48-55 pipeline - id from SpriteBatch::addPipeline
+//   bits 32-47 texture  - id from SpriteBatch::addTexture
+//   bits  0-31 depth    - back to front inside one (layer, pipeline, texture)
+// Only the upper 32 bits (the "state") decide where draws break. Depth only
+// orders sprites inside a draw, so the layer is what keeps translucent
+// sprites with different textures in the right order.
+inline Uint64 makeBatchKey(Uint8 layer, Uint8 pipeline, Uint16 texture,
+                           float depth) {
+  // Flip a float's bits so that they sort like the float, then invert the
+  // result: a larger z is further away and has to be drawn first.
+  Uint32 bits;
+  std::memcpy(&bits, &depth, sizeof(bits));
+  bits ^= (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+  bits = ~bits;
+
+  return (Uint64)layer << 56 | (Uint64)pipeline << 48 | (Uint64)texture << 32 |
+         bits;
+}
+
+// For sprites drawn with SpriteDepth::Opaque, where the depth test decides
+// what ends up on top and the order only has to be good for early-Z. There
+// are no layers, and depth only keeps its top 8 bits, ascending: roughly
+// front to back. That leaves the radix sort a pass or two for the state and
+// one for depth, instead of the four depth bytes of makeBatchKey. depth is
+// layeredDepth, in [0, 1].
+inline Uint64 makeOpaqueBatchKey(Uint8 pipeline, Uint16 texture, float depth) {
+  Uint32 bucket = (Uint32)(SDL_clamp(depth, 0.0f, 1.0f) * 255.0f);
+  return (Uint64)pipeline << 48 | (Uint64)texture << 32 | bucket << 24;
+}
+
+// The depth a sprite has to be drawn at when a depth test, not the draw
+// order, keeps the layers apart: every layer gets its own slice of [0, 1],
+// the highest layer in front. Inside its slice z keeps its meaning, 0 in
+// front and 1 at the back.
+inline float layeredDepth(Uint8 layer, float z, Uint8 layerCount) {
+  return ((float)(layerCount - 1 - layer) + SDL_clamp(z, 0.0f, 1.0f)) /
+         layerCount;
+}
+
+inline Uint32 batchKeyState(Uint64 key) { return (Uint32)(key >> 32); }
+inline Uint8 batchKeyPipeline(Uint64 key) { return (Uint8)(key >> 48); }
+inline Uint16 batchKeyTexture(Uint64 key) { return (Uint16)(key >> 32); }
+
+// A range of sorted sprites that share the same state and can be drawn with
+// one call.
+struct BatchRun {
+  Uint32 first;
+  Uint32 count;
+  Uint32 state;
+};
+
+// Sorts a frame's batch keys with an LSD radix sort (one byte per pass) and
+// produces the order in which the sprites have to be packed, plus the runs
+// of equal state.
+//
+// - A first cheap pass finds the bytes that differ between keys at all. Only
+//   those get a radix pass, which in a typical 2D frame leaves the texture id
+//   and maybe a byte or two of depth.
+// - When at most four bytes differ, they are squeezed into 32 bits next to
+//   the sprite index, and a single array of 64 bit items is sorted. Each pass
+//   then moves 8 bytes per sprite instead of 12 (key + index).
+// - Keys that are already sorted (static scenes) skip sorting entirely.
+// The keys and runs are kept between frames, and the sort's scratch arrays
+// come from a FrameArena, so a steady frame doesn't allocate.
+class BatchKeySorter {
+public:
+  void clear() { keys.clear(); }
+  void reserve(Uint32 count);
+  void push(Uint64 key) { keys.push_back(key); }
+  Uint32 size() const { return (Uint32)keys.size(); }
+  // Drops every key but kept[0, keptCount), which must be ascending. Key i
+  // then belongs to sprite kept[i], so order() indexes into kept.
+  void keepOnly(const Uint32 *kept, Uint32 keptCount);
+
+  // The scratch arrays, and the order, are allocated from arena.
+  void sort(FrameArena &arena);
+
+  // Valid after sort() until the arena is reset. Sprite order()[i] goes to
+  // position i. order() is NULL when the keys were already in order.
+  const Uint32 *order() const { return resultOrder; }
+  const std::vector<BatchRun> &runs() const { return stateRuns; }
+
+private:
+  void sortCompressed(FrameArena &arena, const int *passBytes, int passCount);
+  void sortWide(FrameArena &arena, const int *passBytes, int passCount);
+  void findRuns(const Uint64 *sortedKeys, Uint32 count);
+
+  std::vector<Uint64> keys;
+  std::vector<BatchRun> stateRuns;
+
+  const Uint32 *resultOrder = nullptr;
+};
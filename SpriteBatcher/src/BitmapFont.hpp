@@ -0,0 +1,39 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include <vector>
+
+// A monospaced 1 bit font. Every glyph is glyphHeight rows of one byte, top
+// to bottom; the leftmost of a row's glyphWidth pixels is the highest of its
+// glyphWidth bits. Glyphs cover [firstCodepoint, firstCodepoint +
+// glyphCount).
+struct BitmapFont {
+  Uint32 glyphWidth, glyphHeight;
+  Uint32 firstCodepoint, glyphCount;
+  const Uint8 *rows;
+};
+
+// Printable ASCII (32 to 126) in 5 x 7 cells, after the HD44780 LCD
+// character ROM. Lowercase descenders are squeezed into the 7 rows.
+const BitmapFont &builtinFont();
+
+// Pixel sizes of font at size, the height of a glyph in pixels. Whole
+// pixels, so glyphs laid out at integer positions stay sharp at zoom 1.
+struct GlyphLayout {
+  Uint32 width;
+  Uint32 height;
+  // From one glyph's left edge to the next one's, and from one line's top
+  // to the next one's.
+  Uint32 advance;
+  Uint32 lineHeight;
+};
+GlyphLayout glyphLayout(const BitmapFont &font, Uint32 size);
+
+// Scales codepoint's glyph up (or down) to glyphLayout's width x height,
+// 4 x 4 samples per pixel, into white RGBA8 with the coverage in alpha, so
+// the sprite color tints it and the edges are smoothed. A codepoint the font
+// doesn't have comes out as '?'. Returns false for a glyph without a single
+// pixel, a space, which has nothing to draw.
+bool rasterizeGlyph(const BitmapFont &font, Uint32 codepoint, Uint32 size,
+                    std::vector<Uint8> &pixels);
@@ -0,0 +1,118 @@
+#include "Camera2D.hpp"
+
+#include <cmath>
+
+void Camera2D::setViewport(float width, float height) {
+  if (width != this->width || height != this->height) {
+    this->width = width;
+    this->height = height;
+    dirty = true;
+  }
+}
+
+void Camera2D::setPosition(float x, float y) {
+  if (x != positionX || y != positionY) {
+    positionX = x;
+    positionY = y;
+    dirty = true;
+  }
+}
+
+void Camera2D::panScreen(float dx, float dy) {
+  // The rotation part of worldFromScreen, without the translation.
+  const Mat4 &m = worldFromScreen();
+  setPosition(positionX + m.m[0] * dx + m.m[4] * dy,
+              positionY + m.m[1] * dx + m.m[5] * dy);
+}
+
+void Camera2D::setZoom(float zoom) {
+  if (zoom > 0.0f && zoom != zoomFactor) {
+    zoomFactor = zoom;
+    dirty = true;
+  }
+}
+
+void Camera2D::setRotation(float radians) {
+  if (radians != rotationRadians) {
+    rotationRadians = radians;
+    dirty = true;
+  }
+}
+
+void Camera2D::setCullMargin(float pixels) {
+  if (pixels != cullMargin) {
+    cullMargin = pixels;
+    dirty = true;
+  }
+}
+
+// The box around the four corners of a viewport rect, in world space.
+static SpatialRect worldBox(const Mat4 &worldFromScreen, float minX,
+                            float minY, float maxX, float maxY) {
+  float cornersX[4] = {minX, maxX, minX, maxX};
+  float cornersY[4] = {minY, minY, maxY, maxY};
+  mat4TransformPoints(worldFromScreen, cornersX, cornersY, 4, cornersX,
+                      cornersY);
+  SpatialRect box = {cornersX[0], cornersY[0], cornersX[0], cornersY[0]};
+  for (int i = 1; i < 4; i++) {
+    box.minX = SDL_min(box.minX, cornersX[i]);
+    box.minY = SDL_min(box.minY, cornersY[i]);
+    box.maxX = SDL_max(box.maxX, cornersX[i]);
+    box.maxY = SDL_max(box.maxY, cornersY[i]);
+  }
+  return box;
+}
+
+// screen = translate(viewport center) * scale(zoom) * rotate(-rotation)
+//          * translate(-position)
+// On a y-down screen, rotating the world by -rotation turns the view
+// clockwise. The projection maps the viewport's pixels to NDC, top left at
+// (-1, 1), with depth 0 to -1 like the tutorial's.
+void Camera2D::update() {
+  if (!dirty) {
+    return;
+  }
+  dirty = false;
+  matrixVersion++;
+
+  screenMatrix = mat4Multiply(
+      mat4Multiply(mat4Translation(width * 0.5f, height * 0.5f, 0.0f),
+                   mat4Scale(zoomFactor, zoomFactor, 1.0f)),
+      mat4Multiply(mat4RotationZ(-rotationRadians),
+                   mat4Translation(-positionX, -positionY, 0.0f)));
+  // Scale, rotation and translation all have inverses as long as zoom > 0,
+  // which setZoom makes sure of.
+  mat4Inverse(screenMatrix, inverseScreenMatrix);
+
+  viewProjectionMatrix = mat4Multiply(
+      mat4Orthographic(0.0f, width, height, 0.0f, 0.0f, -1.0f), screenMatrix);
+  cullMatrix = mat4Multiply(mat4Orthographic(-cullMargin, width + cullMargin,
+                                             height + cullMargin, -cullMargin,
+                                             0.0f, -1.0f),
+                            screenMatrix);
+
+  bounds = worldBox(inverseScreenMatrix, 0.0f, 0.0f, width, height);
+  marginBounds = worldBox(inverseScreenMatrix, -cullMargin, -cullMargin,
+                          width + cullMargin, height + cullMargin);
+}
+
+void Camera2D::worldToScreen(const float *x, const float *y, Uint32 count,
+                             float *outX, float *outY) {
+  mat4TransformPoints(screenFromWorld(), x, y, count, outX, outY);
+}
+
+void Camera2D::screenToWorld(const float *x, const float *y, Uint32 count,
+                             float *outX, float *outY) {
+  mat4TransformPoints(worldFromScreen(), x, y, count, outX, outY);
+}
+
+void Camera2D::pushUniform(SDL_GPUCommandBuffer *commandBuffer) {
+  update();
+  if (commandBuffer == pushedTo && matrixVersion == pushedVersion) {
+    return;
+  }
+  SDL_PushGPUVertexUniformData(commandBuffer, 0, viewProjectionMatrix.m,
+                               sizeof(viewProjectionMatrix.m));
+  pushedTo = commandBuffer;
+  pushedVersion = matrixVersion;
+}
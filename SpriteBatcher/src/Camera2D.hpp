@@ -0,0 +1,111 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "Mat4.hpp"
+#include "SpatialGrid.hpp"
+
+// An orthographic 2D camera over a y-down world measured in pixels at zoom 1.
+// position is the world point at the center of the viewport; zoom > 1
+// magnifies; rotation turns the view (not the world) clockwise on screen.
+//
+// The matrices are rebuilt lazily, once after any change, and version()
+// counts the rebuilds, so code that derives something from the view (cull
+// parameters, a grid query rect) can tell whether it has to redo it:
+//   screenFromWorld  world -> viewport pixels (origin top left)
+//   worldFromScreen  its inverse, for picking
+//   viewProjection   world -> NDC, the ViewProjectionMatrix uniform
+//   cullViewProjection  the same over a viewport grown by the cull margin,
+//                    so sprites that a late pan brings in are already there
+class Camera2D {
+public:
+  void setViewport(float width, float height);
+  void setPosition(float x, float y);
+  // Moves by a distance in viewport pixels, following the rotation and zoom,
+  // like dragging the world under the mouse the other way.
+  void panScreen(float dx, float dy);
+  void setZoom(float zoom);
+  void setRotation(float radians);
+  // Extra viewport pixels on every side of cullViewProjection and
+  // cullBounds.
+  void setCullMargin(float pixels);
+
+  float x() const { return positionX; }
+  float y() const { return positionY; }
+  float zoom() const { return zoomFactor; }
+  float rotation() const { return rotationRadians; }
+  float viewportWidth() const { return width; }
+  float viewportHeight() const { return height; }
+
+  Uint32 version() {
+    update();
+    return matrixVersion;
+  }
+  const Mat4 &screenFromWorld() {
+    update();
+    return screenMatrix;
+  }
+  const Mat4 &worldFromScreen() {
+    update();
+    return inverseScreenMatrix;
+  }
+  const Mat4 &viewProjection() {
+    update();
+    return viewProjectionMatrix;
+  }
+  const Mat4 &cullViewProjection() {
+    update();
+    return cullMatrix;
+  }
+  // World-space box around everything on screen (with the margin for
+  // cullBounds). With rotation it's the box around the rotated viewport, so
+  // it holds a bit more than what's visible.
+  const SpatialRect &viewBounds() {
+    update();
+    return bounds;
+  }
+  const SpatialRect &cullBounds() {
+    update();
+    return marginBounds;
+  }
+
+  // Many points at once, as separate x and y arrays. Out may be in.
+  void worldToScreen(const float *x, const float *y, Uint32 count,
+                     float *outX, float *outY);
+  void screenToWorld(const float *x, const float *y, Uint32 count,
+                     float *outX, float *outY);
+  void screenToWorld(float x, float y, float &outX, float &outY) {
+    mat4TransformPoint(worldFromScreen(), x, y, outX, outY);
+  }
+
+  // Pushes viewProjection as the vertex uniform at slot 0 (set 1, binding 0
+  // in vertex.vert), unless commandBuffer already has this version. Uniforms
+  // belong to a command buffer and SDL reuses command buffer objects, so
+  // call submitted() once it's been submitted.
+  void pushUniform(SDL_GPUCommandBuffer *commandBuffer);
+  void submitted() { pushedTo = nullptr; }
+
+private:
+  void update();
+
+  float width = 1.0f;
+  float height = 1.0f;
+  float positionX = 0.0f;
+  float positionY = 0.0f;
+  float zoomFactor = 1.0f;
+  float rotationRadians = 0.0f;
+  float cullMargin = 0.0f;
+
+  bool dirty = true;
+  Uint32 matrixVersion = 0;
+  Mat4 screenMatrix{};
+  Mat4 inverseScreenMatrix{};
+  Mat4 viewProjectionMatrix{};
+  Mat4 cullMatrix{};
+  SpatialRect bounds{};
+  SpatialRect marginBounds{};
+
+  SDL_GPUCommandBuffer *pushedTo = nullptr;
+  Uint32 pushedVersion = 0;
+};
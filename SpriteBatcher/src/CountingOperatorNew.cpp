@@ -0,0 +1,23 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new so that C++ allocations show up in
+// allocationCount(). Only the benchmarks that check for allocations link
+// this, through the SpriteBatcherAllocationCounter object library.
+
+// The array and nothrow forms call these in the standard library, so they
+// are counted as well.
+void *operator new(std::size_t size) {
+  countAllocation();
+  void *memory = std::malloc(size ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
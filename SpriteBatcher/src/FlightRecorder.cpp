@@ -0,0 +1,106 @@
+#include "FlightRecorder.hpp"
+
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_log.h"
+
+#include "AllocationCounter.hpp"
+
+static const char *FRAME_PHASE_NAMES[FRAME_PHASE_COUNT] = {
+    "command buffer acquire", "swapchain acquire", "update scene",
+    "sprite build",           "copy pass",         "render pass",
+    "submit",
+};
+
+// Column headers for the report.
+static const char *FRAME_PHASE_COLUMNS[FRAME_PHASE_COUNT] = {
+    "acquire", "swapchain", "update", "build", "upload", "render", "submit",
+};
+
+const char *framePhaseName(FramePhase phase) {
+  return FRAME_PHASE_NAMES[(Uint32)phase];
+}
+
+bool FlightRecorder::init(const FlightRecorderSettings &settings) {
+  this->settings = settings;
+  this->settings.historyFrames = SDL_max(settings.historyFrames, 1u);
+  this->settings.framesAfter =
+      SDL_min(settings.framesAfter, this->settings.historyFrames - 1);
+  budgetNS = (Uint64)(settings.budgetMS * 1e6);
+  ring.assign(this->settings.historyFrames, FrameRecord{});
+  current = &ring[0];
+  frame = 0;
+  hitches = 0;
+  pendingHitchFrame = ~(Uint64)0;
+  return true;
+}
+
+FrameRecord &FlightRecorder::beginFrame() {
+  current = &ring[frame % ring.size()];
+  *current = {};
+  current->frame = frame;
+  current->startNS = SDL_GetTicksNS();
+  allocationsAtStart = allocationCount();
+  return *current;
+}
+
+void FlightRecorder::endFrame() {
+  current->totalNS = SDL_GetTicksNS() - current->startNS;
+  current->allocations = allocationCount() - allocationsAtStart;
+
+  if (current->totalNS > budgetNS) {
+    hitches++;
+    if (pendingHitchFrame == ~(Uint64)0) {
+      pendingHitchFrame = frame;
+    }
+  }
+  if (pendingHitchFrame != ~(Uint64)0 &&
+      frame - pendingHitchFrame >= settings.framesAfter) {
+    writeReport();
+    pendingHitchFrame = ~(Uint64)0;
+  }
+  frame++;
+}
+
+// One line per frame, oldest first, with the hitches marked. Times are in
+// milliseconds. Plain columns, so the report reads fine in a terminal and
+// pastes into a spreadsheet.
+void FlightRecorder::writeReport() {
+  SDL_IOStream *file = SDL_IOFromFile(settings.reportPath, "a");
+  if (!file) {
+    SDL_Log("Failed to open %s: %s", settings.reportPath, SDL_GetError());
+    return;
+  }
+
+  Uint64 count = SDL_min(frame + 1, (Uint64)ring.size());
+  Uint64 first = frame + 1 - count;
+  const FrameRecord &hitch = ring[pendingHitchFrame % ring.size()];
+  SDL_IOprintf(file,
+               "Hitch at frame %" SDL_PRIu64 ": %.3f ms (budget %.3f ms), "
+               "%" SDL_PRIu64 " frames around it\n",
+               hitch.frame, hitch.totalNS / 1e6, settings.budgetMS, count);
+  SDL_IOprintf(file, "  %8s %9s", "frame", "total");
+  for (Uint32 phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+    SDL_IOprintf(file, " %9s", FRAME_PHASE_COLUMNS[phase]);
+  }
+  SDL_IOprintf(file, " %8s %8s %6s %12s %10s %6s\n", "sprites", "kept",
+               "draws", "bytes", "arena", "allocs");
+
+  for (Uint64 f = first; f <= frame; f++) {
+    const FrameRecord &record = ring[f % ring.size()];
+    SDL_IOprintf(file, "%s %8" SDL_PRIu64 " %9.3f",
+                 record.totalNS > budgetNS ? "!" : " ", record.frame,
+                 record.totalNS / 1e6);
+    for (Uint32 phase = 0; phase < FRAME_PHASE_COUNT; phase++) {
+      SDL_IOprintf(file, " %9.3f", record.phaseNS[phase] / 1e6);
+    }
+    SDL_IOprintf(file,
+                 " %8u %8u %6u %12" SDL_PRIu64 " %10" SDL_PRIu64
+                 " %6" SDL_PRIu64 "\n",
+                 record.sprites, record.kept, record.drawCalls,
+                 record.bytesUploaded, record.arenaBytes, record.allocations);
+  }
+  SDL_IOprintf(file, "\n");
+  SDL_CloseIO(file);
+  SDL_Log("Frame %" SDL_PRIu64 " took %.3f ms, wrote %s", hitch.frame,
+          hitch.totalNS / 1e6, settings.reportPath);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Trace.hpp"
+
+#include <vector>
+
+// The phases of SDL_AppIterate that get timed.
+enum class FramePhase {
+  Acquire,
+  Swapchain,
+  Update,
+  Build,
+  Upload,
+  Render,
+  Submit,
+  Count,
+};
+static const Uint32 FRAME_PHASE_COUNT = (Uint32)FramePhase::Count;
+
+const char *framePhaseName(FramePhase phase);
+
+struct FrameRecord {
+  Uint64 frame;
+  Uint64 startNS;
+  Uint64 totalNS;
+  Uint64 phaseNS[FRAME_PHASE_COUNT];
+  Uint32 sprites;
+  Uint32 kept;
+  Uint32 drawCalls;
+  Uint64 bytesUploaded;
+  // Taken from the FrameArena, see FrameArena.hpp.
+  Uint64 arenaBytes;
+  // Heap allocations during the frame, see AllocationCounter.hpp.
+  Uint64 allocations;
+};
+
+struct FlightRecorderSettings {
+  // Frames kept in the ring. A report holds all of them.
+  Uint32 historyFrames = 240;
+  // How many of those come after the hitch. The report is written once they
+  // have been recorded.
+  Uint32 framesAfter = 30;
+  // A frame taking longer than this is a hitch.
+  float budgetMS = 33.3f;
+  // Reports are appended.
+  const char *reportPath = "hitches.txt";
+};
+
+// Remembers the last few seconds of frames, and writes them to a report when
+// one of them takes longer than the budget. That catches the rare spike that
+// never happens while a profiler is attached.
+//
+// The ring is allocated in init(). Recording a frame only writes into it;
+// only writing a report allocates (opening the file).
+//
+// Usage, per frame:
+//   FrameRecord &record = beginFrame();
+//   { FramePhaseZone zone(recorder, FramePhase::Build); ... }
+//   fill in record's counts, endFrame()
+class FlightRecorder {
+public:
+  bool init(const FlightRecorderSettings &settings);
+
+  FrameRecord &beginFrame();
+  void addPhase(FramePhase phase, Uint64 ns) {
+    current->phaseNS[(Uint32)phase] += ns;
+  }
+  void endFrame();
+
+  Uint32 hitchCount() const { return hitches; }
+
+private:
+  void writeReport();
+
+  FlightRecorderSettings settings;
+  Uint64 budgetNS = 0;
+  std::vector<FrameRecord> ring;
+  FrameRecord *current = nullptr;
+  Uint64 frame = 0;
+  Uint64 allocationsAtStart = 0;
+
+  Uint32 hitches = 0;
+  // The first hitch of the report waiting for its framesAfter, or ~0 when no
+  // report is pending.
+  Uint64 pendingHitchFrame = ~(Uint64)0;
+};
+
+// Times a phase into the recorder's current frame, and traces it under the
+// phase's name (or traceName) as well.
+class FramePhaseZone {
+public:
+  FramePhaseZone(FlightRecorder &recorder, FramePhase phase,
+                 const char *traceName = nullptr)
+      : recorder(recorder), phase(phase),
+        trace(traceName ? traceName : framePhaseName(phase)),
+        startNS(SDL_GetTicksNS()) {}
+  ~FramePhaseZone() { recorder.addPhase(phase, SDL_GetTicksNS() - startNS); }
+
+  FramePhaseZone(const FramePhaseZone &) = delete;
+  FramePhaseZone &operator=(const FramePhaseZone &) = delete;
+
+private:
+  FlightRecorder &recorder;
+  FramePhase phase;
+  TraceZone trace;
+  Uint64 startNS;
+};
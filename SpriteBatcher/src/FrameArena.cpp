@@ -0,0 +1,62 @@
+#include "FrameArena.hpp"
+
+#include "SDL3/SDL_log.h"
+
+bool FrameArena::init(Uint64 capacity) {
+  release();
+  size = capacity;
+  base = size > 0 ? (Uint8 *)SDL_aligned_alloc(64, size) : nullptr;
+  if (size > 0 && !base) {
+    SDL_Log("Failed to allocate a %" SDL_PRIu64 " byte frame arena", size);
+    size = 0;
+    return false;
+  }
+  return true;
+}
+
+void FrameArena::release() {
+  reset();
+  SDL_aligned_free(base);
+  base = nullptr;
+  size = 0;
+}
+
+void FrameArena::reset() {
+  peak = SDL_max(peak, frameBytes());
+  if (overflow) {
+    while (overflow) {
+      OverflowBlock *next = overflow->next;
+      SDL_aligned_free(overflow);
+      overflow = next;
+    }
+    // Grown to what the frame needed, plus some room for the frames that
+    // need a bit more, so a slowly growing scene doesn't grow every frame.
+    Uint64 newSize = frameBytes() + frameBytes() / 4;
+    SDL_aligned_free(base);
+    base = (Uint8 *)SDL_aligned_alloc(64, newSize);
+    size = base ? newSize : 0;
+    overflowBytes = 0;
+    grows++;
+  }
+  used = 0;
+}
+
+void *FrameArena::allocate(Uint64 bytes, Uint64 alignment) {
+  Uint64 offset = (used + alignment - 1) & ~(alignment - 1);
+  if (offset + bytes <= size) {
+    used = offset + bytes;
+    return base + offset;
+  }
+
+  // Doesn't fit. The frame carries on in a block of its own; reset() makes
+  // sure the next frame like it won't need one.
+  OverflowBlock *block =
+      (OverflowBlock *)SDL_aligned_alloc(64, OVERFLOW_HEADER + bytes);
+  if (!block) {
+    return nullptr;
+  }
+  block->next = overflow;
+  overflow = block;
+  overflowBytes += bytes;
+  return (Uint8 *)block + OVERFLOW_HEADER;
+}
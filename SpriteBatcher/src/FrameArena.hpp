@@ -0,0 +1,59 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+// Memory for data that only lives for one frame: radix sort scratch, the
+// indices of the sprites that survived culling, their draw order. Allocating
+// is bumping an offset; reset() at the start of the next frame frees all of
+// it at once.
+//
+// The arena starts at the capacity given to init(). A frame that needs more
+// gets the rest from separate heap blocks, and the next reset() replaces the
+// arena with one that fits that frame. After the largest frame has been seen
+// once, frames don't touch the heap at all.
+//
+// Only the thread that resets it may allocate. Workers can fill memory that
+// was allocated for them before they were started.
+class FrameArena {
+public:
+  FrameArena() = default;
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+  ~FrameArena() { release(); }
+
+  bool init(Uint64 capacity);
+  void release();
+
+  // Frees everything allocated since the last reset.
+  void reset();
+  // Never returns NULL unless the heap is exhausted. Alignment has to be a
+  // power of two, at most 64.
+  void *allocate(Uint64 size, Uint64 alignment = 16);
+  template <typename T> T *allocate(Uint32 count) {
+    return (T *)allocate((Uint64)count * sizeof(T), alignof(T));
+  }
+
+  // Bytes allocated since the last reset, overflow blocks included.
+  Uint64 frameBytes() const { return used + overflowBytes; }
+  // The most any frame has allocated.
+  Uint64 peakBytes() const { return peak; }
+  Uint64 capacity() const { return size; }
+  // How often a frame didn't fit and the arena had to grow.
+  Uint32 growCount() const { return grows; }
+
+private:
+  // Allocated when a frame outgrows the arena. The header is a whole cache
+  // line, so the memory after it stays 64 byte aligned.
+  struct OverflowBlock {
+    OverflowBlock *next;
+  };
+  static const Uint64 OVERFLOW_HEADER = 64;
+
+  Uint8 *base = nullptr;
+  Uint64 size = 0;
+  Uint64 used = 0;
+  OverflowBlock *overflow = nullptr;
+  Uint64 overflowBytes = 0;
+  Uint64 peak = 0;
+  Uint32 grows = 0;
+};
@@ -0,0 +1,130 @@
+#include "FrameLoop.hpp"
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Trace.hpp"
+
+bool FrameLoop::init(SDL_GPUDevice *device, const FrameLoopSettings &settings) {
+  this->device = device;
+  slotCount = SDL_clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+  frame = 0;
+  if (!SDL_SetGPUAllowedFramesInFlight(device, slotCount)) {
+    SDL_Log("Failed to set %u frames in flight: %s", slotCount,
+            SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+void FrameLoop::release() {
+  for (Uint32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    if (fences[i]) {
+      SDL_WaitForGPUFences(device, true, &fences[i], 1);
+      SDL_ReleaseGPUFence(device, fences[i]);
+      fences[i] = nullptr;
+    }
+  }
+}
+
+bool FrameLoop::ready() const {
+  SDL_GPUFence *fence = fences[frameSlot()];
+  return !fence || SDL_QueryGPUFence(device, fence);
+}
+
+// The GPU finished the slot's frame somewhere between the last check and
+// signalledNS. Checking every frame keeps that window short.
+void FrameLoop::retire(Uint32 slot, Uint64 signalledNS) {
+  traceRecordGPU("submit to fence observed", slot, submitNS[slot],
+                 signalledNS);
+  SDL_ReleaseGPUFence(device, fences[slot]);
+  fences[slot] = nullptr;
+}
+
+SDL_GPUCommandBuffer *FrameLoop::begin() {
+  frameStats = {};
+
+  Uint64 now = SDL_GetTicksNS();
+  for (Uint32 slot = 0; slot < slotCount; slot++) {
+    if (fences[slot] && SDL_QueryGPUFence(device, fences[slot])) {
+      retire(slot, now);
+    }
+  }
+
+  Uint32 slot = frameSlot();
+  if (fences[slot]) {
+    // Usually already signalled: the GPU had framesInFlight - 1 other frames
+    // worth of time to finish it. When it isn't, the CPU is ahead and this
+    // is where it idles.
+    SDL_WaitForGPUFences(device, true, &fences[slot], 1);
+    Uint64 signalledNS = SDL_GetTicksNS();
+    frameStats.fenceWaitNS = signalledNS - now;
+    retire(slot, signalledNS);
+  }
+
+  SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+  if (!commandBuffer) {
+    SDL_Log("Failed to acquire a command buffer: %s", SDL_GetError());
+  }
+  return commandBuffer;
+}
+
+bool FrameLoop::acquireSwapchainTexture(SDL_GPUCommandBuffer *commandBuffer,
+                                        SDL_Window *window,
+                                        SDL_GPUTexture **texture,
+                                        Uint32 *width, Uint32 *height,
+                                        bool wait) {
+  if (!wait) {
+    return SDL_AcquireGPUSwapchainTexture(commandBuffer, window, texture,
+                                          width, height);
+  }
+  Uint64 waitStart = SDL_GetTicksNS();
+  bool acquired = SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, window,
+                                                        texture, width, height);
+  frameStats.swapchainWaitNS = SDL_GetTicksNS() - waitStart;
+  return acquired;
+}
+
+bool FrameLoop::submit(SDL_GPUCommandBuffer *commandBuffer) {
+  // The slot's old fence was released in begin().
+  Uint32 slot = frameSlot();
+  submitNS[slot] = SDL_GetTicksNS();
+  fences[slot] = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+  frame++;
+  if (!fences[slot]) {
+    SDL_Log("Failed to submit frame: %s", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+void FrameLoop::cancel(SDL_GPUCommandBuffer *commandBuffer) {
+  SDL_CancelGPUCommandBuffer(commandBuffer);
+}
+
+bool setPresentMode(SDL_GPUDevice *device, SDL_Window *window,
+                    SDL_GPUPresentMode mode) {
+  if (!SDL_WindowSupportsGPUPresentMode(device, window, mode)) {
+    SDL_Log("Present mode %s is not supported", presentModeName(mode));
+    return false;
+  }
+  if (!SDL_SetGPUSwapchainParameters(device, window,
+                                     SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode)) {
+    SDL_Log("Failed to set present mode %s: %s", presentModeName(mode),
+            SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+const char *presentModeName(SDL_GPUPresentMode mode) {
+  switch (mode) {
+  case SDL_GPU_PRESENTMODE_VSYNC:
+    return "vsync";
+  case SDL_GPU_PRESENTMODE_MAILBOX:
+    return "mailbox";
+  case SDL_GPU_PRESENTMODE_IMMEDIATE:
+    return "immediate";
+  }
+  return "unknown";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_video.h"
+
+// SDL doesn't allow more than three.
+static const Uint32 MAX_FRAMES_IN_FLIGHT = 3;
+
+// Where the CPU sat waiting for the GPU during the current frame.
+struct FrameLoopStats {
+  // Waiting for the fence of the frame that used this frame's slot before.
+  Uint64 fenceWaitNS;
+  // Waiting in SDL_WaitAndAcquireGPUSwapchainTexture. Always 0 with the
+  // non-blocking acquire.
+  Uint64 swapchainWaitNS;
+};
+
+struct FrameLoopSettings {
+  // How many frames the CPU may record while the GPU still works on earlier
+  // ones. 1 means every frame waits for the previous one to finish.
+  Uint32 framesInFlight = 2;
+};
+
+// Submits every frame with a fence and keeps the fences of the last
+// framesInFlight frames. Before a frame starts, the fence of the frame that
+// last used the same slot is waited on, so anything indexed by frameSlot()
+// (transfer buffers, per-frame scratch) is no longer read by the GPU and can
+// be overwritten without cycling.
+//
+// Usage, per frame:
+//   commandBuffer = begin()
+//   acquireSwapchainTexture(...), record with frameSlot()
+//   submit(commandBuffer), or cancel(commandBuffer) if there was no texture
+//
+// A loop that must never block checks ready() before begin() and uses the
+// non-blocking acquire.
+class FrameLoop {
+public:
+  // Also sets SDL_SetGPUAllowedFramesInFlight, so the swapchain doesn't queue
+  // more frames than there are slots.
+  bool init(SDL_GPUDevice *device, const FrameLoopSettings &settings);
+  // Waits for every frame still in flight.
+  void release();
+
+  // True when begin() wouldn't wait, i.e. this slot's previous frame is done.
+  bool ready() const;
+  // Waits for this slot's previous frame, then acquires the command buffer.
+  SDL_GPUCommandBuffer *begin();
+  // With wait = false, SDL_AcquireGPUSwapchainTexture is used, which gives
+  // back a NULL texture instead of blocking when no image is free.
+  bool acquireSwapchainTexture(SDL_GPUCommandBuffer *commandBuffer,
+                               SDL_Window *window, SDL_GPUTexture **texture,
+                               Uint32 *width, Uint32 *height, bool wait = true);
+  bool submit(SDL_GPUCommandBuffer *commandBuffer);
+  // Drops a frame that has nothing to present. The slot is reused by the
+  // next begin().
+  void cancel(SDL_GPUCommandBuffer *commandBuffer);
+
+  // In [0, framesInFlight()). Stays the same from begin() to submit().
+  Uint32 frameSlot() const { return (Uint32)(frame % slotCount); }
+  Uint32 framesInFlight() const { return slotCount; }
+  const FrameLoopStats &stats() const { return frameStats; }
+
+private:
+  SDL_GPUDevice *device = nullptr;
+  Uint32 slotCount = 1;
+  // Frames submitted so far.
+  Uint64 frame = 0;
+  SDL_GPUFence *fences[MAX_FRAMES_IN_FLIGHT] = {};
+  // When each slot's frame was submitted, for the trace's GPU track.
+  Uint64 submitNS[MAX_FRAMES_IN_FLIGHT] = {};
+
+  void retire(Uint32 slot, Uint64 signalledNS);
+
+  FrameLoopStats frameStats{};
+};
+
+// Switches the window's swapchain to another present mode. VSYNC is always
+// supported; MAILBOX and IMMEDIATE don't wait for the vertical blank but
+// depend on the driver. Returns false (and keeps the old mode) when the
+// window doesn't support it.
+bool setPresentMode(SDL_GPUDevice *device, SDL_Window *window,
+                    SDL_GPUPresentMode mode);
+const char *presentModeName(SDL_GPUPresentMode mode);
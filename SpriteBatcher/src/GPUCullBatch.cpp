@@ -0,0 +1,218 @@
+#include "GPUCullBatch.hpp"
+
+#include "SDL3/SDL_log.h"
+
+#include "SpriteCulling.hpp"
+#include "SpritePipeline.hpp"
+
+// Has to match local_size_x in cull.comp and cull_scan.comp.
+static const Uint32 CULL_GROUP_SIZE = 256;
+
+// Must match CullUniforms in shaders/cull.comp (std140).
+struct CullUniforms {
+  float xRow[4];
+  float yRow[4];
+  float ndcRadiusX;
+  float ndcRadiusY;
+  float minWorldSize;
+  Uint32 count;
+};
+static_assert(sizeof(CullUniforms) == 48,
+              "CullUniforms must match the shader's std140 layout");
+
+// Must match ScanUniforms in shaders/cull_scan.comp. std140 rounds a uniform
+// block up to 16 bytes.
+struct ScanUniforms {
+  Uint32 groupCount;
+  Uint32 padding[3];
+};
+
+bool GPUCullBatch::init(SDL_GPUDevice *device,
+                        const GPUCullBatchSettings &settings) {
+  this->device = device;
+  capacity = SDL_max(settings.capacity, 1u);
+  minPixelSize = settings.minPixelSize;
+  spriteCount = 0;
+
+  countPipeline = loadComputePipeline(device, "shaders/cull_count.comp.spv", 1,
+                                      1, 1, CULL_GROUP_SIZE);
+  scanPipeline = loadComputePipeline(device, "shaders/cull_scan.comp.spv", 0,
+                                     2, 1, CULL_GROUP_SIZE);
+  writePipeline = loadComputePipeline(device, "shaders/cull_write.comp.spv", 2,
+                                      1, 1, CULL_GROUP_SIZE);
+
+  SDL_GPUBufferCreateInfo spriteInfo{};
+  spriteInfo.size = capacity * sizeof(SpriteData);
+  spriteInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ;
+  sprites = SDL_CreateGPUBuffer(device, &spriteInfo);
+
+  SDL_GPUBufferCreateInfo visibleInfo{};
+  visibleInfo.size = capacity * sizeof(SpriteData);
+  visibleInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE |
+                      SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  visible = SDL_CreateGPUBuffer(device, &visibleInfo);
+
+  SDL_GPUBufferCreateInfo groupInfo{};
+  groupInfo.size =
+      (capacity + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE * sizeof(Uint32);
+  groupInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ |
+                    SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+  groupCounts = SDL_CreateGPUBuffer(device, &groupInfo);
+
+  SDL_GPUBufferCreateInfo indirectInfo{};
+  indirectInfo.size = sizeof(SDL_GPUIndirectDrawCommand);
+  indirectInfo.usage = SDL_GPU_BUFFERUSAGE_INDIRECT |
+                       SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+  indirect = SDL_CreateGPUBuffer(device, &indirectInfo);
+
+  if (!countPipeline || !scanPipeline || !writePipeline || !sprites ||
+      !visible || !groupCounts || !indirect) {
+    SDL_Log("Failed to create the GPU cull batch: %s", SDL_GetError());
+    release();
+    return false;
+  }
+  return true;
+}
+
+void GPUCullBatch::release() {
+  if (!device) {
+    return;
+  }
+  SDL_ReleaseGPUComputePipeline(device, countPipeline);
+  SDL_ReleaseGPUComputePipeline(device, scanPipeline);
+  SDL_ReleaseGPUComputePipeline(device, writePipeline);
+  SDL_ReleaseGPUBuffer(device, sprites);
+  SDL_ReleaseGPUBuffer(device, visible);
+  SDL_ReleaseGPUBuffer(device, groupCounts);
+  SDL_ReleaseGPUBuffer(device, indirect);
+  countPipeline = scanPipeline = writePipeline = nullptr;
+  sprites = visible = groupCounts = indirect = nullptr;
+}
+
+bool GPUCullBatch::upload(SDL_GPUCommandBuffer *commandBuffer, Uint32 first,
+                          const SpriteData *data, Uint32 count) {
+  if (count == 0) {
+    return true;
+  }
+  if (first + count > capacity) {
+    SDL_Log("GPU cull batch: %u sprites don't fit, capacity is %u",
+            first + count, capacity);
+    return false;
+  }
+
+  // Uploads are rare, so the transfer buffer is made for each one. SDL keeps
+  // it alive until the copy is done.
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = count * sizeof(SpriteData);
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  SDL_GPUTransferBuffer *transferBuffer =
+      SDL_CreateGPUTransferBuffer(device, &transferInfo);
+  if (!transferBuffer) {
+    SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+  void *mapped = SDL_MapGPUTransferBuffer(device, transferBuffer, false);
+  SDL_memcpy(mapped, data, count * sizeof(SpriteData));
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  SDL_GPUTransferBufferLocation source{};
+  source.transfer_buffer = transferBuffer;
+  SDL_GPUBufferRegion destination{};
+  destination.buffer = sprites;
+  destination.offset = first * sizeof(SpriteData);
+  destination.size = count * sizeof(SpriteData);
+  // Not cycled: the sprites outside the range must survive.
+  SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+  SDL_EndGPUCopyPass(copyPass);
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+
+  spriteCount = SDL_max(spriteCount, first + count);
+  return true;
+}
+
+void GPUCullBatch::cull(SDL_GPUCommandBuffer *commandBuffer,
+                        const float viewProjection[16], float viewportWidth,
+                        float viewportHeight) {
+  if (!device) {
+    return;
+  }
+
+  // All zeros keeps every sprite.
+  CullParams params{};
+  makeCullParams(viewProjection, viewportWidth, viewportHeight, minPixelSize,
+                 params);
+  CullUniforms cullUniforms;
+  SDL_memcpy(cullUniforms.xRow, params.xRow, sizeof(cullUniforms.xRow));
+  SDL_memcpy(cullUniforms.yRow, params.yRow, sizeof(cullUniforms.yRow));
+  cullUniforms.ndcRadiusX = params.ndcRadiusX;
+  cullUniforms.ndcRadiusY = params.ndcRadiusY;
+  cullUniforms.minWorldSize = params.minWorldSize;
+  cullUniforms.count = spriteCount;
+
+  Uint32 groups = (spriteCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+  ScanUniforms scanUniforms{};
+  scanUniforms.groupCount = groups;
+
+  // Dispatches within a compute pass aren't synchronized with each other,
+  // so every step that reads the previous one's output gets its own pass.
+  //
+  // The visible buffer and the indirect command are rewritten completely
+  // every frame, so they are cycled and the previous frame's draw can keep
+  // its copies. The group counts only live between the passes of one frame.
+  if (groups > 0) {
+    SDL_GPUStorageBufferReadWriteBinding countBinding{};
+    countBinding.buffer = groupCounts;
+    SDL_GPUComputePass *computePass =
+        SDL_BeginGPUComputePass(commandBuffer, NULL, 0, &countBinding, 1);
+    SDL_BindGPUComputePipeline(computePass, countPipeline);
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, &sprites, 1);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &cullUniforms,
+                                  sizeof(CullUniforms));
+    SDL_DispatchGPUCompute(computePass, groups, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+  }
+
+  // Also runs without sprites, to write an empty draw.
+  {
+    SDL_GPUStorageBufferReadWriteBinding scanBindings[2]{};
+    scanBindings[0].buffer = groupCounts;
+    scanBindings[1].buffer = indirect;
+    scanBindings[1].cycle = true;
+    SDL_GPUComputePass *computePass =
+        SDL_BeginGPUComputePass(commandBuffer, NULL, 0, scanBindings, 2);
+    SDL_BindGPUComputePipeline(computePass, scanPipeline);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &scanUniforms,
+                                  sizeof(ScanUniforms));
+    SDL_DispatchGPUCompute(computePass, 1, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+  }
+
+  if (groups > 0) {
+    SDL_GPUStorageBufferReadWriteBinding writeBinding{};
+    writeBinding.buffer = visible;
+    writeBinding.cycle = true;
+    SDL_GPUComputePass *computePass =
+        SDL_BeginGPUComputePass(commandBuffer, NULL, 0, &writeBinding, 1);
+    SDL_BindGPUComputePipeline(computePass, writePipeline);
+    SDL_GPUBuffer *readBuffers[2] = {sprites, groupCounts};
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, readBuffers, 2);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &cullUniforms,
+                                  sizeof(CullUniforms));
+    SDL_DispatchGPUCompute(computePass, groups, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+  }
+}
+
+void GPUCullBatch::render(SDL_GPURenderPass *renderPass,
+                          SDL_GPUGraphicsPipeline *pipeline,
+                          const SDL_GPUTextureSamplerBinding &texture) {
+  if (!device) {
+    return;
+  }
+  SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+  SDL_BindGPUVertexStorageBuffers(renderPass, 0, &visible, 1);
+  SDL_BindGPUFragmentSamplers(renderPass, 0, &texture, 1);
+  // The vertex count is whatever cull() left in the buffer.
+  SDL_DrawGPUPrimitivesIndirect(renderPass, indirect, 0, 1);
+}
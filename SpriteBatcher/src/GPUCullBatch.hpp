@@ -0,0 +1,71 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+
+struct GPUCullBatchSettings {
+  // Sprites the buffers are created for. upload() can't go past it.
+  Uint32 capacity = 1024;
+  // Same as SpriteBatchSettings::minPixelSize.
+  float minPixelSize = 0.5f;
+};
+
+// Sprites that stay in GPU memory and are culled there. SpriteBatch pays for
+// every sprite on the CPU every frame: cull, sort, pack, upload. For a big
+// world that barely changes, that is all wasted work. Here the sprites are
+// uploaded once, in draw order, and each frame cull() records three compute
+// passes (cull.comp, cull_scan.comp, cull.comp again) that copy the visible
+// ones into a second buffer, in the same order, and write the
+// SDL_GPUIndirectDrawCommand that render() draws them with. The CPU never
+// learns how many there were.
+//
+// Everything is drawn with one pipeline and one texture binding, so the
+// sprites should share a texture array (see TextureAtlas).
+//
+// Usage:
+//   upload(commandBuffer, ...) once, and again for the sprites that change
+//   per frame: cull(commandBuffer, ...)   outside any render or copy pass
+//              render(renderPass, ...)    ViewProjectionMatrix pushed
+class GPUCullBatch {
+public:
+  bool init(SDL_GPUDevice *device, const GPUCullBatchSettings &settings);
+  void release();
+
+  // Copies sprites to [first, first + count) of the sprite buffer, in a copy
+  // pass of its own. Sprites are drawn in buffer order. The batch holds
+  // max(first + count) sprites from then on.
+  bool upload(SDL_GPUCommandBuffer *commandBuffer, Uint32 first,
+              const SpriteData *sprites, Uint32 count);
+  void clear() { spriteCount = 0; }
+
+  // viewProjection is column-major, like the uniform. Only orthographic
+  // projections can be culled; with anything else every sprite is drawn.
+  void cull(SDL_GPUCommandBuffer *commandBuffer, const float viewProjection[16],
+            float viewportWidth, float viewportHeight);
+  void render(SDL_GPURenderPass *renderPass, SDL_GPUGraphicsPipeline *pipeline,
+              const SDL_GPUTextureSamplerBinding &texture);
+
+  Uint32 count() const { return spriteCount; }
+  // For reading back what the last cull() did.
+  SDL_GPUBuffer *visibleBuffer() const { return visible; }
+  SDL_GPUBuffer *indirectBuffer() const { return indirect; }
+
+private:
+  SDL_GPUDevice *device = nullptr;
+  SDL_GPUComputePipeline *countPipeline = nullptr;
+  SDL_GPUComputePipeline *scanPipeline = nullptr;
+  SDL_GPUComputePipeline *writePipeline = nullptr;
+  // All of them, in draw order. Only read by the compute passes.
+  SDL_GPUBuffer *sprites = nullptr;
+  // The visible ones, bound to vertex.vert like SpriteBatch's buffer.
+  SDL_GPUBuffer *visible = nullptr;
+  // Per workgroup of cull.comp: its visible count, then its offset.
+  SDL_GPUBuffer *groupCounts = nullptr;
+  // One SDL_GPUIndirectDrawCommand.
+  SDL_GPUBuffer *indirect = nullptr;
+  Uint32 capacity = 0;
+  Uint32 spriteCount = 0;
+  float minPixelSize = 0.0f;
+};
@@ -0,0 +1,135 @@
+#include "GeometryProbe.hpp"
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Mat4.hpp"
+#include "SpriteBatch.hpp"
+
+// Uploads the sprites once, then renders the batch frame after frame
+// without touching it again: render() only needs what the last upload()
+// left behind. The copy would otherwise be most of what gets timed.
+static bool timeGeometry(SDL_GPUDevice *device, SDL_GPUTexture *target,
+                         SDL_GPUGraphicsPipeline *pipeline,
+                         const SDL_GPUTextureSamplerBinding &texture,
+                         SpriteLayout layout, SpriteGeometry geometry,
+                         const GeometryProbeSettings &settings,
+                         Uint64 &bestNS) {
+  SpriteBatch batch;
+  SpriteBatchSettings batchSettings;
+  batchSettings.capacity = settings.sprites;
+  batchSettings.layout = layout;
+  batchSettings.geometry = geometry;
+  batchSettings.cull = false;
+  if (!batch.init(device, batchSettings)) {
+    return false;
+  }
+  batch.addPipeline(pipeline);
+  batch.addTexture(texture);
+
+  // The same sprites for both geometries.
+  Uint64 seed = 1;
+  batch.begin();
+  for (Uint32 i = 0; i < settings.sprites; i++) {
+    SpriteData sprite{};
+    sprite.x = SDL_randf_r(&seed) * settings.targetWidth;
+    sprite.y = SDL_randf_r(&seed) * settings.targetHeight;
+    sprite.rotation = SDL_randf_r(&seed) * 2.0f * SDL_PI_F;
+    sprite.w = settings.spriteSize;
+    sprite.h = settings.spriteSize;
+    sprite.texW = 1.0f;
+    sprite.texH = 1.0f;
+    sprite.r = sprite.g = sprite.b = sprite.a = 1.0f;
+    batch.draw(sprite);
+  }
+
+  // Pixel coordinates over the target, origin at the top left.
+  Mat4 viewProjection =
+      mat4Orthographic(0.0f, (float)settings.targetWidth,
+                       (float)settings.targetHeight, 0.0f, 0.0f, -1.0f);
+
+  bestNS = ~(Uint64)0;
+  bool ok = true;
+  for (int frame = 0; frame < 1 + settings.frames && ok; frame++) {
+    SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (!commandBuffer) {
+      ok = false;
+      break;
+    }
+    if (frame == 0 && !batch.upload(commandBuffer)) {
+      SDL_CancelGPUCommandBuffer(commandBuffer);
+      ok = false;
+      break;
+    }
+
+    SDL_GPUColorTargetInfo colorTargetInfo{};
+    colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+    colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+    colorTargetInfo.texture = target;
+    SDL_GPURenderPass *renderPass =
+        SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+    SDL_PushGPUVertexUniformData(commandBuffer, 0, viewProjection.m,
+                                 sizeof(viewProjection.m));
+    batch.render(renderPass);
+    SDL_EndGPURenderPass(renderPass);
+
+    Uint64 start = SDL_GetTicksNS();
+    SDL_GPUFence *fence =
+        SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    ok = fence && SDL_WaitForGPUFences(device, true, &fence, 1);
+    Uint64 elapsed = SDL_GetTicksNS() - start;
+    SDL_ReleaseGPUFence(device, fence);
+
+    // The first frame carries the upload.
+    if (frame > 0 && elapsed < bestNS) {
+      bestNS = elapsed;
+    }
+  }
+  batch.release();
+  return ok;
+}
+
+bool probeSpriteGeometry(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                         SpriteLayout layout, SpriteTexturing texturing,
+                         const GeometryProbeSettings &settings,
+                         GeometryProbeResult &out) {
+  SDL_GPUTextureCreateInfo targetInfo{};
+  targetInfo.type = SDL_GPU_TEXTURETYPE_2D;
+  targetInfo.format = colorFormat;
+  targetInfo.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+  targetInfo.width = settings.targetWidth;
+  targetInfo.height = settings.targetHeight;
+  targetInfo.layer_count_or_depth = 1;
+  targetInfo.num_levels = 1;
+  SDL_GPUTexture *target = SDL_CreateGPUTexture(device, &targetInfo);
+  SDL_GPUTexture *texture = createWhiteTexture(device, texturing);
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  SDL_GPUSampler *sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+  SDL_GPUGraphicsPipeline *pulling =
+      createSpritePipeline(device, colorFormat, layout, texturing,
+                           SpriteGeometry::VertexPulling);
+  SDL_GPUGraphicsPipeline *instanced = createSpritePipeline(
+      device, colorFormat, layout, texturing, SpriteGeometry::Instanced);
+
+  bool ok = target && texture && sampler && pulling && instanced;
+  if (!ok) {
+    SDL_Log("Failed to create the geometry probe: %s", SDL_GetError());
+  }
+  SDL_GPUTextureSamplerBinding binding{texture, sampler};
+  ok = ok &&
+       timeGeometry(device, target, pulling, binding, layout,
+                    SpriteGeometry::VertexPulling, settings,
+                    out.vertexPullingNS) &&
+       timeGeometry(device, target, instanced, binding, layout,
+                    SpriteGeometry::Instanced, settings, out.instancedNS);
+  out.fastest = ok && out.instancedNS < out.vertexPullingNS
+                    ? SpriteGeometry::Instanced
+                    : SpriteGeometry::VertexPulling;
+
+  SDL_ReleaseGPUGraphicsPipeline(device, pulling);
+  SDL_ReleaseGPUGraphicsPipeline(device, instanced);
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUTexture(device, texture);
+  SDL_ReleaseGPUTexture(device, target);
+  return ok;
+}
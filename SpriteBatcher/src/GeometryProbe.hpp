@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+#include "SpritePipeline.hpp"
+
+struct GeometryProbeSettings {
+  // Small sprites, so the vertex work outweighs the fill.
+  Uint32 sprites = 100000;
+  float spriteSize = 4.0f;
+  // Measured frames per geometry, after one warmup frame.
+  int frames = 5;
+  Uint32 targetWidth = 1024;
+  Uint32 targetHeight = 1024;
+};
+
+struct GeometryProbeResult {
+  // GPU time of the fastest frame, from submit until its fence signalled.
+  Uint64 vertexPullingNS;
+  Uint64 instancedNS;
+  SpriteGeometry fastest;
+};
+
+// Which SpriteGeometry is faster depends on the driver: some pay for the
+// divide and the table lookup per vertex, others for small instances. This
+// draws the same sprites with both into an offscreen target and times them.
+// Meant to run once at startup; it takes a few frames' worth of GPU time.
+//
+// colorFormat, layout and texturing should be the ones the real pipeline
+// is created with. Returns false (and logs) when the resources couldn't be
+// created.
+bool probeSpriteGeometry(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                         SpriteLayout layout, SpriteTexturing texturing,
+                         const GeometryProbeSettings &settings,
+                         GeometryProbeResult &out);
@@ -0,0 +1,35 @@
+#include "LatencyStats.hpp"
+
+#include <algorithm>
+
+void LatencyStats::add(Uint64 ns) {
+  samples[next] = ns;
+  next = (next + 1) % SAMPLE_COUNT;
+  filled = SDL_min(filled + 1, SAMPLE_COUNT);
+}
+
+void LatencyStats::clear() {
+  next = 0;
+  filled = 0;
+}
+
+// Nearest rank. With few samples the high percentiles are simply the
+// largest ones.
+LatencySummary LatencyStats::summarize() {
+  LatencySummary summary{};
+  summary.count = filled;
+  if (filled == 0) {
+    return summary;
+  }
+  SDL_memcpy(sorted, samples, filled * sizeof(Uint64));
+  std::sort(sorted, sorted + filled);
+  auto rank = [&](Uint32 percent) {
+    Uint32 index = (filled * percent + 99) / 100;
+    return sorted[SDL_clamp(index, 1u, filled) - 1];
+  };
+  summary.p50NS = rank(50);
+  summary.p95NS = rank(95);
+  summary.p99NS = rank(99);
+  summary.maxNS = sorted[filled - 1];
+  return summary;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+// Percentiles over the most recent samples, in nanoseconds.
+struct LatencySummary {
+  Uint32 count;
+  Uint64 p50NS;
+  Uint64 p95NS;
+  Uint64 p99NS;
+  Uint64 maxNS;
+};
+
+// Keeps the last SAMPLE_COUNT latencies in a fixed ring, so adding a sample
+// never allocates. summarize() sorts a copy; it's meant to be called about
+// once a second, not per sample.
+class LatencyStats {
+public:
+  static const Uint32 SAMPLE_COUNT = 1024;
+
+  void add(Uint64 ns);
+  void clear();
+  Uint32 count() const { return filled; }
+  LatencySummary summarize();
+
+private:
+  Uint64 samples[SAMPLE_COUNT];
+  Uint64 sorted[SAMPLE_COUNT];
+  Uint32 next = 0;
+  Uint32 filled = 0;
+};
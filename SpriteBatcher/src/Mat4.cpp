@@ -0,0 +1,162 @@
+#include "Mat4.hpp"
+
+#include "SpriteSimd.hpp"
+
+#include <cmath>
+
+// SSE2 is part of x86-64, so unlike the pack and cull kernels these need no
+// runtime detection.
+
+Mat4 mat4Identity() {
+  Mat4 out{};
+  out.m[0] = out.m[5] = out.m[10] = out.m[15] = 1.0f;
+  return out;
+}
+
+Mat4 mat4Orthographic(float left, float right, float bottom, float top,
+                      float zNear, float zFar) {
+  Mat4 out{};
+  out.m[0] = 2.0f / (right - left);
+  out.m[5] = 2.0f / (top - bottom);
+  out.m[10] = 1.0f / (zNear - zFar);
+  out.m[12] = (left + right) / (left - right);
+  out.m[13] = (top + bottom) / (bottom - top);
+  out.m[14] = zNear / (zNear - zFar);
+  out.m[15] = 1.0f;
+  return out;
+}
+
+Mat4 mat4Translation(float x, float y, float z) {
+  Mat4 out = mat4Identity();
+  out.m[12] = x;
+  out.m[13] = y;
+  out.m[14] = z;
+  return out;
+}
+
+Mat4 mat4Scale(float x, float y, float z) {
+  Mat4 out{};
+  out.m[0] = x;
+  out.m[5] = y;
+  out.m[10] = z;
+  out.m[15] = 1.0f;
+  return out;
+}
+
+Mat4 mat4RotationZ(float radians) {
+  float c = std::cos(radians);
+  float s = std::sin(radians);
+  Mat4 out = mat4Identity();
+  out.m[0] = c;
+  out.m[1] = s;
+  out.m[4] = -s;
+  out.m[5] = c;
+  return out;
+}
+
+Mat4 mat4Multiply(const Mat4 &a, const Mat4 &b) {
+  Mat4 out;
+#ifdef SPRITE_SIMD_X86
+  // Column c of the result is a's columns weighted by column c of b.
+  __m128 a0 = _mm_load_ps(a.m);
+  __m128 a1 = _mm_load_ps(a.m + 4);
+  __m128 a2 = _mm_load_ps(a.m + 8);
+  __m128 a3 = _mm_load_ps(a.m + 12);
+  for (int c = 0; c < 4; c++) {
+    const float *column = b.m + c * 4;
+    __m128 result = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+    result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+    result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+    result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+    _mm_store_ps(out.m + c * 4, result);
+  }
+#else
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      out.m[c * 4 + r] = a.m[r] * b.m[c * 4] + a.m[4 + r] * b.m[c * 4 + 1] +
+                         a.m[8 + r] * b.m[c * 4 + 2] +
+                         a.m[12 + r] * b.m[c * 4 + 3];
+    }
+  }
+#endif
+  return out;
+}
+
+// The usual expansion into 2x2 sub-determinants (as in MESA's gluInvertMatrix,
+// written out over pairs of rows). Runs when the camera changes, not per
+// sprite, so it stays scalar.
+bool mat4Inverse(const Mat4 &matrix, Mat4 &out) {
+  const float *m = matrix.m;
+  float s0 = m[0] * m[5] - m[4] * m[1];
+  float s1 = m[0] * m[9] - m[8] * m[1];
+  float s2 = m[0] * m[13] - m[12] * m[1];
+  float s3 = m[4] * m[9] - m[8] * m[5];
+  float s4 = m[4] * m[13] - m[12] * m[5];
+  float s5 = m[8] * m[13] - m[12] * m[9];
+  float c5 = m[10] * m[15] - m[14] * m[11];
+  float c4 = m[6] * m[15] - m[14] * m[7];
+  float c3 = m[6] * m[11] - m[10] * m[7];
+  float c2 = m[2] * m[15] - m[14] * m[3];
+  float c1 = m[2] * m[11] - m[10] * m[3];
+  float c0 = m[2] * m[7] - m[6] * m[3];
+
+  float determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  if (determinant == 0.0f || !std::isfinite(determinant)) {
+    return false;
+  }
+  float d = 1.0f / determinant;
+
+  // Indices are (column * 4 + row), so this is the transposed cofactor
+  // matrix of the row-major write-ups.
+  Mat4 result;
+  float *r = result.m;
+  r[0] = (m[5] * c5 - m[9] * c4 + m[13] * c3) * d;
+  r[4] = (-m[4] * c5 + m[8] * c4 - m[12] * c3) * d;
+  r[8] = (m[7] * s5 - m[11] * s4 + m[15] * s3) * d;
+  r[12] = (-m[6] * s5 + m[10] * s4 - m[14] * s3) * d;
+
+  r[1] = (-m[1] * c5 + m[9] * c2 - m[13] * c1) * d;
+  r[5] = (m[0] * c5 - m[8] * c2 + m[12] * c1) * d;
+  r[9] = (-m[3] * s5 + m[11] * s2 - m[15] * s1) * d;
+  r[13] = (m[2] * s5 - m[10] * s2 + m[14] * s1) * d;
+
+  r[2] = (m[1] * c4 - m[5] * c2 + m[13] * c0) * d;
+  r[6] = (-m[0] * c4 + m[4] * c2 - m[12] * c0) * d;
+  r[10] = (m[3] * s4 - m[7] * s2 + m[15] * s0) * d;
+  r[14] = (-m[2] * s4 + m[6] * s2 - m[14] * s0) * d;
+
+  r[3] = (-m[1] * c3 + m[5] * c1 - m[9] * c0) * d;
+  r[7] = (m[0] * c3 - m[4] * c1 + m[8] * c0) * d;
+  r[11] = (-m[3] * s3 + m[7] * s1 - m[11] * s0) * d;
+  r[15] = (m[2] * s3 - m[6] * s1 + m[10] * s0) * d;
+  out = result;
+  return true;
+}
+
+void mat4TransformPoints(const Mat4 &matrix, const float *x, const float *y,
+                         Uint32 count, float *outX, float *outY) {
+  const float *m = matrix.m;
+  Uint32 i = 0;
+#ifdef SPRITE_SIMD_X86
+  __m128 m0 = _mm_set1_ps(m[0]), m4 = _mm_set1_ps(m[4]);
+  __m128 m12 = _mm_set1_ps(m[12]);
+  __m128 m1 = _mm_set1_ps(m[1]), m5 = _mm_set1_ps(m[5]);
+  __m128 m13 = _mm_set1_ps(m[13]);
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i);
+    __m128 py = _mm_loadu_ps(y + i);
+    // Same order of operations as mat4TransformPoint, so both give the same
+    // bits.
+    __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m4, py)),
+                           m12);
+    __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, px), _mm_mul_ps(m5, py)),
+                           m13);
+    _mm_storeu_ps(outX + i, rx);
+    _mm_storeu_ps(outY + i, ry);
+  }
+#endif
+  for (; i < count; i++) {
+    float px = x[i], py = y[i];
+    mat4TransformPoint(matrix, px, py, outX[i], outY[i]);
+  }
+}
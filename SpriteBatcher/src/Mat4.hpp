@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+// A 4x4 float matrix, column-major like GLSL's mat4, so m can be pushed as
+// the ViewProjectionMatrix uniform as is. Element (row r, column c) is
+// m[c * 4 + r]. Aligned so the SSE code can load whole columns.
+struct alignas(16) Mat4 {
+  float m[16];
+};
+
+Mat4 mat4Identity();
+// Same as System.Numerics' CreateOrthographicOffCenter, which the Moonside
+// tutorial uses. Depth ends up in [0, 1].
+Mat4 mat4Orthographic(float left, float right, float bottom, float top,
+                      float zNear, float zFar);
+Mat4 mat4Translation(float x, float y, float z);
+Mat4 mat4Scale(float x, float y, float z);
+// Counter-clockwise in a y-up space, which is clockwise on a y-down screen.
+Mat4 mat4RotationZ(float radians);
+
+// a * b: transforming with the result applies b first, then a. Four column
+// broadcasts per column with SSE, plain loops elsewhere.
+Mat4 mat4Multiply(const Mat4 &a, const Mat4 &b);
+// General inverse by cofactors. Returns false (and leaves out alone) when
+// the matrix is singular.
+bool mat4Inverse(const Mat4 &matrix, Mat4 &out);
+
+// Transforms the point (x, y, 0, 1). Only for affine matrices: w is assumed
+// to stay 1, which holds for everything an orthographic camera builds.
+inline void mat4TransformPoint(const Mat4 &matrix, float x, float y,
+                               float &outX, float &outY) {
+  const float *m = matrix.m;
+  outX = m[0] * x + m[4] * y + m[12];
+  outY = m[1] * x + m[5] * y + m[13];
+}
+// The same for count points, as separate x and y arrays (like SpriteStore).
+// Four points per step with SSE. out may be the same arrays as in.
+void mat4TransformPoints(const Mat4 &matrix, const float *x, const float *y,
+                         Uint32 count, float *outX, float *outY);
@@ -0,0 +1,150 @@
+#include "ParticleSystem.hpp"
+
+#include "SDL3/SDL_log.h"
+
+#include "SpriteData.hpp"
+#include "SpritePipeline.hpp"
+
+// Has to match local_size_x in particles.comp.
+static const Uint32 PARTICLE_GROUP_SIZE = 64;
+
+// Must match ParticleUniforms in shaders/particles.comp (std140).
+struct ParticleUniforms {
+  float emitter[2];
+  float deltaTime;
+  Uint32 count;
+  float gravity[2];
+  float speed;
+  float spread;
+  float direction;
+  float lifetime;
+  float size;
+  float depth;
+  float texRect[4];
+  float startColor[4];
+  float endColor[4];
+  float textureLayer;
+  Uint32 seed;
+  Uint32 reset;
+  float shape;
+};
+static_assert(sizeof(ParticleUniforms) == 112,
+              "ParticleUniforms must match the shader's std140 layout");
+
+bool ParticleSystem::init(SDL_GPUDevice *device,
+                          const ParticleSystemSettings &settings) {
+  this->device = device;
+  particleSettings = settings;
+  reset = true;
+
+  // Particles at set 1, binding 0 and sprites at set 1, binding 1. Both are
+  // read-write as far as SDL is concerned.
+  pipeline = loadComputePipeline(device, "shaders/particles.comp.spv", 0, 2, 1,
+                                 PARTICLE_GROUP_SIZE);
+
+  // Never touched by the CPU. The first update() spawns every particle, so
+  // the buffer doesn't need initial contents either.
+  SDL_GPUBufferCreateInfo particleInfo{};
+  particleInfo.size = settings.count * sizeof(GPUParticle);
+  particleInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ |
+                       SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+  particles = SDL_CreateGPUBuffer(device, &particleInfo);
+
+  // Written by the compute pass, read by vertex.vert.
+  SDL_GPUBufferCreateInfo spriteInfo{};
+  spriteInfo.size = settings.count * sizeof(SpriteData);
+  spriteInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE |
+                     SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  sprites = SDL_CreateGPUBuffer(device, &spriteInfo);
+
+  if (!pipeline || !particles || !sprites) {
+    SDL_Log("Failed to create the particle system: %s", SDL_GetError());
+    release();
+    return false;
+  }
+  return true;
+}
+
+void ParticleSystem::release() {
+  if (!device) {
+    return;
+  }
+  SDL_ReleaseGPUComputePipeline(device, pipeline);
+  SDL_ReleaseGPUBuffer(device, particles);
+  SDL_ReleaseGPUBuffer(device, sprites);
+  pipeline = nullptr;
+  particles = nullptr;
+  sprites = nullptr;
+}
+
+void ParticleSystem::update(SDL_GPUCommandBuffer *commandBuffer, float dt) {
+  if (!pipeline || particleSettings.count == 0) {
+    return;
+  }
+  const ParticleSystemSettings &s = particleSettings;
+
+  ParticleUniforms uniforms{};
+  uniforms.emitter[0] = s.emitterX;
+  uniforms.emitter[1] = s.emitterY;
+  // A long hitch would otherwise shoot every particle across the map.
+  uniforms.deltaTime = SDL_min(dt, 0.1f);
+  uniforms.count = s.count;
+  uniforms.gravity[0] = s.gravityX;
+  uniforms.gravity[1] = s.gravityY;
+  uniforms.speed = s.speed;
+  uniforms.spread = s.spread;
+  uniforms.direction = s.direction;
+  uniforms.lifetime = s.lifetime;
+  uniforms.size = s.size;
+  uniforms.depth = s.depth;
+  uniforms.texRect[0] = s.texU;
+  uniforms.texRect[1] = s.texV;
+  uniforms.texRect[2] = s.texW;
+  uniforms.texRect[3] = s.texH;
+  SDL_memcpy(uniforms.startColor, s.startColor, sizeof(uniforms.startColor));
+  SDL_memcpy(uniforms.endColor, s.endColor, sizeof(uniforms.endColor));
+  uniforms.textureLayer = s.textureLayer;
+  uniforms.seed = seed++;
+  uniforms.reset = reset ? 1 : 0;
+  uniforms.shape = s.shape;
+  reset = false;
+
+  // The particles carry over from the last frame, so that buffer must not
+  // be cycled. The sprites are rewritten completely; cycling them lets the
+  // previous frame's draw keep reading its copy.
+  SDL_GPUStorageBufferReadWriteBinding bindings[2]{};
+  bindings[0].buffer = particles;
+  bindings[0].cycle = false;
+  bindings[1].buffer = sprites;
+  bindings[1].cycle = true;
+
+  SDL_GPUComputePass *computePass =
+      SDL_BeginGPUComputePass(commandBuffer, NULL, 0, bindings, 2);
+  SDL_BindGPUComputePipeline(computePass, pipeline);
+  SDL_PushGPUComputeUniformData(commandBuffer, 0, &uniforms,
+                                sizeof(ParticleUniforms));
+  SDL_DispatchGPUCompute(computePass,
+                         (s.count + PARTICLE_GROUP_SIZE - 1) /
+                             PARTICLE_GROUP_SIZE,
+                         1, 1);
+  SDL_EndGPUComputePass(computePass);
+}
+
+void ParticleSystem::render(SDL_GPURenderPass *renderPass,
+                            SDL_GPUGraphicsPipeline *pipeline,
+                            const SDL_GPUTextureSamplerBinding &texture,
+                            SDL_GPUBuffer *shapeBuffer) {
+  if (!sprites || particleSettings.count == 0) {
+    return;
+  }
+  SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+  // set = 0, binding = 0 in vertex.vert, same as SpriteBatch's buffer, and
+  // the shape table next to it.
+  SDL_GPUBuffer *buffers[2] = {sprites, shapeBuffer};
+  SDL_BindGPUVertexStorageBuffers(renderPass, 0, buffers, shapeBuffer ? 2 : 1);
+  SDL_BindGPUFragmentSamplers(renderPass, 0, &texture, 1);
+  drawSprites(renderPass,
+              shapeBuffer ? SpriteGeometry::Trimmed
+                          : SpriteGeometry::VertexPulling,
+              0, particleSettings.count);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+// GPU mirror of Particle in shaders/particles.comp (std430). Only the GPU
+// reads and writes these; the struct is here so the buffer can be sized.
+struct GPUParticle {
+  float x, y;
+  float vx, vy;
+  float age;
+  float lifetime;
+  float size;
+  float padding;
+};
+static_assert(sizeof(GPUParticle) == 32, "GPUParticle must be 32 bytes");
+
+struct ParticleSystemSettings {
+  Uint32 count = 100000;
+  // Where particles are born and which way they go, in world units. Angles
+  // are in radians; 0 points along +x, and +y is down with the sample's
+  // projection.
+  float emitterX = 0.0f, emitterY = 0.0f;
+  float direction = -SDL_PI_F * 0.5f;
+  float spread = 0.6f;
+  float speed = 400.0f;
+  float gravityX = 0.0f, gravityY = 300.0f;
+  // Seconds. Each particle gets between half and all of it.
+  float lifetime = 3.0f;
+  float size = 6.0f;
+  float depth = 0.0f;
+  // Which part of which texture layer every particle shows.
+  float texU = 0.0f, texV = 0.0f, texW = 1.0f, texH = 1.0f;
+  float textureLayer = 0.0f;
+  // The shape table entry every particle is drawn with, when render() is
+  // given the table (see SpriteShapes.hpp). 0 is the full quad.
+  float shape = 0.0f;
+  // Interpolated over each particle's life.
+  float startColor[4] = {1.0f, 0.8f, 0.3f, 1.0f};
+  float endColor[4] = {1.0f, 0.2f, 0.1f, 0.0f};
+};
+
+// Particles that live entirely on the GPU. update() runs particles.comp,
+// which integrates position, velocity and age in one storage buffer and
+// writes the particles as SpriteData records into a second one. render()
+// draws that buffer with the ordinary sprite pipeline, vertex.vert can't tell
+// the difference. Nothing is uploaded per frame besides a small uniform
+// block, whatever the particle count.
+//
+// Usage, per frame:
+//   update(commandBuffer, dt)   outside any render or copy pass
+//   render(renderPass, ...)     with ViewProjectionMatrix already pushed
+class ParticleSystem {
+public:
+  bool init(SDL_GPUDevice *device, const ParticleSystemSettings &settings);
+  void release();
+
+  // Settings that don't change the count can be changed at any time, e.g.
+  // to move the emitter.
+  ParticleSystemSettings &settings() { return particleSettings; }
+  const ParticleSystemSettings &settings() const { return particleSettings; }
+
+  void update(SDL_GPUCommandBuffer *commandBuffer, float dt);
+  // Binds the pipeline, the sprite buffer and the texture itself. The
+  // pipeline has to use the Std140 layout, and the Trimmed geometry when
+  // there is a shapeBuffer (SpriteShapeTable::buffer()), otherwise vertex
+  // pulling.
+  void render(SDL_GPURenderPass *renderPass, SDL_GPUGraphicsPipeline *pipeline,
+              const SDL_GPUTextureSamplerBinding &texture,
+              SDL_GPUBuffer *shapeBuffer = nullptr);
+
+  // The SpriteData records written by the last update(). Usable as a
+  // vertex storage buffer by anything that draws sprites.
+  SDL_GPUBuffer *spriteBuffer() const { return sprites; }
+  Uint32 count() const { return particleSettings.count; }
+
+private:
+  SDL_GPUDevice *device = nullptr;
+  SDL_GPUComputePipeline *pipeline = nullptr;
+  SDL_GPUBuffer *particles = nullptr;
+  SDL_GPUBuffer *sprites = nullptr;
+  ParticleSystemSettings particleSettings;
+  Uint32 seed = 0;
+  // The first update spawns every particle.
+  bool reset = true;
+};
@@ -0,0 +1,184 @@
+#include "RetainedSprites.hpp"
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <bit>
+
+bool RetainedSprites::init(SDL_GPUDevice *device,
+                           const RetainedSpritesSettings &settings) {
+  this->device = device;
+  capacity = SDL_max(settings.capacity, 1u);
+  mergeGap = settings.mergeGap;
+  framesInFlight = settings.framesInFlight;
+  geometry = settings.geometry;
+  transferBuffers.assign(SDL_max(framesInFlight, 1u), nullptr);
+  transferSizes.assign(transferBuffers.size(), 0);
+  sprites.clear();
+  sprites.reserve(capacity);
+  dirty.assign((capacity + 63) / 64, 0);
+  dirtyCount = 0;
+  ranges.reserve(64);
+
+  SDL_GPUBufferCreateInfo bufferInfo{};
+  bufferInfo.size = capacity * sizeof(SpriteData);
+  bufferInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  buffer = SDL_CreateGPUBuffer(device, &bufferInfo);
+  if (!buffer) {
+    SDL_Log("Failed to create retained sprite buffer: %s", SDL_GetError());
+    return false;
+  }
+  return true;
+}
+
+void RetainedSprites::release() {
+  if (!device) {
+    return;
+  }
+  SDL_ReleaseGPUBuffer(device, buffer);
+  buffer = nullptr;
+  for (SDL_GPUTransferBuffer *&transferBuffer : transferBuffers) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    transferBuffer = nullptr;
+  }
+}
+
+Uint32 RetainedSprites::add(const SpriteData &sprite) {
+  if (sprites.size() >= capacity) {
+    return ~0u;
+  }
+  Uint32 index = (Uint32)sprites.size();
+  sprites.push_back(sprite);
+  markDirty(index);
+  return index;
+}
+
+void RetainedSprites::set(Uint32 index, const SpriteData &sprite) {
+  sprites[index] = sprite;
+  markDirty(index);
+}
+
+// Walks the bitset a word at a time, skipping clean words, and turns each
+// run of set bits into a range. A run that starts within mergeGap sprites of
+// the previous range's end extends it instead. The bits stay set; upload()
+// clears them once the transfer buffer is mapped.
+void RetainedSprites::collectRanges() {
+  ranges.clear();
+  uploadStats.dirtySprites = 0;
+  for (Uint32 word = 0; word < (Uint32)dirty.size(); word++) {
+    Uint64 bits = dirty[word];
+    if (bits == 0) {
+      continue;
+    }
+    uploadStats.dirtySprites += (Uint32)std::popcount(bits);
+    while (bits != 0) {
+      Uint32 start = (Uint32)std::countr_zero(bits);
+      Uint32 length = (Uint32)std::countr_one(bits >> start);
+      // Clear the run. length can be 64, which a plain shift can't express.
+      bits &= length == 64 ? 0 : ~((((Uint64)1 << length) - 1) << start);
+
+      Uint32 first = word * 64 + start;
+      if (!ranges.empty() &&
+          first - (ranges.back().first + ranges.back().count) <= mergeGap) {
+        ranges.back().count = first + length - ranges.back().first;
+      } else {
+        ranges.push_back({first, length});
+      }
+    }
+  }
+}
+
+bool RetainedSprites::upload(SDL_GPUCommandBuffer *commandBuffer,
+                             Uint32 frameSlot) {
+  uploadStats = {};
+  if (dirtyCount == 0) {
+    return true;
+  }
+  TRACE_ZONE("retained upload");
+  Uint64 start = SDL_GetTicksNS();
+  collectRanges();
+
+  Uint32 size = 0;
+  for (const Range &range : ranges) {
+    size += range.count * (Uint32)sizeof(SpriteData);
+  }
+
+  // Grown, never shrunk, so a steady scene stops creating transfer buffers
+  // after its first busy frame.
+  frameSlot %= (Uint32)transferBuffers.size();
+  SDL_GPUTransferBuffer *&transferBuffer = transferBuffers[frameSlot];
+  if (size > transferSizes[frameSlot]) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_GPUTransferBufferCreateInfo transferInfo{};
+    transferInfo.size = SDL_max(size, transferSizes[frameSlot] * 2);
+    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+    transferSizes[frameSlot] = transferBuffer ? transferInfo.size : 0;
+    if (!transferBuffer) {
+      SDL_Log("Failed to create retained transfer buffer: %s", SDL_GetError());
+      return false;
+    }
+  }
+
+  // Same rules as SpriteBatch::upload: the slot's buffer is free, or
+  // without a ring SDL cycles it.
+  Uint8 *data = (Uint8 *)SDL_MapGPUTransferBuffer(device, transferBuffer,
+                                                  framesInFlight == 0);
+  if (!data) {
+    SDL_Log("Failed to map retained transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+  // Only now is the copy certain to be recorded. Had anything above failed,
+  // the sprites would have stayed dirty for the next upload to retry. Every
+  // dirty bit is in a range, so clearing the words the ranges touch clears
+  // them all.
+  for (const Range &range : ranges) {
+    std::fill(dirty.begin() + range.first / 64,
+              dirty.begin() + (range.first + range.count - 1) / 64 + 1, 0);
+  }
+  dirtyCount = 0;
+  Uint32 offset = 0;
+  for (const Range &range : ranges) {
+    Uint32 rangeSize = range.count * (Uint32)sizeof(SpriteData);
+    SDL_memcpy(data + offset, &sprites[range.first], rangeSize);
+    offset += rangeSize;
+  }
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  offset = 0;
+  for (const Range &range : ranges) {
+    SDL_GPUTransferBufferLocation location{};
+    location.transfer_buffer = transferBuffer;
+    location.offset = offset;
+    SDL_GPUBufferRegion region{};
+    region.buffer = buffer;
+    region.offset = range.first * (Uint32)sizeof(SpriteData);
+    region.size = range.count * (Uint32)sizeof(SpriteData);
+    // Never cycled, unlike SpriteBatch's: the sprites outside the ranges
+    // have to stay. The copy is ordered after the previous frame's draws.
+    SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+    offset += region.size;
+  }
+  SDL_EndGPUCopyPass(copyPass);
+
+  uploadStats.regions = (Uint32)ranges.size();
+  uploadStats.bytesUploaded = size;
+  uploadStats.uploadNS = SDL_GetTicksNS() - start;
+  return true;
+}
+
+void RetainedSprites::render(SDL_GPURenderPass *renderPass,
+                             SDL_GPUGraphicsPipeline *pipeline,
+                             const SDL_GPUTextureSamplerBinding &texture) {
+  if (sprites.empty()) {
+    return;
+  }
+  SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+  SDL_BindGPUVertexStorageBuffers(renderPass, 0, &buffer, 1);
+  SDL_BindGPUFragmentSamplers(renderPass, 0, &texture, 1);
+  drawSprites(renderPass, geometry, 0, (Uint32)sprites.size());
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+#include "SpritePipeline.hpp"
+
+#include <vector>
+
+// Counters for the last upload().
+struct RetainedSpriteStats {
+  // Sprites that changed since the upload before.
+  Uint32 dirtySprites;
+  // SDL_UploadToGPUBuffer calls. Neighbouring dirty ranges are merged.
+  Uint32 regions;
+  // Includes the clean sprites in the gaps that were merged over.
+  Uint64 bytesUploaded;
+  Uint64 uploadNS;
+};
+
+struct RetainedSpritesSettings {
+  // The most sprites add() can make.
+  Uint32 capacity = 1024;
+  // Dirty ranges at most this many clean sprites apart are uploaded as one
+  // region, the clean sprites in between included. Another copy command
+  // costs more than a few hundred bytes of copying.
+  Uint32 mergeGap = 16;
+  // Same as SpriteBatchSettings::framesInFlight.
+  Uint32 framesInFlight = 0;
+  // Has to match the pipeline render() is given.
+  SpriteGeometry geometry = SpriteGeometry::VertexPulling;
+};
+
+// Sprites that persist across frames, for scenes where most of them don't
+// change. SpriteBatch re-uploads everything every frame; here the storage
+// buffer keeps last frame's sprites and only the ones set() since are
+// copied over. set() marks a bit in a dirty bitset; upload() turns the bits
+// into as few ranges as possible and records one SDL_UploadToGPUBuffer per
+// range, leaving the rest of the buffer alone. A frame where nothing changed
+// uploads nothing.
+//
+// Sprites are drawn in index order with one pipeline and one texture
+// binding, so they should share a texture array. Only the Std140 layout.
+//
+// Usage:
+//   add() / set() whenever sprites change
+//   per frame: upload(commandBuffer, frameSlot)   before the render pass
+//              render(renderPass, ...)            ViewProjectionMatrix pushed
+class RetainedSprites {
+public:
+  bool init(SDL_GPUDevice *device, const RetainedSpritesSettings &settings);
+  void release();
+
+  // Returns the new sprite's index, or ~0 when the capacity is used up.
+  Uint32 add(const SpriteData &sprite);
+  void set(Uint32 index, const SpriteData &sprite);
+  const SpriteData &get(Uint32 index) const { return sprites[index]; }
+  Uint32 count() const { return (Uint32)sprites.size(); }
+
+  // frameSlot picks the transfer buffer like SpriteBatch::begin's.
+  bool upload(SDL_GPUCommandBuffer *commandBuffer, Uint32 frameSlot = 0);
+  void render(SDL_GPURenderPass *renderPass, SDL_GPUGraphicsPipeline *pipeline,
+              const SDL_GPUTextureSamplerBinding &texture);
+
+  const RetainedSpriteStats &stats() const { return uploadStats; }
+  SDL_GPUBuffer *spriteBuffer() const { return buffer; }
+
+private:
+  struct Range {
+    Uint32 first;
+    Uint32 count;
+  };
+
+  void markDirty(Uint32 index) {
+    dirty[index / 64] |= (Uint64)1 << (index % 64);
+    dirtyCount++;
+  }
+  // Leaves the bits set; upload() clears them once the copy is certain.
+  void collectRanges();
+
+  SDL_GPUDevice *device = nullptr;
+  SDL_GPUBuffer *buffer = nullptr;
+  // One per frame in flight, grown to the largest upload so far.
+  std::vector<SDL_GPUTransferBuffer *> transferBuffers;
+  std::vector<Uint32> transferSizes;
+  Uint32 framesInFlight = 0;
+  Uint32 capacity = 0;
+  Uint32 mergeGap = 0;
+  SpriteGeometry geometry = SpriteGeometry::VertexPulling;
+
+  // What the storage buffer holds once the dirty sprites are uploaded.
+  std::vector<SpriteData> sprites;
+  // One bit per sprite. dirtyCount counts set() calls, so a sprite set
+  // twice is counted twice; it's only used to skip clean frames.
+  std::vector<Uint64> dirty;
+  Uint32 dirtyCount = 0;
+  std::vector<Range> ranges;
+  RetainedSpriteStats uploadStats{};
+};
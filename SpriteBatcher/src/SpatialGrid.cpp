@@ -0,0 +1,144 @@
+#include "SpatialGrid.hpp"
+
+void SpatialGrid::init(const SpatialGridSettings &settings) {
+  this->settings = settings;
+  inverseCellSize = 1.0f / settings.cellSize;
+  cells.clear();
+  cells.resize((size_t)settings.columns * settings.rows);
+  locations.clear();
+  itemCount = 0;
+  looseX = 0.0f;
+  looseY = 0.0f;
+}
+
+void SpatialGrid::clear() {
+  for (std::vector<Entry> &cell : cells) {
+    cell.clear();
+  }
+  locations.clear();
+  itemCount = 0;
+  looseX = 0.0f;
+  looseY = 0.0f;
+}
+
+// Clamped, so anything outside the grid lands in a border cell. Clamping
+// keeps the order of coordinates, which is all queries rely on.
+Uint32 SpatialGrid::column(float x) const {
+  float c = (x - settings.originX) * inverseCellSize;
+  if (!(c > 0.0f)) {
+    return 0;
+  }
+  if (c >= (float)(settings.columns - 1)) {
+    return settings.columns - 1;
+  }
+  return (Uint32)c;
+}
+
+Uint32 SpatialGrid::row(float y) const {
+  float r = (y - settings.originY) * inverseCellSize;
+  if (!(r > 0.0f)) {
+    return 0;
+  }
+  if (r >= (float)(settings.rows - 1)) {
+    return settings.rows - 1;
+  }
+  return (Uint32)r;
+}
+
+Uint32 SpatialGrid::cellOf(const SpatialRect &bounds) const {
+  float centerX = (bounds.minX + bounds.maxX) * 0.5f;
+  float centerY = (bounds.minY + bounds.maxY) * 0.5f;
+  return row(centerY) * settings.columns + column(centerX);
+}
+
+void SpatialGrid::insert(Uint32 id, const SpatialRect &bounds) {
+  if (contains(id)) {
+    move(id, bounds);
+    return;
+  }
+  if (id >= locations.size()) {
+    locations.resize(id + 1);
+  }
+
+  float halfWidth = (bounds.maxX - bounds.minX) * 0.5f;
+  float halfHeight = (bounds.maxY - bounds.minY) * 0.5f;
+  looseX = halfWidth > looseX ? halfWidth : looseX;
+  looseY = halfHeight > looseY ? halfHeight : looseY;
+
+  Uint32 cell = cellOf(bounds);
+  locations[id] = {cell, (Uint32)cells[cell].size()};
+  cells[cell].push_back({bounds, id});
+  itemCount++;
+}
+
+void SpatialGrid::move(Uint32 id, const SpatialRect &bounds) {
+  if (!contains(id)) {
+    insert(id, bounds);
+    return;
+  }
+
+  Location &location = locations[id];
+  Uint32 cell = cellOf(bounds);
+  if (cell == location.cell) {
+    float halfWidth = (bounds.maxX - bounds.minX) * 0.5f;
+    float halfHeight = (bounds.maxY - bounds.minY) * 0.5f;
+    looseX = halfWidth > looseX ? halfWidth : looseX;
+    looseY = halfHeight > looseY ? halfHeight : looseY;
+    cells[cell][location.slot].bounds = bounds;
+    return;
+  }
+
+  removeFromCell(location.cell, location.slot);
+  location.cell = INVALID_CELL;
+  itemCount--;
+  insert(id, bounds);
+}
+
+void SpatialGrid::remove(Uint32 id) {
+  if (!contains(id)) {
+    return;
+  }
+  Location &location = locations[id];
+  removeFromCell(location.cell, location.slot);
+  location.cell = INVALID_CELL;
+  itemCount--;
+}
+
+// Swap-remove: the last entry of the cell takes the hole, so only that one
+// item's slot changes.
+void SpatialGrid::removeFromCell(Uint32 cell, Uint32 slot) {
+  std::vector<Entry> &entries = cells[cell];
+  Uint32 last = (Uint32)entries.size() - 1;
+  if (slot != last) {
+    entries[slot] = entries[last];
+    locations[entries[slot].id].slot = slot;
+  }
+  entries.pop_back();
+}
+
+void SpatialGrid::queryRect(const SpatialRect &rect,
+                            std::vector<Uint32> &out) const {
+  out.clear();
+  if (itemCount == 0) {
+    return;
+  }
+
+  // An overlapping item's center is at most one loose half size outside of
+  // rect, so only those cells can hold it.
+  Uint32 firstColumn = column(rect.minX - looseX);
+  Uint32 lastColumn = column(rect.maxX + looseX);
+  Uint32 firstRow = row(rect.minY - looseY);
+  Uint32 lastRow = row(rect.maxY + looseY);
+
+  for (Uint32 r = firstRow; r <= lastRow; r++) {
+    for (Uint32 c = firstColumn; c <= lastColumn; c++) {
+      for (const Entry &entry : cells[r * settings.columns + c]) {
+        const SpatialRect &bounds = entry.bounds;
+        if (bounds.minX <= rect.maxX && bounds.maxX >= rect.minX &&
+            bounds.minY <= rect.maxY && bounds.maxY >= rect.minY) {
+          out.push_back(entry.id);
+        }
+      }
+    }
+  }
+}
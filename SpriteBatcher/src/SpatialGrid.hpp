@@ -0,0 +1,90 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include <cmath>
+#include <vector>
+
+struct SpatialRect {
+  float minX, minY, maxX, maxY;
+};
+
+// Bounds of a sprite for any rotation: the quad rotates around its Position
+// (its first corner), so it stays within sqrt(w^2 + h^2) of it. Same bound as
+// the cull kernels use.
+inline SpatialRect spriteBounds(float x, float y, float w, float h) {
+  float radius = std::sqrt(w * w + h * h);
+  return {x - radius, y - radius, x + radius, y + radius};
+}
+
+struct SpatialGridSettings {
+  // World area covered by the grid. Items outside of it still work; they're
+  // kept in the border cells.
+  float originX = 0.0f;
+  float originY = 0.0f;
+  float cellSize = 256.0f;
+  Uint32 columns = 64;
+  Uint32 rows = 64;
+};
+
+// A loose uniform grid over a sprite world. Each item lives in the single
+// cell that contains the center of its bounds, and queries grow by the
+// largest half size ever inserted to catch items that hang over from
+// neighboring cells. That keeps every item in exactly one place:
+// - insert, remove and move are O(1). A move that stays in its cell only
+//   rewrites the bounds; otherwise it's a swap-remove plus a push.
+// - a query touches the cells under the rect and tests the bounds stored in
+//   them, so it costs O(cells + items nearby) instead of O(items).
+// Bounds are stored inside the cells next to the id, so a query walks
+// contiguous memory. Cells keep their capacity, and queries write into a
+// vector the caller keeps around, so a steady world doesn't allocate.
+//
+// Ids are chosen by the caller (e.g. an index into the scene) and should be
+// dense, since a location is kept per id.
+class SpatialGrid {
+public:
+  void init(const SpatialGridSettings &settings);
+  void clear();
+
+  void insert(Uint32 id, const SpatialRect &bounds);
+  void move(Uint32 id, const SpatialRect &bounds);
+  void remove(Uint32 id);
+  bool contains(Uint32 id) const {
+    return id < locations.size() && locations[id].cell != INVALID_CELL;
+  }
+  Uint32 size() const { return itemCount; }
+
+  // Clears out and appends the ids whose bounds overlap rect (edges
+  // included), in no particular order.
+  void queryRect(const SpatialRect &rect, std::vector<Uint32> &out) const;
+  void queryPoint(float x, float y, std::vector<Uint32> &out) const {
+    queryRect({x, y, x, y}, out);
+  }
+
+private:
+  static const Uint32 INVALID_CELL = ~0u;
+
+  struct Entry {
+    SpatialRect bounds;
+    Uint32 id;
+  };
+  struct Location {
+    Uint32 cell = INVALID_CELL;
+    // Index of the item's Entry inside its cell.
+    Uint32 slot = 0;
+  };
+
+  Uint32 column(float x) const;
+  Uint32 row(float y) const;
+  Uint32 cellOf(const SpatialRect &bounds) const;
+  void removeFromCell(Uint32 cell, Uint32 slot);
+
+  SpatialGridSettings settings;
+  float inverseCellSize = 0.0f;
+  std::vector<std::vector<Entry>> cells;
+  std::vector<Location> locations;
+  Uint32 itemCount = 0;
+  // Largest half width and half height of any item inserted so far.
+  float looseX = 0.0f;
+  float looseY = 0.0f;
+};
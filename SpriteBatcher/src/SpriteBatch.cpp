@@ -0,0 +1,348 @@
+#include "SpriteBatch.hpp"
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Trace.hpp"
+
+#include <atomic>
+
+// Sprites per packing slice. A multiple of the AVX2 block size (8), and large
+// enough that waking a thread is worth it.
+static const Uint32 PACK_SLICE_GRANULARITY = 16384;
+// Culling only reads five floats per sprite, so slices can be larger.
+static const Uint32 CULL_SLICE_GRANULARITY = 65536;
+
+bool SpriteBatch::init(SDL_GPUDevice *device,
+                       const SpriteBatchSettings &settings) {
+  this->device = device;
+  workerPool = settings.workerPool;
+  layout = settings.layout;
+  geometry = settings.geometry;
+  shapeBuffer = settings.shapeBuffer;
+  framesInFlight = settings.framesInFlight;
+  transferBuffers.assign(SDL_max(framesInFlight, 1u), nullptr);
+  cullEnabled = false;
+  minPixelSize = settings.cull ? settings.minPixelSize : -1.0f;
+  cullSlices.resize(workerPool ? workerPool->threadCount() : 1);
+  store.reserve(settings.capacity);
+  keySorter.reserve(settings.capacity);
+  arena = settings.arena ? settings.arena : &ownArena;
+  // Culled indices, draw order and the widest sort's scratch arrays.
+  if (!settings.arena && !ownArena.init((Uint64)settings.capacity * 32)) {
+    return false;
+  }
+  packKernel = detectPackKernel();
+  SDL_Log("Packing sprites with the %s kernel.", packKernelName(packKernel));
+  return reserve(settings.capacity);
+}
+
+void SpriteBatch::release() {
+  SDL_ReleaseGPUBuffer(device, spriteBuffer);
+  spriteBuffer = nullptr;
+  for (SDL_GPUTransferBuffer *&transferBuffer : transferBuffers) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    transferBuffer = nullptr;
+  }
+  capacity = 0;
+}
+
+// Buffers are expensive to create, so they only grow (in powers of two) and
+// are otherwise reused every frame.
+bool SpriteBatch::reserve(Uint32 spriteCount) {
+  if (spriteCount <= capacity) {
+    return true;
+  }
+
+  Uint32 newCapacity = capacity == 0 ? 1024 : capacity;
+  while (newCapacity < spriteCount) {
+    newCapacity *= 2;
+  }
+
+  // Releasing is safe even if the GPU is still using the old buffers. SDL
+  // defers the destruction until the GPU is done with them.
+  release();
+
+  SDL_GPUBufferCreateInfo bufferInfo{};
+  bufferInfo.size = newCapacity * spriteLayoutStride(layout);
+  // The vertex shader only reads the sprites.
+  bufferInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  spriteBuffer = SDL_CreateGPUBuffer(device, &bufferInfo);
+
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = newCapacity * spriteLayoutStride(layout);
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  bool created = spriteBuffer != nullptr;
+  for (SDL_GPUTransferBuffer *&transferBuffer : transferBuffers) {
+    transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+    created = created && transferBuffer;
+  }
+
+  if (!created) {
+    SDL_Log("Failed to create sprite buffers: %s", SDL_GetError());
+    release();
+    return false;
+  }
+
+  capacity = newCapacity;
+  return true;
+}
+
+Uint8 SpriteBatch::addPipeline(SDL_GPUGraphicsPipeline *pipeline) {
+  return addPipeline(pipeline, geometry);
+}
+
+Uint8 SpriteBatch::addPipeline(SDL_GPUGraphicsPipeline *pipeline,
+                               SpriteGeometry geometry) {
+  pipelines.push_back(pipeline);
+  pipelineGeometries.push_back(geometry);
+  return (Uint8)(pipelines.size() - 1);
+}
+
+Uint16 SpriteBatch::addTexture(const SDL_GPUTextureSamplerBinding &binding) {
+  textures.push_back(binding);
+  return (Uint16)(textures.size() - 1);
+}
+
+void SpriteBatch::begin(Uint32 frameSlot) {
+  this->frameSlot = frameSlot % (Uint32)transferBuffers.size();
+  // clear() keeps the allocation around, so steady frames don't allocate.
+  store.clear();
+  keySorter.clear();
+  if (arena == &ownArena) {
+    ownArena.reset();
+  }
+  kept = drawOrder = nullptr;
+  frameStats = {};
+}
+
+void SpriteBatch::draw(const SpriteData &sprite) {
+  draw(sprite, makeBatchKey(0, 0, 0, sprite.z));
+}
+
+void SpriteBatch::draw(const SpriteData &sprite, Uint64 key) {
+  store.push(sprite);
+  keySorter.push(key);
+}
+
+void SpriteBatch::drawStore(const SpriteStore &sprites, Uint8 layer,
+                            Uint8 pipeline, Uint16 texture) {
+  store.append(sprites);
+  for (float z : sprites.z) {
+    keySorter.push(makeBatchKey(layer, pipeline, texture, z));
+  }
+}
+
+void SpriteBatch::setView(const float viewProjection[16], float viewportWidth,
+                          float viewportHeight) {
+  // A negative minPixelSize means culling was turned off in the settings.
+  cullEnabled = minPixelSize >= 0.0f &&
+                makeCullParams(viewProjection, viewportWidth, viewportHeight,
+                               minPixelSize, cullParams);
+}
+
+// Runs the cull kernel over the whole store, split across the worker pool
+// like packing. Each slice writes its survivors to the start of its own range
+// of kept[]; the ranges are then moved together.
+Uint32 SpriteBatch::cull(Uint32 count) {
+  kept = arena->allocate<Uint32>(count);
+  if (!workerPool) {
+    return cullSprites(packKernel, store, cullParams, 0, count, kept);
+  }
+
+  std::atomic<Uint32> sliceCount{0};
+  auto cullSlice = [&](Uint32 first, Uint32 sliceSize) {
+    TRACE_ZONE("cull slice");
+    Uint32 keptCount = cullSprites(packKernel, store, cullParams, first,
+                                   sliceSize, kept + first);
+    cullSlices[sliceCount.fetch_add(1)] = {first, keptCount};
+  };
+  workerPool->parallelFor(count, CULL_SLICE_GRANULARITY, cullSlice);
+
+  // Slices finish in any order. There is one per thread, so an insertion
+  // sort is plenty.
+  Uint32 slices = sliceCount.load();
+  for (Uint32 i = 1; i < slices; i++) {
+    CullSlice slice = cullSlices[i];
+    Uint32 j = i;
+    for (; j > 0 && cullSlices[j - 1].first > slice.first; j--) {
+      cullSlices[j] = cullSlices[j - 1];
+    }
+    cullSlices[j] = slice;
+  }
+
+  Uint32 total = 0;
+  for (Uint32 i = 0; i < slices; i++) {
+    SDL_memmove(kept + total, kept + cullSlices[i].first,
+                cullSlices[i].count * sizeof(Uint32));
+    total += cullSlices[i].count;
+  }
+  return total;
+}
+
+bool SpriteBatch::upload(SDL_GPUCommandBuffer *commandBuffer) {
+  Uint64 start = SDL_GetTicksNS();
+
+  Uint32 count = store.size();
+  frameStats.sprites = count;
+
+  // Sprites that were written through sprites() have no key yet.
+  for (Uint32 i = keySorter.size(); i < count; i++) {
+    keySorter.push(makeBatchKey(0, 0, 0, store.z[i]));
+  }
+
+  // Culling happens before anything is sorted or written, so culled sprites
+  // cost five float loads and nothing else.
+  Uint32 drawCount = count;
+  const Uint32 *visible = nullptr;
+  if (cullEnabled && count > 0) {
+    Uint64 cullStart = SDL_GetTicksNS();
+    drawCount = cull(count);
+    if (drawCount < count) {
+      keySorter.keepOnly(kept, drawCount);
+      visible = kept;
+    }
+    frameStats.cullNS += SDL_GetTicksNS() - cullStart;
+  }
+  frameStats.kept = drawCount;
+  frameStats.culled = count - drawCount;
+
+  Uint64 sortStart = SDL_GetTicksNS();
+  {
+    TRACE_ZONE("sort");
+    keySorter.sort(*arena);
+  }
+  frameStats.sortNS += SDL_GetTicksNS() - sortStart;
+  // NULL when the sprites already are in key order.
+  const Uint32 *order = keySorter.order();
+
+  if (drawCount == 0) {
+    return true;
+  }
+
+  // On failure nothing is kept, so render() draws nothing rather than a
+  // released buffer or last frame's sprites.
+  if (!reserve(drawCount)) {
+    frameStats.kept = 0;
+    return false;
+  }
+  if (visible) {
+    drawOrder = arena->allocate<Uint32>(drawCount);
+  }
+
+  Uint32 size = drawCount * spriteLayoutStride(layout);
+
+  // With a ring, this slot's buffer was last used framesInFlight frames ago
+  // and that frame's fence has signalled, so it is overwritten in place.
+  // Without one, cycle = true: if the GPU hasn't consumed last frame's data
+  // yet, SDL hands us another region instead of stalling or overwriting it.
+  SDL_GPUTransferBuffer *transferBuffer = transferBuffers[frameSlot];
+  void *data =
+      SDL_MapGPUTransferBuffer(device, transferBuffer, framesInFlight == 0);
+  if (!data) {
+    SDL_Log("Failed to map sprite transfer buffer: %s", SDL_GetError());
+    frameStats.kept = 0;
+    return false;
+  }
+  // Written straight into the mapped memory. There is no intermediate
+  // array-of-structures copy. Slices are disjoint ranges of whole 64 byte
+  // records, so threads never share a cache line. first and sliceCount are
+  // positions in sorted order; the kernels look the sprites up through order.
+  auto pack = [&](Uint32 first, Uint32 sliceCount) {
+    TRACE_ZONE("pack slice");
+    const Uint32 *sliceOrder = order;
+    if (visible) {
+      // The sort ran over the kept sprites only. Each slice maps its own
+      // part of the order back to store indices.
+      for (Uint32 i = first; i < first + sliceCount; i++) {
+        drawOrder[i] = visible[order ? order[i] : i];
+      }
+      sliceOrder = drawOrder;
+    }
+    if (layout == SpriteLayout::Compact) {
+      packCompactSprites(packKernel, store, sliceOrder, first, sliceCount,
+                         (CompactSpriteData *)data + first);
+    } else {
+      packSprites(packKernel, store, sliceOrder, first, sliceCount,
+                  (SpriteData *)data + first);
+    }
+  };
+  if (workerPool) {
+    workerPool->parallelFor(drawCount, PACK_SLICE_GRANULARITY, pack);
+  } else {
+    pack(0, drawCount);
+  }
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+
+  SDL_GPUTransferBufferLocation location{};
+  location.transfer_buffer = transferBuffer;
+  location.offset = 0;
+
+  SDL_GPUBufferRegion region{};
+  region.buffer = spriteBuffer;
+  region.offset = 0;
+  region.size = size;
+
+  // The storage buffer is still cycled: the previous frame's draws may still
+  // be reading it. That never makes the CPU wait, SDL just switches to
+  // another internal buffer.
+  SDL_UploadToGPUBuffer(copyPass, &location, &region, true);
+  SDL_EndGPUCopyPass(copyPass);
+
+  frameStats.bytesUploaded += size;
+  frameStats.uploadNS += SDL_GetTicksNS() - start;
+  return true;
+}
+
+void SpriteBatch::render(SDL_GPURenderPass *renderPass) {
+  if (frameStats.kept == 0) {
+    return;
+  }
+
+  // Ids that can't be valid, so the first run binds both.
+  Uint32 boundPipeline = ~0u;
+  Uint32 boundTexture = ~0u;
+
+  for (const BatchRun &run : keySorter.runs()) {
+    Uint8 pipeline = batchKeyPipeline((Uint64)run.state << 32);
+    Uint16 texture = batchKeyTexture((Uint64)run.state << 32);
+    if (pipeline >= pipelines.size() || texture >= textures.size()) {
+      SDL_Log("Skipping %u sprites with unregistered pipeline %u or "
+              "texture %u",
+              run.count, pipeline, texture);
+      continue;
+    }
+
+    SpriteGeometry runGeometry = pipelineGeometries[pipeline];
+    if (pipeline != boundPipeline) {
+      SDL_BindGPUGraphicsPipeline(renderPass, pipelines[pipeline]);
+      // set = 0, binding = 0 in vertex.vert, and the shape table at
+      // binding 1 for the trimmed variants.
+      SDL_GPUBuffer *buffers[2] = {spriteBuffer, shapeBuffer};
+      SDL_BindGPUVertexStorageBuffers(
+          renderPass, 0, buffers,
+          runGeometry == SpriteGeometry::Trimmed ? 2 : 1);
+      boundPipeline = pipeline;
+      frameStats.stateChanges++;
+    }
+    if (texture != boundTexture) {
+      // set = 2, binding = 0 in fragment.frag
+      SDL_BindGPUFragmentSamplers(renderPass, 0, &textures[texture], 1);
+      boundTexture = texture;
+      frameStats.stateChanges++;
+    }
+
+    // Six vertices (two triangles) per sprite, one instance, or a fan. The
+    // shader works out which sprite and which corner from gl_VertexIndex (or
+    // gl_InstanceIndex), which includes the first vertex (instance), so a run
+    // simply starts at its first sprite. Runs that only differ in layer still
+    // get their own draw; that is what keeps the layers in order.
+    drawSprites(renderPass, runGeometry, run.first, run.count);
+    frameStats.drawCalls++;
+    if (runGeometry == SpriteGeometry::Trimmed) {
+      frameStats.trimmed += run.count;
+    }
+  }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "BatchKey.hpp"
+#include "FrameArena.hpp"
+#include "SpriteCulling.hpp"
+#include "SpriteData.hpp"
+#include "SpritePacking.hpp"
+#include "SpritePipeline.hpp"
+#include "SpriteStore.hpp"
+#include "WorkerPool.hpp"
+
+#include <vector>
+
+// Counters for one frame. They are reset by SpriteBatch::begin.
+struct SpriteBatchStats {
+  // Sprites submitted with draw(), and how many of them were culled or kept
+  // (uploaded and drawn).
+  Uint32 sprites;
+  Uint32 culled;
+  Uint32 kept;
+  Uint32 drawCalls;
+  // Kept sprites drawn by a pipeline of the Trimmed geometry.
+  Uint32 trimmed;
+  // Pipeline and texture binds. A draw call that keeps both is not a state
+  // change.
+  Uint32 stateChanges;
+  Uint64 bytesUploaded;
+  // CPU time spent packing into the transfer buffer and recording the copy
+  // pass.
+  Uint64 uploadNS;
+  // Parts of uploadNS spent culling and sorting the batch keys.
+  Uint64 cullNS;
+  Uint64 sortNS;
+};
+
+struct SpriteBatchSettings {
+  // Sprites the buffers are created for. They grow if a frame needs more.
+  Uint32 capacity = 1024;
+  // With a worker pool, packing is split across its threads. Each thread
+  // writes its own slice of the mapped transfer buffer.
+  WorkerPool *workerPool = nullptr;
+  // Both have to match the pipelines' vertex shader variant. The geometry is
+  // the default for addPipeline().
+  SpriteLayout layout = SpriteLayout::Std140;
+  SpriteGeometry geometry = SpriteGeometry::VertexPulling;
+  // The shape table (SpriteShapeTable::buffer()), bound next to the sprites
+  // for pipelines of the Trimmed geometry.
+  SDL_GPUBuffer *shapeBuffer = nullptr;
+  // Culls off-screen sprites once setView has been called. Sprites whose
+  // larger side covers fewer pixels than minPixelSize are dropped as well.
+  bool cull = true;
+  float minPixelSize = 0.5f;
+  // With 0, one transfer buffer is mapped with cycling and SDL finds a free
+  // region when the GPU still reads the last one. Otherwise there is one
+  // transfer buffer per frame in flight, picked by the slot passed to
+  // begin(). The caller has to make sure the slot's previous frame is done,
+  // which FrameLoop does.
+  Uint32 framesInFlight = 0;
+  // Where the culled indices and the sort's scratch arrays come from. It's
+  // the caller's to reset, once per frame before begin(), and the batch's
+  // allocations stay valid until then. Without one the batch keeps an arena
+  // of its own and resets it in begin().
+  FrameArena *arena = nullptr;
+};
+
+// Collects sprites on the CPU every frame and draws them with as few
+// SDL_DrawGPUPrimitives calls as possible. vertex.vert pulls SpriteData out of
+// the storage buffer by gl_VertexIndex / 6, so there is no vertex buffer at
+// all.
+//
+// Every sprite carries a batch key (see BatchKey.hpp). The keys are radix
+// sorted in upload() and the sprites packed in key order, so sprites sharing
+// a pipeline and texture end up next to each other in the buffer. render()
+// then only breaks the draw where the key's state changes.
+//
+// Usage:
+//   addPipeline() / addTexture() once, to get the ids for makeBatchKey
+//   per frame: begin(frameSlot) -> draw() ... -> upload(commandBuffer)
+//              -> render()
+// upload has to be called before the render pass starts because a copy pass
+// cannot be nested inside a render pass.
+class SpriteBatch {
+public:
+  bool init(SDL_GPUDevice *device, const SpriteBatchSettings &settings);
+  void release();
+
+  // Ids start at 0 and are meant to be registered once at startup. The batch
+  // doesn't own the pipelines, textures or samplers. A pipeline can have a
+  // geometry of its own, e.g. a Trimmed one next to the quads, so which
+  // pipeline a sprite's key picks also picks how it's drawn.
+  Uint8 addPipeline(SDL_GPUGraphicsPipeline *pipeline);
+  Uint8 addPipeline(SDL_GPUGraphicsPipeline *pipeline,
+                    SpriteGeometry geometry);
+  Uint16 addTexture(const SDL_GPUTextureSamplerBinding &binding);
+
+  // frameSlot picks the transfer buffer when framesInFlight is set, see
+  // SpriteBatchSettings. Without it, it's ignored.
+  void begin(Uint32 frameSlot = 0);
+  // Layer 0, pipeline 0, texture 0, ordered by z.
+  void draw(const SpriteData &sprite);
+  void draw(const SpriteData &sprite, Uint64 key);
+  // Every sprite of an existing store, e.g. a SpritePool's, copied over
+  // attribute array by attribute array instead of a SpriteData at a time.
+  // They share layer, pipeline and texture; the keys take each one's z.
+  void drawStore(const SpriteStore &sprites, Uint8 layer, Uint8 pipeline,
+                 Uint16 texture);
+  // Direct access to this frame's sprites, for code that would rather fill
+  // whole attribute arrays than go through draw() one sprite at a time.
+  // Sprites added this way get the default key of draw(sprite).
+  SpriteStore &sprites() { return store; }
+  // The same matrix that is pushed as the ViewProjectionMatrix uniform, and
+  // the viewport size in pixels. It stays in effect until it is set again;
+  // upload() culls against it.
+  void setView(const float viewProjection[16], float viewportWidth,
+               float viewportHeight);
+  // Returns false if the sprites couldn't be uploaded. render() then draws
+  // nothing this frame.
+  bool upload(SDL_GPUCommandBuffer *commandBuffer);
+  // Binds the pipelines and textures itself. The ViewProjectionMatrix uniform
+  // has to be pushed by the caller; it stays set across pipeline binds.
+  void render(SDL_GPURenderPass *renderPass);
+
+  const SpriteBatchStats &stats() const { return frameStats; }
+
+private:
+  bool reserve(Uint32 spriteCount);
+  Uint32 cull(Uint32 count);
+
+  SDL_GPUDevice *device = nullptr;
+  // Storage buffer bound at set 0, binding 0 of the vertex shader.
+  SDL_GPUBuffer *spriteBuffer = nullptr;
+  // One per frame in flight, reused every time its slot comes around. With
+  // framesInFlight = 0 there is a single one, and mapping it with
+  // cycle = true gives us a fresh region when the GPU is still reading the
+  // previous frame's sprites.
+  std::vector<SDL_GPUTransferBuffer *> transferBuffers;
+  Uint32 framesInFlight = 0;
+  Uint32 frameSlot = 0;
+  Uint32 capacity = 0;
+
+  // Sprites are kept as structure-of-arrays and only packed into std140
+  // SpriteData records when they're written into the mapped transfer buffer.
+  SpriteStore store;
+  PackKernel packKernel = PackKernel::Scalar;
+  WorkerPool *workerPool = nullptr;
+  SpriteLayout layout = SpriteLayout::Std140;
+  SpriteGeometry geometry = SpriteGeometry::VertexPulling;
+  SDL_GPUBuffer *shapeBuffer = nullptr;
+
+  bool cullEnabled = false;
+  float minPixelSize = 0.0f;
+  CullParams cullParams{};
+  FrameArena *arena = nullptr;
+  FrameArena ownArena;
+  // Store indices of the sprites that survived culling, ascending. From the
+  // arena.
+  Uint32 *kept = nullptr;
+  // kept[] in key order. This is what the pack kernels read through when
+  // sprites were culled. From the arena.
+  Uint32 *drawOrder = nullptr;
+  // One per thread: where its slice of kept[] starts and how much it kept.
+  struct CullSlice {
+    Uint32 first;
+    Uint32 count;
+  };
+  std::vector<CullSlice> cullSlices;
+
+  BatchKeySorter keySorter;
+  std::vector<SDL_GPUGraphicsPipeline *> pipelines;
+  std::vector<SpriteGeometry> pipelineGeometries;
+  std::vector<SDL_GPUTextureSamplerBinding> textures;
+
+  SpriteBatchStats frameStats{};
+};
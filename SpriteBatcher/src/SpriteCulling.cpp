@@ -0,0 +1,231 @@
+#include "SpriteCulling.hpp"
+
+#include "SpriteSimd.hpp"
+
+#include <cmath>
+
+bool makeCullParams(const float viewProjection[16], float viewportWidth,
+                    float viewportHeight, float minPixelSize,
+                    CullParams &out) {
+  const float *m = viewProjection;
+  if (m[3] != 0.0f || m[7] != 0.0f || m[11] != 0.0f || m[15] != 1.0f) {
+    return false;
+  }
+
+  out.xRow[0] = m[0];
+  out.xRow[1] = m[4];
+  out.xRow[2] = m[8];
+  out.xRow[3] = m[12];
+  out.yRow[0] = m[1];
+  out.yRow[1] = m[5];
+  out.yRow[2] = m[9];
+  out.yRow[3] = m[13];
+
+  // A world circle of radius r becomes an ellipse whose extent along NDC x
+  // is r * |(m[0], m[4])|.
+  out.ndcRadiusX = std::sqrt(m[0] * m[0] + m[4] * m[4]);
+  out.ndcRadiusY = std::sqrt(m[1] * m[1] + m[5] * m[5]);
+
+  // Pixels covered by one world unit along the world's x and y axes. The
+  // larger of the two is used, so a sprite is only dropped when it is too
+  // small in every direction.
+  float halfWidth = viewportWidth * 0.5f;
+  float halfHeight = viewportHeight * 0.5f;
+  float pixelsX = std::hypot(m[0] * halfWidth, m[1] * halfHeight);
+  float pixelsY = std::hypot(m[4] * halfWidth, m[5] * halfHeight);
+  float pixelsPerUnit = pixelsX > pixelsY ? pixelsX : pixelsY;
+  out.minWorldSize = pixelsPerUnit > 0.0f ? minPixelSize / pixelsPerUnit : 0.0f;
+  return true;
+}
+
+Uint32 cullSprites(PackKernel kernel, const SpriteStore &store,
+                   const CullParams &params, Uint32 first, Uint32 count,
+                   Uint32 *kept) {
+  switch (kernel) {
+  case PackKernel::AVX2:
+    return cullSpritesAVX2(store, params, first, count, kept);
+  case PackKernel::SSE41:
+    return cullSpritesSSE41(store, params, first, count, kept);
+  case PackKernel::Scalar:
+    break;
+  }
+  return cullSpritesScalar(store, params, first, count, kept);
+}
+
+// The SIMD kernels do the same operations in the same order (no FMA), so
+// they agree with this one bit for bit.
+Uint32 cullSpritesScalar(const SpriteStore &store, const CullParams &params,
+                         Uint32 first, Uint32 count, Uint32 *kept) {
+  Uint32 keptCount = 0;
+  for (Uint32 s = first; s < first + count; s++) {
+    float x = store.x[s], y = store.y[s], z = store.z[s];
+    float w = store.w[s], h = store.h[s];
+
+    float ndcX = params.xRow[0] * x + params.xRow[1] * y +
+                 params.xRow[2] * z + params.xRow[3];
+    float ndcY = params.yRow[0] * x + params.yRow[1] * y +
+                 params.yRow[2] * z + params.yRow[3];
+    float radius = std::sqrt(w * w + h * h);
+    float absW = std::fabs(w), absH = std::fabs(h);
+    float size = absW > absH ? absW : absH;
+
+    bool keep = std::fabs(ndcX) - radius * params.ndcRadiusX <= 1.0f &&
+                std::fabs(ndcY) - radius * params.ndcRadiusY <= 1.0f &&
+                size >= params.minWorldSize;
+    // Written either way, only counted when kept. No branch to mispredict.
+    kept[keptCount] = s;
+    keptCount += keep;
+  }
+  return keptCount;
+}
+
+#ifdef SPRITE_SIMD_X86
+
+SPRITE_SIMD_TARGET("sse4.1")
+Uint32 cullSpritesSSE41(const SpriteStore &store, const CullParams &params,
+                        Uint32 first, Uint32 count, Uint32 *kept) {
+  const __m128 x0 = _mm_set1_ps(params.xRow[0]);
+  const __m128 x1 = _mm_set1_ps(params.xRow[1]);
+  const __m128 x2 = _mm_set1_ps(params.xRow[2]);
+  const __m128 x3 = _mm_set1_ps(params.xRow[3]);
+  const __m128 y0 = _mm_set1_ps(params.yRow[0]);
+  const __m128 y1 = _mm_set1_ps(params.yRow[1]);
+  const __m128 y2 = _mm_set1_ps(params.yRow[2]);
+  const __m128 y3 = _mm_set1_ps(params.yRow[3]);
+  const __m128 radiusX = _mm_set1_ps(params.ndcRadiusX);
+  const __m128 radiusY = _mm_set1_ps(params.ndcRadiusY);
+  const __m128 minSize = _mm_set1_ps(params.minWorldSize);
+  const __m128 one = _mm_set1_ps(1.0f);
+  // Clears the sign bit.
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+  Uint32 keptCount = 0;
+  Uint32 blocks = count / 4;
+  for (Uint32 block = 0; block < blocks; block++) {
+    Uint32 s = first + block * 4;
+    __m128 x = _mm_loadu_ps(&store.x[s]);
+    __m128 y = _mm_loadu_ps(&store.y[s]);
+    __m128 z = _mm_loadu_ps(&store.z[s]);
+    __m128 w = _mm_loadu_ps(&store.w[s]);
+    __m128 h = _mm_loadu_ps(&store.h[s]);
+
+    __m128 ndcX = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x), _mm_mul_ps(x1, y)),
+                   _mm_mul_ps(x2, z)),
+        x3);
+    __m128 ndcY = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(y0, x), _mm_mul_ps(y1, y)),
+                   _mm_mul_ps(y2, z)),
+        y3);
+    __m128 radius =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(h, h)));
+    __m128 size =
+        _mm_max_ps(_mm_and_ps(w, absMask), _mm_and_ps(h, absMask));
+
+    __m128 insideX = _mm_cmple_ps(
+        _mm_sub_ps(_mm_and_ps(ndcX, absMask), _mm_mul_ps(radius, radiusX)),
+        one);
+    __m128 insideY = _mm_cmple_ps(
+        _mm_sub_ps(_mm_and_ps(ndcY, absMask), _mm_mul_ps(radius, radiusY)),
+        one);
+    __m128 bigEnough = _mm_cmpge_ps(size, minSize);
+    int mask =
+        _mm_movemask_ps(_mm_and_ps(_mm_and_ps(insideX, insideY), bigEnough));
+
+    for (Uint32 k = 0; k < 4; k++) {
+      kept[keptCount] = s + k;
+      keptCount += (mask >> k) & 1;
+    }
+  }
+
+  Uint32 done = blocks * 4;
+  return keptCount + cullSpritesScalar(store, params, first + done,
+                                       count - done, kept + keptCount);
+}
+
+SPRITE_SIMD_TARGET("avx2")
+Uint32 cullSpritesAVX2(const SpriteStore &store, const CullParams &params,
+                       Uint32 first, Uint32 count, Uint32 *kept) {
+  const __m256 x0 = _mm256_set1_ps(params.xRow[0]);
+  const __m256 x1 = _mm256_set1_ps(params.xRow[1]);
+  const __m256 x2 = _mm256_set1_ps(params.xRow[2]);
+  const __m256 x3 = _mm256_set1_ps(params.xRow[3]);
+  const __m256 y0 = _mm256_set1_ps(params.yRow[0]);
+  const __m256 y1 = _mm256_set1_ps(params.yRow[1]);
+  const __m256 y2 = _mm256_set1_ps(params.yRow[2]);
+  const __m256 y3 = _mm256_set1_ps(params.yRow[3]);
+  const __m256 radiusX = _mm256_set1_ps(params.ndcRadiusX);
+  const __m256 radiusY = _mm256_set1_ps(params.ndcRadiusY);
+  const __m256 minSize = _mm256_set1_ps(params.minWorldSize);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+  Uint32 keptCount = 0;
+  Uint32 blocks = count / 8;
+  for (Uint32 block = 0; block < blocks; block++) {
+    Uint32 s = first + block * 8;
+    __m256 x = _mm256_loadu_ps(&store.x[s]);
+    __m256 y = _mm256_loadu_ps(&store.y[s]);
+    __m256 z = _mm256_loadu_ps(&store.z[s]);
+    __m256 w = _mm256_loadu_ps(&store.w[s]);
+    __m256 h = _mm256_loadu_ps(&store.h[s]);
+
+    __m256 ndcX = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x0, x), _mm256_mul_ps(x1, y)),
+                      _mm256_mul_ps(x2, z)),
+        x3);
+    __m256 ndcY = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y0, x), _mm256_mul_ps(y1, y)),
+                      _mm256_mul_ps(y2, z)),
+        y3);
+    __m256 radius = _mm256_sqrt_ps(
+        _mm256_add_ps(_mm256_mul_ps(w, w), _mm256_mul_ps(h, h)));
+    __m256 size =
+        _mm256_max_ps(_mm256_and_ps(w, absMask), _mm256_and_ps(h, absMask));
+
+    __m256 insideX = _mm256_cmp_ps(
+        _mm256_sub_ps(_mm256_and_ps(ndcX, absMask),
+                      _mm256_mul_ps(radius, radiusX)),
+        one, _CMP_LE_OQ);
+    __m256 insideY = _mm256_cmp_ps(
+        _mm256_sub_ps(_mm256_and_ps(ndcY, absMask),
+                      _mm256_mul_ps(radius, radiusY)),
+        one, _CMP_LE_OQ);
+    __m256 bigEnough = _mm256_cmp_ps(size, minSize, _CMP_GE_OQ);
+    int mask = _mm256_movemask_ps(
+        _mm256_and_ps(_mm256_and_ps(insideX, insideY), bigEnough));
+
+    // Fully kept or fully culled blocks are the common case on both sides of
+    // the screen edge.
+    if (mask == 0xff) {
+      _mm256_storeu_si256(
+          (__m256i *)(kept + keptCount),
+          _mm256_add_epi32(_mm256_set1_epi32((int)s),
+                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+      keptCount += 8;
+    } else if (mask != 0) {
+      for (Uint32 k = 0; k < 8; k++) {
+        kept[keptCount] = s + k;
+        keptCount += (mask >> k) & 1;
+      }
+    }
+  }
+
+  Uint32 done = blocks * 8;
+  return keptCount + cullSpritesScalar(store, params, first + done,
+                                       count - done, kept + keptCount);
+}
+
+#else
+
+Uint32 cullSpritesSSE41(const SpriteStore &store, const CullParams &params,
+                        Uint32 first, Uint32 count, Uint32 *kept) {
+  return cullSpritesScalar(store, params, first, count, kept);
+}
+
+Uint32 cullSpritesAVX2(const SpriteStore &store, const CullParams &params,
+                       Uint32 first, Uint32 count, Uint32 *kept) {
+  return cullSpritesScalar(store, params, first, count, kept);
+}
+
+#endif
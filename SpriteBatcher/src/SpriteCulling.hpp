@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpritePacking.hpp"
+#include "SpriteStore.hpp"
+
+// What the cull kernels need out of the ViewProjectionMatrix uniform and the
+// viewport.
+//
+// A sprite is a w x h quad rotated around its Position (the quad's first
+// corner, see vertex.vert). Whatever the rotation, the quad stays inside the
+// circle of radius sqrt(w^2 + h^2) around Position, so the kernels test the
+// box around that circle. It is conservative (it never drops a visible
+// sprite) and needs no sin/cos per sprite.
+struct CullParams {
+  // NDC x and y of a point are dot(row, (x, y, z, 1)).
+  float xRow[4];
+  float yRow[4];
+  // How far one world unit reaches in NDC along x and y, for any direction.
+  float ndcRadiusX;
+  float ndcRadiusY;
+  // Sprites whose larger side is below this (in world units) would cover
+  // less than the minimum pixel size and are dropped.
+  float minWorldSize;
+};
+
+// viewProjection is column-major, like the uniform. Returns false when the
+// matrix is projective (w != 1); culling is skipped then.
+bool makeCullParams(const float viewProjection[16], float viewportWidth,
+                    float viewportHeight, float minPixelSize, CullParams &out);
+
+// Writes the store indices of the sprites in [first, first + count) that
+// survive culling to kept[0, n), in ascending order, and returns n. kept
+// needs room for count indices. The kernels use the same levels as packing,
+// and all of them keep exactly the same sprites.
+Uint32 cullSprites(PackKernel kernel, const SpriteStore &store,
+                   const CullParams &params, Uint32 first, Uint32 count,
+                   Uint32 *kept);
+
+Uint32 cullSpritesScalar(const SpriteStore &store, const CullParams &params,
+                         Uint32 first, Uint32 count, Uint32 *kept);
+Uint32 cullSpritesSSE41(const SpriteStore &store, const CullParams &params,
+                        Uint32 first, Uint32 count, Uint32 *kept);
+Uint32 cullSpritesAVX2(const SpriteStore &store, const CullParams &params,
+                       Uint32 first, Uint32 count, Uint32 *kept);
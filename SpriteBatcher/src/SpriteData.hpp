@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include <cstddef>
+
+// CPU mirror of SpriteData in shaders/vertex.vert. Must Follow GLSL std140, so
+// the member order and the padding have to match the shader exactly.
+struct SpriteData {
+  float x, y, z;  // vec3 Position
+  float rotation; // float Rotation
+  float w, h;     // vec2 Scale
+  // float TextureLayer, the layer of the sampler2DArray, and float Shape, the
+  // sprite's entry in the shape table (see SpriteShapes.hpp). They sit in
+  // what used to be vec2 Padding, which keeps TexU at offset 32 and the
+  // stride at 64 bytes. Shape 0 is the full quad, and only pipelines of the
+  // Trimmed geometry read it.
+  float textureLayer;
+  float shape;
+  float texU, texV, texW, texH; // float TexU, TexV, TexW, TexH
+  float r, g, b, a;             // vec4 Color
+};
+
+// The std140 offsets worked out in README.org. If any of these fail, the
+// shader is reading garbage.
+static_assert(offsetof(SpriteData, x) == 0, "Position must be at offset 0");
+static_assert(offsetof(SpriteData, rotation) == 12,
+              "Rotation fills the vec3's fourth component");
+static_assert(offsetof(SpriteData, w) == 16, "Scale must be at offset 16");
+static_assert(offsetof(SpriteData, textureLayer) == 24,
+              "TextureLayer must be at offset 24");
+static_assert(offsetof(SpriteData, shape) == 28,
+              "Shape must be at offset 28");
+static_assert(offsetof(SpriteData, texU) == 32, "TexU must be at offset 32");
+static_assert(offsetof(SpriteData, texH) == 44, "TexH must be at offset 44");
+static_assert(offsetof(SpriteData, r) == 48, "Color must be at offset 48");
+static_assert(sizeof(SpriteData) == 64, "SpriteData must have a 64 byte stride");
+
+// Which SpriteData layout the storage buffer holds. Selects the vertex shader
+// variant and the packing kernels, so a batch uses one layout for its
+// lifetime.
+enum class SpriteLayout {
+  // SpriteData above. 64 bytes of plain floats.
+  Std140,
+  // CompactSpriteData below. 32 bytes, unpacked in the shader.
+  Compact,
+};
+
+// CPU mirror of PackedSpriteData in shaders/vertex.vert, compiled with
+// COMPACT_SPRITES. Half the size of SpriteData, at the cost of precision:
+//   - position and scale are half floats. They have 11 bits of precision, so
+//     a position around 1000 snaps to steps of 0.5 and one around 2000 to
+//     whole units. Keep positions small (e.g. relative to the camera).
+//   - rotation is snorm16 over [-pi, pi], about 0.0001 radians per step.
+//   - the texture rectangle is unorm16, 1/65535 of the texture.
+//   - color is RGBA8.
+struct CompactSpriteData {
+  Uint32 positionXY;        // half x | half y << 16
+  Uint32 positionZRotation; // half z | snorm16 rotation / pi << 16
+  Uint32 scale;             // half w | half h << 16
+  Uint32 color;             // r | g << 8 | b << 16 | a << 24
+  Uint32 texUV;             // unorm16 u | unorm16 v << 16
+  Uint32 texWH;             // unorm16 w | unorm16 h << 16
+  Uint32 textureLayer;
+  // The shape table entry, as in SpriteData. It also fills the struct up to
+  // the 16 bytes std140 rounds it to.
+  Uint32 shape;
+};
+
+static_assert(offsetof(CompactSpriteData, texUV) == 16,
+              "TexUV must start the second 16 byte row");
+static_assert(sizeof(CompactSpriteData) == 32,
+              "CompactSpriteData must have a 32 byte stride");
+
+inline Uint32 spriteLayoutStride(SpriteLayout layout) {
+  return layout == SpriteLayout::Compact ? sizeof(CompactSpriteData)
+                                         : sizeof(SpriteData);
+}
@@ -0,0 +1,547 @@
+#include "SpritePacking.hpp"
+
+#include "SDL3/SDL_cpuinfo.h"
+
+#include "SpriteSimd.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+PackKernel detectPackKernel() {
+#ifdef SPRITE_SIMD_X86
+  if (SDL_HasAVX2()) {
+    return PackKernel::AVX2;
+  }
+  if (SDL_HasSSE41()) {
+    return PackKernel::SSE41;
+  }
+#endif
+  return PackKernel::Scalar;
+}
+
+const char *packKernelName(PackKernel kernel) {
+  switch (kernel) {
+  case PackKernel::AVX2:
+    return "AVX2";
+  case PackKernel::SSE41:
+    return "SSE4.1";
+  case PackKernel::Scalar:
+    break;
+  }
+  return "scalar";
+}
+
+void packSprites(PackKernel kernel, const SpriteStore &store,
+                 const Uint32 *order, Uint32 first, Uint32 count,
+                 SpriteData *out) {
+  switch (kernel) {
+  case PackKernel::AVX2:
+    packSpritesAVX2(store, order, first, count, out);
+    return;
+  case PackKernel::SSE41:
+    packSpritesSSE41(store, order, first, count, out);
+    return;
+  case PackKernel::Scalar:
+    break;
+  }
+  packSpritesScalar(store, order, first, count, out);
+}
+
+void packSpritesScalar(const SpriteStore &store, const Uint32 *order,
+                       Uint32 first, Uint32 count, SpriteData *out) {
+  for (Uint32 i = 0; i < count; i++) {
+    Uint32 s = order ? order[first + i] : first + i;
+    SpriteData &sprite = out[i];
+    sprite.x = store.x[s];
+    sprite.y = store.y[s];
+    sprite.z = store.z[s];
+    sprite.rotation = store.rotation[s];
+    sprite.w = store.w[s];
+    sprite.h = store.h[s];
+    sprite.textureLayer = store.textureLayer[s];
+    sprite.shape = store.shape[s];
+    sprite.texU = store.texU[s];
+    sprite.texV = store.texV[s];
+    sprite.texW = store.texW[s];
+    sprite.texH = store.texH[s];
+    sprite.r = store.r[s];
+    sprite.g = store.g[s];
+    sprite.b = store.b[s];
+    sprite.a = store.a[s];
+  }
+}
+
+Uint16 floatToHalf(float value) {
+  Uint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  Uint32 sign = (bits >> 16) & 0x8000;
+  Uint32 exponent = (bits >> 23) & 0xff;
+  Uint32 mantissa = bits & 0x7fffff;
+
+  // Infinity and NaN (NaN keeps a mantissa bit so it stays NaN).
+  if (exponent == 0xff) {
+    return (Uint16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+
+  int halfExponent = (int)exponent - 127 + 15;
+  if (halfExponent >= 31) {
+    return (Uint16)(sign | 0x7c00);
+  }
+
+  // Too small for a normal half. Shift into a subnormal (or zero).
+  if (halfExponent <= 0) {
+    if (halfExponent < -10) {
+      return (Uint16)sign;
+    }
+    mantissa |= 0x800000;
+    Uint32 shift = (Uint32)(14 - halfExponent);
+    Uint32 half = mantissa >> shift;
+    Uint32 remainder = mantissa & ((1u << shift) - 1);
+    Uint32 halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1))) {
+      half++;
+    }
+    return (Uint16)(sign | half);
+  }
+
+  Uint32 half = ((Uint32)halfExponent << 10) | (mantissa >> 13);
+  Uint32 remainder = mantissa & 0x1fff;
+  // Rounding up may carry into the exponent, which is still correct (the
+  // largest half rounds up to infinity).
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+    half++;
+  }
+  return (Uint16)(sign | half);
+}
+
+float halfToFloat(Uint16 half) {
+  Uint32 sign = (Uint32)(half & 0x8000) << 16;
+  Uint32 exponent = (half >> 10) & 0x1f;
+  Uint32 mantissa = half & 0x3ff;
+  Uint32 bits;
+
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      bits = sign;
+    } else {
+      // Subnormal. Shift until the implicit bit shows up.
+      exponent = 127 - 15 + 1;
+      while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        exponent--;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static const float PI = 3.14159265358979f;
+static const float TWO_PI = 6.28318530717959f;
+static const float INV_PI = 1.0f / PI;
+static const float INV_TWO_PI = 1.0f / TWO_PI;
+
+// Clamp then scale then round to nearest even, in the same order as the SIMD
+// kernel so both produce the same bits.
+static Uint32 toUnorm(float value, float scale) {
+  float clamped = value > 0.0f ? value : 0.0f;
+  clamped = clamped < 1.0f ? clamped : 1.0f;
+  return (Uint32)std::lrintf(clamped * scale);
+}
+
+Sint16 rotationToSnorm16(float radians) {
+  float wrapped = radians - TWO_PI * std::nearbyintf(radians * INV_TWO_PI);
+  float normalized = wrapped * INV_PI;
+  normalized = normalized > -1.0f ? normalized : -1.0f;
+  normalized = normalized < 1.0f ? normalized : 1.0f;
+  return (Sint16)std::lrintf(normalized * 32767.0f);
+}
+
+void packCompactSprites(PackKernel kernel, const SpriteStore &store,
+                        const Uint32 *order, Uint32 first, Uint32 count,
+                        CompactSpriteData *out) {
+  if (kernel == PackKernel::AVX2) {
+    packCompactSpritesF16C(store, order, first, count, out);
+  } else {
+    packCompactSpritesScalar(store, order, first, count, out);
+  }
+}
+
+void packCompactSpritesScalar(const SpriteStore &store, const Uint32 *order,
+                              Uint32 first, Uint32 count,
+                              CompactSpriteData *out) {
+  for (Uint32 i = 0; i < count; i++) {
+    Uint32 s = order ? order[first + i] : first + i;
+    CompactSpriteData &sprite = out[i];
+    sprite.positionXY =
+        floatToHalf(store.x[s]) | (Uint32)floatToHalf(store.y[s]) << 16;
+    sprite.positionZRotation =
+        floatToHalf(store.z[s]) |
+        (Uint32)(Uint16)rotationToSnorm16(store.rotation[s]) << 16;
+    sprite.scale =
+        floatToHalf(store.w[s]) | (Uint32)floatToHalf(store.h[s]) << 16;
+    sprite.color = toUnorm(store.r[s], 255.0f) |
+                   toUnorm(store.g[s], 255.0f) << 8 |
+                   toUnorm(store.b[s], 255.0f) << 16 |
+                   toUnorm(store.a[s], 255.0f) << 24;
+    sprite.texUV = toUnorm(store.texU[s], 65535.0f) |
+                   toUnorm(store.texV[s], 65535.0f) << 16;
+    sprite.texWH = toUnorm(store.texW[s], 65535.0f) |
+                   toUnorm(store.texH[s], 65535.0f) << 16;
+    sprite.textureLayer = (Uint32)store.textureLayer[s];
+    sprite.shape = (Uint32)store.shape[s];
+  }
+}
+
+#ifdef SPRITE_SIMD_X86
+
+// Four consecutive values of one attribute. With an order, the four sprites
+// are gathered one by one instead.
+template <bool Indexed>
+SPRITE_SIMD_TARGET("sse4.1")
+static inline __m128 load4(const std::vector<float> &values,
+                           const Uint32 *order, Uint32 s) {
+  if constexpr (Indexed) {
+    const Uint32 *o = order + s;
+    return _mm_setr_ps(values[o[0]], values[o[1]], values[o[2]],
+                       values[o[3]]);
+  } else {
+    return _mm_loadu_ps(&values[s]);
+  }
+}
+
+// A SpriteData record is exactly four 16 byte rows:
+//   row 0: x, y, z, rotation
+//   row 1: w, h, textureLayer, shape
+//   row 2: texU, texV, texW, texH
+//   row 3: r, g, b, a
+// Loading four sprites of four attributes and transposing the 4x4 block gives
+// one row for each of the four sprites.
+//
+// The mapped transfer buffer is often write-combined memory, which is slow to
+// read and best written in full, sequential cache lines. Each sprite's four
+// rows are therefore stored back to back, and streaming stores are used when
+// the destination is aligned for them.
+template <bool Stream, bool Indexed>
+SPRITE_SIMD_TARGET("sse4.1")
+static void packSSE41(const SpriteStore &store, const Uint32 *order,
+                      Uint32 first, Uint32 count, SpriteData *out) {
+  Uint32 blocks = count / 4;
+
+  for (Uint32 block = 0; block < blocks; block++) {
+    Uint32 s = first + block * 4;
+
+    __m128 row0[4] = {load4<Indexed>(store.x, order, s),
+                      load4<Indexed>(store.y, order, s),
+                      load4<Indexed>(store.z, order, s),
+                      load4<Indexed>(store.rotation, order, s)};
+    __m128 row1[4] = {load4<Indexed>(store.w, order, s),
+                      load4<Indexed>(store.h, order, s),
+                      load4<Indexed>(store.textureLayer, order, s),
+                      load4<Indexed>(store.shape, order, s)};
+    __m128 row2[4] = {load4<Indexed>(store.texU, order, s),
+                      load4<Indexed>(store.texV, order, s),
+                      load4<Indexed>(store.texW, order, s),
+                      load4<Indexed>(store.texH, order, s)};
+    __m128 row3[4] = {load4<Indexed>(store.r, order, s),
+                      load4<Indexed>(store.g, order, s),
+                      load4<Indexed>(store.b, order, s),
+                      load4<Indexed>(store.a, order, s)};
+
+    _MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+    _MM_TRANSPOSE4_PS(row1[0], row1[1], row1[2], row1[3]);
+    _MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+    _MM_TRANSPOSE4_PS(row3[0], row3[1], row3[2], row3[3]);
+
+    float *dst = (float *)&out[block * 4];
+    for (int k = 0; k < 4; k++) {
+      if constexpr (Stream) {
+        _mm_stream_ps(dst + 0, row0[k]);
+        _mm_stream_ps(dst + 4, row1[k]);
+        _mm_stream_ps(dst + 8, row2[k]);
+        _mm_stream_ps(dst + 12, row3[k]);
+      } else {
+        _mm_storeu_ps(dst + 0, row0[k]);
+        _mm_storeu_ps(dst + 4, row1[k]);
+        _mm_storeu_ps(dst + 8, row2[k]);
+        _mm_storeu_ps(dst + 12, row3[k]);
+      }
+      dst += 16;
+    }
+  }
+
+  if constexpr (Stream) {
+    // Streaming stores are weakly ordered. Fence before anyone else (the
+    // unmap) looks at the memory.
+    _mm_sfence();
+  }
+
+  Uint32 done = blocks * 4;
+  packSpritesScalar(store, order, first + done, count - done, out + done);
+}
+
+void packSpritesSSE41(const SpriteStore &store, const Uint32 *order,
+                      Uint32 first, Uint32 count, SpriteData *out) {
+  bool aligned = ((uintptr_t)out & 15) == 0;
+  if (order) {
+    aligned ? packSSE41<true, true>(store, order, first, count, out)
+            : packSSE41<false, true>(store, order, first, count, out);
+  } else {
+    aligned ? packSSE41<true, false>(store, order, first, count, out)
+            : packSSE41<false, false>(store, order, first, count, out);
+  }
+}
+
+// Eight values of one attribute, gathered through the order when there is
+// one.
+template <bool Indexed>
+SPRITE_SIMD_TARGET("avx2")
+static inline __m256 load8(const std::vector<float> &values, __m256i indices,
+                           Uint32 s) {
+  if constexpr (Indexed) {
+    return _mm256_i32gather_ps(values.data(), indices, 4);
+  } else {
+    return _mm256_loadu_ps(&values[s]);
+  }
+}
+
+// Transposes eight sprites of four attributes. Each 128 bit lane holds one
+// 4x4 transpose, so sprite k comes out in the low lane of result[k] and
+// sprite k + 4 in the high lane.
+SPRITE_SIMD_TARGET("avx2")
+static inline void transpose8x4(__m256 a, __m256 b, __m256 c, __m256 d,
+                                __m256 result[4]) {
+  __m256 t0 = _mm256_unpacklo_ps(a, b); // a0 b0 a1 b1 | a4 b4 a5 b5
+  __m256 t1 = _mm256_unpackhi_ps(a, b); // a2 b2 a3 b3 | a6 b6 a7 b7
+  __m256 t2 = _mm256_unpacklo_ps(c, d); // c0 d0 c1 d1 | c4 d4 c5 d5
+  __m256 t3 = _mm256_unpackhi_ps(c, d); // c2 d2 c3 d3 | c6 d6 c7 d7
+  result[0] = _mm256_shuffle_ps(t0, t2, 0x44); // a0 b0 c0 d0 | a4 b4 c4 d4
+  result[1] = _mm256_shuffle_ps(t0, t2, 0xEE); // a1 b1 c1 d1 | a5 b5 c5 d5
+  result[2] = _mm256_shuffle_ps(t1, t3, 0x44); // a2 b2 c2 d2 | a6 b6 c6 d6
+  result[3] = _mm256_shuffle_ps(t1, t3, 0xEE); // a3 b3 c3 d3 | a7 b7 c7 d7
+}
+
+template <bool Stream, bool Indexed>
+SPRITE_SIMD_TARGET("avx2")
+static void packAVX2(const SpriteStore &store, const Uint32 *order,
+                     Uint32 first, Uint32 count, SpriteData *out) {
+  Uint32 blocks = count / 8;
+
+  for (Uint32 block = 0; block < blocks; block++) {
+    Uint32 s = first + block * 8;
+    __m256i indices = _mm256_setzero_si256();
+    if constexpr (Indexed) {
+      indices = _mm256_loadu_si256((const __m256i *)(order + s));
+    }
+
+    __m256 row0[4], row1[4], row2[4], row3[4];
+    transpose8x4(load8<Indexed>(store.x, indices, s),
+                 load8<Indexed>(store.y, indices, s),
+                 load8<Indexed>(store.z, indices, s),
+                 load8<Indexed>(store.rotation, indices, s), row0);
+    transpose8x4(load8<Indexed>(store.w, indices, s),
+                 load8<Indexed>(store.h, indices, s),
+                 load8<Indexed>(store.textureLayer, indices, s),
+                 load8<Indexed>(store.shape, indices, s), row1);
+    transpose8x4(load8<Indexed>(store.texU, indices, s),
+                 load8<Indexed>(store.texV, indices, s),
+                 load8<Indexed>(store.texW, indices, s),
+                 load8<Indexed>(store.texH, indices, s), row2);
+    transpose8x4(load8<Indexed>(store.r, indices, s),
+                 load8<Indexed>(store.g, indices, s),
+                 load8<Indexed>(store.b, indices, s),
+                 load8<Indexed>(store.a, indices, s), row3);
+
+    float *dst = (float *)&out[block * 8];
+    // 0x20 picks both low lanes (sprite k), 0x31 both high lanes (k + 4).
+    for (int lane = 0; lane < 2; lane++) {
+      for (int k = 0; k < 4; k++) {
+        __m256 front = lane == 0 ? _mm256_permute2f128_ps(row0[k], row1[k], 0x20)
+                                 : _mm256_permute2f128_ps(row0[k], row1[k], 0x31);
+        __m256 back = lane == 0 ? _mm256_permute2f128_ps(row2[k], row3[k], 0x20)
+                                : _mm256_permute2f128_ps(row2[k], row3[k], 0x31);
+        if constexpr (Stream) {
+          _mm256_stream_ps(dst + 0, front);
+          _mm256_stream_ps(dst + 8, back);
+        } else {
+          _mm256_storeu_ps(dst + 0, front);
+          _mm256_storeu_ps(dst + 8, back);
+        }
+        dst += 16;
+      }
+    }
+  }
+
+  if constexpr (Stream) {
+    _mm_sfence();
+  }
+
+  Uint32 done = blocks * 8;
+  packSpritesScalar(store, order, first + done, count - done, out + done);
+}
+
+void packSpritesAVX2(const SpriteStore &store, const Uint32 *order,
+                     Uint32 first, Uint32 count, SpriteData *out) {
+  bool aligned = ((uintptr_t)out & 31) == 0;
+  if (order) {
+    aligned ? packAVX2<true, true>(store, order, first, count, out)
+            : packAVX2<false, true>(store, order, first, count, out);
+  } else {
+    aligned ? packAVX2<true, false>(store, order, first, count, out)
+            : packAVX2<false, false>(store, order, first, count, out);
+  }
+}
+
+// Four sprites per iteration. Every field is converted for four sprites at a
+// time (one field per register), then a 4x4 transpose turns them into the
+// two 16 byte rows of each record.
+SPRITE_SIMD_TARGET("avx2,f16c")
+static inline __m128i toUnorm4(__m128 value, __m128 scale) {
+  value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+}
+
+SPRITE_SIMD_TARGET("avx2,f16c")
+static inline __m128i toHalf4(__m128 value) {
+  return _mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT);
+}
+
+template <bool Indexed>
+SPRITE_SIMD_TARGET("avx2,f16c")
+static inline __m128 gather4(const std::vector<float> &values,
+                             __m128i indices, Uint32 s) {
+  if constexpr (Indexed) {
+    return _mm_i32gather_ps(values.data(), indices, 4);
+  } else {
+    return _mm_loadu_ps(&values[s]);
+  }
+}
+
+template <bool Indexed>
+SPRITE_SIMD_TARGET("avx2,f16c")
+static void packCompactF16C(const SpriteStore &store, const Uint32 *order,
+                            Uint32 first, Uint32 count,
+                            CompactSpriteData *out) {
+  const __m128 scale8 = _mm_set1_ps(255.0f);
+  const __m128 scale16 = _mm_set1_ps(65535.0f);
+  const __m128 scaleSnorm = _mm_set1_ps(32767.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  // r0 r1 r2 r3 g0 ... a3 -> r0 g0 b0 a0 r1 ...
+  const __m128i byteTranspose =
+      _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+  Uint32 blocks = count / 4;
+  for (Uint32 block = 0; block < blocks; block++) {
+    Uint32 s = first + block * 4;
+    __m128i i = _mm_setzero_si128();
+    if constexpr (Indexed) {
+      i = _mm_loadu_si128((const __m128i *)(order + s));
+    }
+
+    __m128i positionXY =
+        _mm_unpacklo_epi16(toHalf4(gather4<Indexed>(store.x, i, s)),
+                           toHalf4(gather4<Indexed>(store.y, i, s)));
+    __m128i scale =
+        _mm_unpacklo_epi16(toHalf4(gather4<Indexed>(store.w, i, s)),
+                           toHalf4(gather4<Indexed>(store.h, i, s)));
+
+    __m128 rotation = gather4<Indexed>(store.rotation, i, s);
+    __m128 turns = _mm_round_ps(
+        _mm_mul_ps(rotation, _mm_set1_ps(INV_TWO_PI)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    rotation = _mm_sub_ps(rotation, _mm_mul_ps(_mm_set1_ps(TWO_PI), turns));
+    rotation = _mm_mul_ps(rotation, _mm_set1_ps(INV_PI));
+    rotation = _mm_min_ps(_mm_max_ps(rotation, minusOne), one);
+    __m128i rotationSnorm = _mm_cvtps_epi32(_mm_mul_ps(rotation, scaleSnorm));
+    rotationSnorm = _mm_packs_epi32(rotationSnorm, rotationSnorm);
+    __m128i positionZRotation = _mm_unpacklo_epi16(
+        toHalf4(gather4<Indexed>(store.z, i, s)), rotationSnorm);
+
+    __m128i rg =
+        _mm_packus_epi32(toUnorm4(gather4<Indexed>(store.r, i, s), scale8),
+                         toUnorm4(gather4<Indexed>(store.g, i, s), scale8));
+    __m128i ba =
+        _mm_packus_epi32(toUnorm4(gather4<Indexed>(store.b, i, s), scale8),
+                         toUnorm4(gather4<Indexed>(store.a, i, s), scale8));
+    __m128i color =
+        _mm_shuffle_epi8(_mm_packus_epi16(rg, ba), byteTranspose);
+
+    // u0 u1 u2 u3 v0 v1 v2 v3 -> u0 v0 u1 v1 ...
+    __m128i uv = _mm_packus_epi32(
+        toUnorm4(gather4<Indexed>(store.texU, i, s), scale16),
+        toUnorm4(gather4<Indexed>(store.texV, i, s), scale16));
+    __m128i texUV = _mm_unpacklo_epi16(uv, _mm_srli_si128(uv, 8));
+    __m128i wh = _mm_packus_epi32(
+        toUnorm4(gather4<Indexed>(store.texW, i, s), scale16),
+        toUnorm4(gather4<Indexed>(store.texH, i, s), scale16));
+    __m128i texWH = _mm_unpacklo_epi16(wh, _mm_srli_si128(wh, 8));
+
+    __m128 front0 = _mm_castsi128_ps(positionXY);
+    __m128 front1 = _mm_castsi128_ps(positionZRotation);
+    __m128 front2 = _mm_castsi128_ps(scale);
+    __m128 front3 = _mm_castsi128_ps(color);
+    _MM_TRANSPOSE4_PS(front0, front1, front2, front3);
+
+    __m128 back0 = _mm_castsi128_ps(texUV);
+    __m128 back1 = _mm_castsi128_ps(texWH);
+    __m128 back2 = _mm_castsi128_ps(
+        _mm_cvttps_epi32(gather4<Indexed>(store.textureLayer, i, s)));
+    __m128 back3 = _mm_castsi128_ps(
+        _mm_cvttps_epi32(gather4<Indexed>(store.shape, i, s)));
+    _MM_TRANSPOSE4_PS(back0, back1, back2, back3);
+
+    float *dst = (float *)&out[block * 4];
+    _mm_storeu_ps(dst + 0, front0);
+    _mm_storeu_ps(dst + 4, back0);
+    _mm_storeu_ps(dst + 8, front1);
+    _mm_storeu_ps(dst + 12, back1);
+    _mm_storeu_ps(dst + 16, front2);
+    _mm_storeu_ps(dst + 20, back2);
+    _mm_storeu_ps(dst + 24, front3);
+    _mm_storeu_ps(dst + 28, back3);
+  }
+
+  Uint32 done = blocks * 4;
+  packCompactSpritesScalar(store, order, first + done, count - done,
+                           out + done);
+}
+
+void packCompactSpritesF16C(const SpriteStore &store, const Uint32 *order,
+                            Uint32 first, Uint32 count,
+                            CompactSpriteData *out) {
+  if (order) {
+    packCompactF16C<true>(store, order, first, count, out);
+  } else {
+    packCompactF16C<false>(store, order, first, count, out);
+  }
+}
+
+#else
+
+void packSpritesSSE41(const SpriteStore &store, const Uint32 *order,
+                      Uint32 first, Uint32 count, SpriteData *out) {
+  packSpritesScalar(store, order, first, count, out);
+}
+
+void packSpritesAVX2(const SpriteStore &store, const Uint32 *order,
+                     Uint32 first, Uint32 count, SpriteData *out) {
+  packSpritesScalar(store, order, first, count, out);
+}
+
+void packCompactSpritesF16C(const SpriteStore &store, const Uint32 *order,
+                            Uint32 first, Uint32 count,
+                            CompactSpriteData *out) {
+  packCompactSpritesScalar(store, order, first, count, out);
+}
+
+#endif
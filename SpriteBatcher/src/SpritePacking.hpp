@@ -0,0 +1,52 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+#include "SpriteStore.hpp"
+
+// Kernels that transpose a SpriteStore (structure-of-arrays) into std140
+// SpriteData records (array-of-structures). The destination is normally the
+// mapped transfer buffer, so nothing is staged in between.
+enum class PackKernel { Scalar, SSE41, AVX2 };
+
+// The fastest kernel this CPU supports. Checked once with SDL's cpuinfo.
+PackKernel detectPackKernel();
+const char *packKernelName(PackKernel kernel);
+
+// Packs sprites [first, first + count) into out[0, count). With an order
+// (from BatchKeySorter), output i takes sprite order[first + i] instead, so
+// sorted sprites are gathered straight out of the store. NULL keeps the
+// store's order.
+void packSprites(PackKernel kernel, const SpriteStore &store,
+                 const Uint32 *order, Uint32 first, Uint32 count,
+                 SpriteData *out);
+
+void packSpritesScalar(const SpriteStore &store, const Uint32 *order,
+                       Uint32 first, Uint32 count, SpriteData *out);
+void packSpritesSSE41(const SpriteStore &store, const Uint32 *order,
+                      Uint32 first, Uint32 count, SpriteData *out);
+void packSpritesAVX2(const SpriteStore &store, const Uint32 *order,
+                     Uint32 first, Uint32 count, SpriteData *out);
+
+// Same as packSprites, into the 32 byte compact layout. The AVX2 kernel uses
+// the F16C conversion instructions (every CPU with AVX2 has them). Both
+// kernels produce identical bits.
+void packCompactSprites(PackKernel kernel, const SpriteStore &store,
+                        const Uint32 *order, Uint32 first, Uint32 count,
+                        CompactSpriteData *out);
+
+void packCompactSpritesScalar(const SpriteStore &store, const Uint32 *order,
+                              Uint32 first, Uint32 count,
+                              CompactSpriteData *out);
+void packCompactSpritesF16C(const SpriteStore &store, const Uint32 *order,
+                            Uint32 first, Uint32 count, CompactSpriteData *out);
+
+// IEEE half float conversions with round-to-nearest-even, matching
+// _mm_cvtps_ph and GLSL's packHalf2x16.
+Uint16 floatToHalf(float value);
+float halfToFloat(Uint16 half);
+
+// Rotation as stored in CompactSpriteData: wrapped to [-pi, pi] and scaled to
+// snorm16, like GLSL's packSnorm2x16.
+Sint16 rotationToSnorm16(float radians);
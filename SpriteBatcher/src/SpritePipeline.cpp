@@ -0,0 +1,308 @@
+#include "SpritePipeline.hpp"
+
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_log.h"
+
+#include "SpriteShapes.hpp"
+
+SDL_GPUShader *loadShader(SDL_GPUDevice *device, const char *path,
+                          SDL_GPUShaderStage stage, Uint32 numSamplers,
+                          Uint32 numStorageBuffers, Uint32 numUniformBuffers) {
+  size_t codeSize;
+  void *code = SDL_LoadFile(path, &codeSize);
+  if (!code) {
+    SDL_Log("Failed to load shader %s.", path);
+    return NULL;
+  }
+
+  SDL_GPUShaderCreateInfo shaderInfo{};
+  shaderInfo.code = (Uint8 *)code;
+  shaderInfo.code_size = codeSize;
+  shaderInfo.entrypoint = "main";
+  shaderInfo.format = SDL_GPU_SHADERFORMAT_SPIRV;
+  shaderInfo.stage = stage;
+  shaderInfo.num_samplers = numSamplers;
+  shaderInfo.num_storage_buffers = numStorageBuffers;
+  shaderInfo.num_storage_textures = 0;
+  shaderInfo.num_uniform_buffers = numUniformBuffers;
+  SDL_GPUShader *shader = SDL_CreateGPUShader(device, &shaderInfo);
+
+  SDL_free(code);
+
+  if (!shader) {
+    SDL_Log("Failed to create shader %s: %s", path, SDL_GetError());
+  }
+  return shader;
+}
+
+SDL_GPUComputePipeline *
+loadComputePipeline(SDL_GPUDevice *device, const char *path,
+                    Uint32 numReadOnlyStorageBuffers,
+                    Uint32 numReadWriteStorageBuffers,
+                    Uint32 numUniformBuffers, Uint32 threadCountX) {
+  size_t codeSize;
+  void *code = SDL_LoadFile(path, &codeSize);
+  if (!code) {
+    SDL_Log("Failed to load shader %s.", path);
+    return NULL;
+  }
+
+  SDL_GPUComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.code = (Uint8 *)code;
+  pipelineInfo.code_size = codeSize;
+  pipelineInfo.entrypoint = "main";
+  pipelineInfo.format = SDL_GPU_SHADERFORMAT_SPIRV;
+  pipelineInfo.num_readonly_storage_buffers = numReadOnlyStorageBuffers;
+  pipelineInfo.num_readwrite_storage_buffers = numReadWriteStorageBuffers;
+  pipelineInfo.num_uniform_buffers = numUniformBuffers;
+  pipelineInfo.threadcount_x = threadCountX;
+  pipelineInfo.threadcount_y = 1;
+  pipelineInfo.threadcount_z = 1;
+  SDL_GPUComputePipeline *pipeline =
+      SDL_CreateGPUComputePipeline(device, &pipelineInfo);
+
+  SDL_free(code);
+
+  if (!pipeline) {
+    SDL_Log("Failed to create compute pipeline %s: %s", path, SDL_GetError());
+  }
+  return pipeline;
+}
+
+const char *spriteGeometryName(SpriteGeometry geometry) {
+  switch (geometry) {
+  case SpriteGeometry::Instanced:
+    return "instanced";
+  case SpriteGeometry::Trimmed:
+    return "trimmed";
+  case SpriteGeometry::VertexPulling:
+    break;
+  }
+  return "vertex pulling";
+}
+
+SDL_GPUTexture *createSpriteDepthTexture(SDL_GPUDevice *device, Uint32 width,
+                                         Uint32 height) {
+  SDL_GPUTextureCreateInfo textureInfo{};
+  textureInfo.type = SDL_GPU_TEXTURETYPE_2D;
+  textureInfo.format = SPRITE_DEPTH_FORMAT;
+  textureInfo.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+  textureInfo.width = width;
+  textureInfo.height = height;
+  textureInfo.layer_count_or_depth = 1;
+  textureInfo.num_levels = 1;
+  SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, &textureInfo);
+  if (!texture) {
+    SDL_Log("Failed to create depth texture: %s", SDL_GetError());
+  }
+  return texture;
+}
+
+SDL_GPUTexture *createWhiteTexture(SDL_GPUDevice *device,
+                                   SpriteTexturing texturing) {
+  SDL_GPUTextureCreateInfo textureInfo{};
+  textureInfo.type = texturing == SpriteTexturing::Array
+                         ? SDL_GPU_TEXTURETYPE_2D_ARRAY
+                         : SDL_GPU_TEXTURETYPE_2D;
+  textureInfo.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+  textureInfo.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+  textureInfo.width = 1;
+  textureInfo.height = 1;
+  textureInfo.layer_count_or_depth = 1;
+  textureInfo.num_levels = 1;
+  SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, &textureInfo);
+  if (!texture) {
+    SDL_Log("Failed to create texture: %s", SDL_GetError());
+    return NULL;
+  }
+
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = 4;
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  SDL_GPUTransferBuffer *transferBuffer =
+      SDL_CreateGPUTransferBuffer(device, &transferInfo);
+  Uint8 *data = transferBuffer ? (Uint8 *)SDL_MapGPUTransferBuffer(
+                                     device, transferBuffer, false)
+                               : NULL;
+  SDL_GPUCommandBuffer *commandBuffer =
+      data ? SDL_AcquireGPUCommandBuffer(device) : NULL;
+  if (!commandBuffer) {
+    SDL_Log("Failed to upload texture: %s", SDL_GetError());
+    if (data) {
+      SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    }
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_ReleaseGPUTexture(device, texture);
+    return NULL;
+  }
+  SDL_memset(data, 0xff, 4);
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  SDL_GPUTextureTransferInfo source{};
+  source.transfer_buffer = transferBuffer;
+  SDL_GPUTextureRegion destination{};
+  destination.texture = texture;
+  destination.w = 1;
+  destination.h = 1;
+  destination.d = 1;
+  SDL_UploadToGPUTexture(copyPass, &source, &destination, false);
+  SDL_EndGPUCopyPass(copyPass);
+  bool submitted = SDL_SubmitGPUCommandBuffer(commandBuffer);
+
+  // Released once the copy is done with it.
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  if (!submitted) {
+    SDL_Log("Failed to upload texture: %s", SDL_GetError());
+    SDL_ReleaseGPUTexture(device, texture);
+    return NULL;
+  }
+  return texture;
+}
+
+// What every sprite pipeline shares: no vertex input, one color target, and
+// the depth state of `depth`. additive is for the fragment counter, which
+// sums instead of blending.
+static SDL_GPUGraphicsPipeline *
+createPipeline(SDL_GPUDevice *device, const char *vertexPath,
+               Uint32 vertexStorageBuffers, Uint32 vertexUniformBuffers,
+               const char *fragmentPath,
+               SDL_GPUPrimitiveType primitiveType,
+               SDL_GPUTextureFormat colorFormat, bool additive,
+               SpriteDepth depth) {
+  // SpriteBuffer (and ShapeBuffer) at set 0 and ViewProjectionMatrix (and
+  // the tile layer's uniforms) at set 1.
+  SDL_GPUShader *vertexShader =
+      loadShader(device, vertexPath, SDL_GPU_SHADERSTAGE_VERTEX, 0,
+                 vertexStorageBuffers, vertexUniformBuffers);
+  // sampler2DArray (or sampler2D) Texture at set 2.
+  SDL_GPUShader *fragmentShader = loadShader(
+      device, fragmentPath, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0);
+
+  if (!vertexShader || !fragmentShader) {
+    SDL_ReleaseGPUShader(device, vertexShader);
+    SDL_ReleaseGPUShader(device, fragmentShader);
+    return NULL;
+  }
+
+  SDL_GPUGraphicsPipelineCreateInfo pipelineInfo{};
+  pipelineInfo.vertex_shader = vertexShader;
+  pipelineInfo.fragment_shader = fragmentShader;
+  pipelineInfo.primitive_type = primitiveType;
+
+  // Sprites are usually translucent, so standard alpha blending. Opaque ones
+  // overwrite whatever they cover.
+  SDL_GPUColorTargetDescription colorTargetDescriptions[1];
+  colorTargetDescriptions[0] = {};
+  colorTargetDescriptions[0].format = colorFormat;
+  SDL_GPUColorTargetBlendState &blend =
+      colorTargetDescriptions[0].blend_state;
+  if (additive) {
+    blend.enable_blend = true;
+    blend.color_blend_op = SDL_GPU_BLENDOP_ADD;
+    blend.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    blend.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    blend.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    blend.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    blend.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+  } else if (depth != SpriteDepth::Opaque) {
+    blend.enable_blend = true;
+    blend.color_blend_op = SDL_GPU_BLENDOP_ADD;
+    blend.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    blend.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+    blend.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    blend.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+    blend.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+  }
+
+  pipelineInfo.target_info.num_color_targets = 1;
+  pipelineInfo.target_info.color_target_descriptions = colorTargetDescriptions;
+
+  // Less or equal, so a sprite right at the back (depth 1, where the target
+  // is cleared to) still shows.
+  if (depth != SpriteDepth::None) {
+    pipelineInfo.target_info.has_depth_stencil_target = true;
+    pipelineInfo.target_info.depth_stencil_format = SPRITE_DEPTH_FORMAT;
+    pipelineInfo.depth_stencil_state.enable_depth_test = true;
+    pipelineInfo.depth_stencil_state.enable_depth_write =
+        depth == SpriteDepth::Opaque;
+    pipelineInfo.depth_stencil_state.compare_op =
+        SDL_GPU_COMPAREOP_LESS_OR_EQUAL;
+  }
+
+  SDL_GPUGraphicsPipeline *pipeline =
+      SDL_CreateGPUGraphicsPipeline(device, &pipelineInfo);
+  if (!pipeline) {
+    SDL_Log("Failed to create sprite pipeline: %s", SDL_GetError());
+  }
+
+  // The pipeline keeps what it needs. The shaders can go.
+  SDL_ReleaseGPUShader(device, vertexShader);
+  SDL_ReleaseGPUShader(device, fragmentShader);
+  return pipeline;
+}
+
+SDL_GPUGraphicsPipeline *
+createSpritePipeline(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                     SpriteLayout layout, SpriteTexturing texturing,
+                     SpriteGeometry geometry, SpriteDepth depth) {
+  bool compact = layout == SpriteLayout::Compact;
+  const char *vertexPath;
+  switch (geometry) {
+  case SpriteGeometry::Instanced:
+    vertexPath = compact ? "shaders/vertex_compact_instanced.vert.spv"
+                         : "shaders/vertex_instanced.vert.spv";
+    break;
+  case SpriteGeometry::Trimmed:
+    vertexPath = compact ? "shaders/vertex_compact_trimmed.vert.spv"
+                         : "shaders/vertex_trimmed.vert.spv";
+    break;
+  case SpriteGeometry::VertexPulling:
+  default:
+    vertexPath = compact ? "shaders/vertex_compact.vert.spv"
+                         : "shaders/vertex.vert.spv";
+    break;
+  }
+  const char *fragmentPath = texturing == SpriteTexturing::Single
+                                 ? "shaders/fragment_single.frag.spv"
+                                 : "shaders/fragment.frag.spv";
+  return createPipeline(device, vertexPath,
+                        geometry == SpriteGeometry::Trimmed ? 2 : 1, 1,
+                        fragmentPath,
+                        geometry == SpriteGeometry::Instanced
+                            ? SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP
+                            : SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                        colorFormat, false, depth);
+}
+
+SDL_GPUGraphicsPipeline *
+createTilePipeline(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                   SpriteTexturing texturing, SpriteDepth depth) {
+  const char *fragmentPath = texturing == SpriteTexturing::Single
+                                 ? "shaders/fragment_single.frag.spv"
+                                 : "shaders/fragment.frag.spv";
+  // TileBuffer and FrameBuffer, ViewProjectionMatrix and TileLayerBlock.
+  return createPipeline(device, "shaders/tiles.vert.spv", 2, 2, fragmentPath,
+                        SDL_GPU_PRIMITIVETYPE_TRIANGLELIST, colorFormat, false,
+                        depth);
+}
+
+SDL_GPUGraphicsPipeline *createFragmentCountPipeline(SDL_GPUDevice *device,
+                                                     SpriteDepth depth) {
+  return createPipeline(device, "shaders/vertex.vert.spv", 1, 1,
+                        "shaders/fragment_count.frag.spv",
+                        SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+                        SDL_GPU_TEXTUREFORMAT_R16_FLOAT, true, depth);
+}
+
+void drawSprites(SDL_GPURenderPass *renderPass, SpriteGeometry geometry,
+                 Uint32 first, Uint32 count) {
+  if (geometry == SpriteGeometry::Instanced) {
+    SDL_DrawGPUPrimitives(renderPass, 4, count, 0, first);
+  } else if (geometry == SpriteGeometry::Trimmed) {
+    SDL_DrawGPUPrimitives(renderPass, count * SPRITE_SHAPE_FAN_VERTICES, 1,
+                          first * SPRITE_SHAPE_FAN_VERTICES, 0);
+  } else {
+    SDL_DrawGPUPrimitives(renderPass, count * 6, 1, first * 6, 0);
+  }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+
+#include "SpriteData.hpp"
+
+// Loads a compiled SPIR-V shader from the shaders directory next to the
+// executable. Returns NULL (and logs) when the file is missing.
+SDL_GPUShader *loadShader(SDL_GPUDevice *device, const char *path,
+                          SDL_GPUShaderStage stage, Uint32 numSamplers,
+                          Uint32 numStorageBuffers, Uint32 numUniformBuffers);
+
+// Loads a compiled SPIR-V compute shader and creates its pipeline. SDL puts
+// read-only storage buffers at set 0, read-write ones at set 1 and uniforms at
+// set 2. threadCountX has to match the shader's local_size_x.
+SDL_GPUComputePipeline *
+loadComputePipeline(SDL_GPUDevice *device, const char *path,
+                    Uint32 numReadOnlyStorageBuffers,
+                    Uint32 numReadWriteStorageBuffers,
+                    Uint32 numUniformBuffers, Uint32 threadCountX);
+
+// What fragment.frag samples.
+enum class SpriteTexturing {
+  // sampler2DArray, indexed by SpriteData's textureLayer. Textures bound to
+  // the pipeline have to be SDL_GPU_TEXTURETYPE_2D_ARRAY.
+  Array,
+  // sampler2D, the fallback variant (fragment_single.frag.spv).
+  // textureLayer is ignored.
+  Single,
+};
+
+// How vertex.vert finds its sprite and corner.
+enum class SpriteGeometry {
+  // A triangle list of 6 vertices per sprite. Sprite gl_VertexIndex / 6,
+  // corner from a table indexed by gl_VertexIndex % 6.
+  VertexPulling,
+  // A 4 vertex triangle strip, one instance per sprite. Sprite
+  // gl_InstanceIndex, corner gl_VertexIndex (the _instanced variants).
+  Instanced,
+  // A triangle list of SPRITE_SHAPE_FAN_VERTICES per sprite, a fan over the
+  // sprite's entry in the shape table (the _trimmed variants). The table is
+  // a second storage buffer, at set 0, binding 1. See SpriteShapes.hpp.
+  Trimmed,
+};
+
+const char *spriteGeometryName(SpriteGeometry geometry);
+
+// Whether a sprite pipeline uses a depth target, and how. The depth is
+// SpriteData's z (0 in front, 1 at the back) as the orthographic matrix
+// leaves it, so the scene's layers have to be folded in first, see
+// layeredDepth in BatchKey.hpp.
+enum class SpriteDepth {
+  // No depth target; the draw order is all there is. The default.
+  None,
+  // No blending, writes depth, and only passes fragments in front of what
+  // was already drawn. Drawn front to back, early-Z skips the fragment
+  // shader wherever an earlier sprite covers the pixel.
+  Opaque,
+  // Blended like None, tested against the depth of the opaque pass but
+  // doesn't write it. Still needs the back to front order.
+  Translucent,
+};
+
+// D16 is the one depth format every Vulkan driver renders to. Sprite depth is
+// a random float in the demo, so 65536 steps are plenty.
+inline constexpr SDL_GPUTextureFormat SPRITE_DEPTH_FORMAT =
+    SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+
+// A depth target for the SpriteDepth pipelines, cleared to 1 (the back) by
+// the render pass.
+SDL_GPUTexture *createSpriteDepthTexture(SDL_GPUDevice *device, Uint32 width,
+                                         Uint32 height);
+
+// A single white texel, of the texture type the texturing's fragment shader
+// variant samples: a one layer array for Array, a 2D texture for Single. For
+// the benchmarks and the geometry probe, which are about moving sprites, not
+// about sampling. The upload is submitted, not waited for.
+SDL_GPUTexture *
+createWhiteTexture(SDL_GPUDevice *device,
+                   SpriteTexturing texturing = SpriteTexturing::Array);
+
+// The sprite pipeline has no vertex input at all. Everything comes from the
+// SpriteBuffer storage buffer (see shaders/vertex.vert). The layout and the
+// geometry pick the vertex shader variant, and have to match the SpriteBatch
+// it draws. The texturing picks the fragment shader variant.
+// With a SpriteDepth other than None the render pass needs a
+// SPRITE_DEPTH_FORMAT depth target.
+SDL_GPUGraphicsPipeline *
+createSpritePipeline(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                     SpriteLayout layout,
+                     SpriteTexturing texturing = SpriteTexturing::Array,
+                     SpriteGeometry geometry = SpriteGeometry::VertexPulling,
+                     SpriteDepth depth = SpriteDepth::None);
+
+// Draws TileMap chunks: tiles.vert, which reads the tiles and the frame table
+// at set 0 and a layer's uniforms at set 1, binding 1, with the sprites'
+// fragment shader and blending. Tiles are tested against a depth target like
+// translucent sprites, so pass SpriteDepth::Translucent when the render pass
+// has one.
+SDL_GPUGraphicsPipeline *
+createTilePipeline(SDL_GPUDevice *device, SDL_GPUTextureFormat colorFormat,
+                   SpriteTexturing texturing = SpriteTexturing::Array,
+                   SpriteDepth depth = SpriteDepth::None);
+
+// The same geometry and depth state as the std140, vertex pulling sprite
+// pipeline, but every fragment that passes the depth test adds 1 to an
+// R16_FLOAT target (fragment_count.frag.spv). Summing the target gives the
+// fragments a frame shaded, exact up to 2048 layers per pixel. Nothing
+// discards, so a fragment that fails the depth test is one early-Z never
+// shades.
+SDL_GPUGraphicsPipeline *createFragmentCountPipeline(SDL_GPUDevice *device,
+                                                     SpriteDepth depth);
+
+// Draws sprites [first, first + count) of the bound SpriteBuffer, the way a
+// pipeline of that geometry expects. Every variant sees the first sprite
+// through the built-in index (gl_VertexIndex or gl_InstanceIndex), which
+// Vulkan offsets by the draw's first vertex or instance.
+void drawSprites(SDL_GPURenderPass *renderPass, SpriteGeometry geometry,
+                 Uint32 first, Uint32 count);
@@ -0,0 +1,55 @@
+#include "SpritePool.hpp"
+
+void SpritePool::init(Uint32 capacity) {
+  slots.clear();
+  owners.clear();
+  store.clear();
+  slots.reserve(capacity);
+  owners.reserve(capacity);
+  store.reserve(capacity);
+  freeSlot = NO_SLOT;
+}
+
+void SpritePool::clear() {
+  for (Uint32 slot : owners) {
+    slots[slot].generation++;
+    slots[slot].dense = freeSlot;
+    freeSlot = slot;
+  }
+  owners.clear();
+  store.clear();
+}
+
+SpriteHandle SpritePool::create(const SpriteData &sprite) {
+  Uint32 slot = freeSlot;
+  if (slot != NO_SLOT) {
+    freeSlot = slots[slot].dense;
+    slots[slot].generation++;
+  } else {
+    slot = (Uint32)slots.size();
+    slots.push_back({0, 1});
+  }
+  slots[slot].dense = store.size();
+  owners.push_back(slot);
+  store.push(sprite);
+  return {slot, slots[slot].generation};
+}
+
+bool SpritePool::destroy(SpriteHandle handle) {
+  if (!valid(handle)) {
+    return false;
+  }
+  Slot &slot = slots[handle.index];
+  Uint32 dense = slot.dense;
+  Uint32 last = store.size() - 1;
+  // The last sprite takes the hole; its slot follows it.
+  store.swapRemove(dense);
+  owners[dense] = owners[last];
+  slots[owners[dense]].dense = dense;
+  owners.pop_back();
+
+  slot.generation++;
+  slot.dense = freeSlot;
+  freeSlot = handle.index;
+  return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+#include "SpriteStore.hpp"
+
+#include <vector>
+
+// Refers to a sprite in a SpritePool. index picks the slot, generation is
+// the slot's generation when the sprite was created. Destroying the sprite
+// bumps the slot's generation, so old handles stop resolving instead of
+// pointing at whatever sprite reuses the slot. Live generations are odd, so
+// a zeroed handle is always invalid.
+struct SpriteHandle {
+  Uint32 index;
+  Uint32 generation;
+};
+
+// Sprites that come and go all the time, like bullets. They live densely
+// packed in a SpriteStore, so iterating them or handing them to the packers
+// walks the same contiguous arrays a SpriteBatch does. Handles stay put
+// while the sprites move:
+// - create pops a free slot (or appends one) and pushes the sprite onto the
+//   end of the store.
+// - destroy swap-removes: the last sprite moves into the hole and its slot
+//   is pointed at the new place. The freed slot goes on a free list that is
+//   threaded through the slots themselves.
+// Both are O(1). Nothing is allocated per sprite; the arrays only grow when
+// the pool gets larger than it has ever been (or the init capacity).
+//
+// Destroying reorders the store. To destroy while iterating, walk it from the
+// back: the sprite that fills the hole has already been visited.
+class SpritePool {
+public:
+  void init(Uint32 capacity);
+  // Destroys every sprite. Old handles become invalid.
+  void clear();
+
+  SpriteHandle create(const SpriteData &sprite);
+  // Returns false when the handle is stale.
+  bool destroy(SpriteHandle handle);
+
+  bool valid(SpriteHandle handle) const {
+    return handle.index < slots.size() &&
+           slots[handle.index].generation == handle.generation &&
+           (handle.generation & 1) != 0;
+  }
+  // Where the sprite is in sprites(), or ~0 for a stale handle. Only good
+  // until the next destroy.
+  Uint32 find(SpriteHandle handle) const {
+    return valid(handle) ? slots[handle.index].dense : ~0u;
+  }
+  // The handle of the sprite at a position in sprites().
+  SpriteHandle handleAt(Uint32 dense) const {
+    return {owners[dense], slots[owners[dense]].generation};
+  }
+
+  Uint32 size() const { return store.size(); }
+  // Writable, for updating attributes in place; adding or removing sprites
+  // has to go through create and destroy.
+  SpriteStore &sprites() { return store; }
+  const SpriteStore &sprites() const { return store; }
+
+private:
+  static const Uint32 NO_SLOT = ~0u;
+
+  struct Slot {
+    // Position in the store while alive, the next free slot while free.
+    Uint32 dense;
+    // Odd while alive, even while free.
+    Uint32 generation;
+  };
+
+  std::vector<Slot> slots;
+  // The slot of each sprite in the store.
+  std::vector<Uint32> owners;
+  SpriteStore store;
+  Uint32 freeSlot = NO_SLOT;
+};
@@ -0,0 +1,280 @@
+#include "SpriteShapes.hpp"
+
+#include "SDL3/SDL_log.h"
+
+#include <algorithm>
+#include <cmath>
+
+// In texels. Doubles, since the cross products of a large image's corners
+// don't fit in a float's 24 bits.
+struct ShapePoint {
+  double x, y;
+};
+
+// Positive when o -> a -> b turns the same way as the hull's corners.
+static double cross(const ShapePoint &o, const ShapePoint &a,
+                    const ShapePoint &b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Andrew's monotone chain. Collinear and duplicate points are dropped, so
+// every corner of the hull turns.
+static void convexHull(std::vector<ShapePoint> &points,
+                       std::vector<ShapePoint> &hull) {
+  std::sort(points.begin(), points.end(),
+            [](const ShapePoint &a, const ShapePoint &b) {
+              return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+  hull.assign(points.size() * 2, {});
+  size_t k = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+      k--;
+    }
+    hull[k++] = points[i];
+  }
+  for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+      k--;
+    }
+    hull[k++] = points[i];
+  }
+  // The last point is the first one again.
+  hull.resize(k - 1);
+}
+
+// Removes an edge at a time by extending its two neighbors until they meet,
+// which keeps the polygon convex and around everything it held. Each time
+// it's the edge whose removal adds the least area, as long as the new corner
+// stays inside the image. Returns false when no edge can go.
+static bool cutCorners(std::vector<ShapePoint> &hull, double width,
+                       double height) {
+  while (hull.size() > SPRITE_SHAPE_VERTICES) {
+    size_t n = hull.size();
+    size_t best = n;
+    double bestArea = 0.0;
+    ShapePoint bestCorner{};
+    for (size_t i = 0; i < n; i++) {
+      const ShapePoint &previous = hull[(i + n - 1) % n];
+      const ShapePoint &a = hull[i];
+      const ShapePoint &b = hull[(i + 1) % n];
+      const ShapePoint &next = hull[(i + 2) % n];
+      double d0x = a.x - previous.x, d0y = a.y - previous.y;
+      double d1x = next.x - b.x, d1y = next.y - b.y;
+      // The neighbors only meet beyond the edge while they turn less than
+      // half a turn between them.
+      double denominator = d0x * d1y - d0y * d1x;
+      if (denominator <= 0.0) {
+        continue;
+      }
+      double t = ((b.x - a.x) * d1y - (b.y - a.y) * d1x) / denominator;
+      ShapePoint corner = {a.x + t * d0x, a.y + t * d0y};
+      const double slack = 1e-6 * (width + height);
+      if (corner.x < -slack || corner.y < -slack ||
+          corner.x > width + slack || corner.y > height + slack) {
+        continue;
+      }
+      double area = 0.5 * cross(a, corner, b);
+      area = area < 0.0 ? -area : area;
+      if (best == n || area < bestArea) {
+        best = i;
+        bestArea = area;
+        bestCorner = corner;
+      }
+    }
+    if (best == n) {
+      return false;
+    }
+    bestCorner.x = SDL_clamp(bestCorner.x, 0.0, width);
+    bestCorner.y = SDL_clamp(bestCorner.y, 0.0, height);
+    hull[best] = bestCorner;
+    hull.erase(hull.begin() + (best + 1) % n);
+  }
+  return true;
+}
+
+Uint32 trimSpriteShape(const Uint8 *pixels, Uint32 width, Uint32 height,
+                       Uint8 alphaThreshold, float margin, SpriteShape &out,
+                       float &areaFraction) {
+  out = {};
+  areaFraction = 0.0f;
+
+  // The outermost visible texels of every row are all the hull needs: the
+  // corners of the row's span, grown by the margin and kept in the image.
+  std::vector<ShapePoint> points;
+  for (Uint32 y = 0; y < height; y++) {
+    const Uint8 *row = pixels + (size_t)y * width * 4;
+    Uint32 first = 0;
+    while (first < width && row[first * 4 + 3] <= alphaThreshold) {
+      first++;
+    }
+    if (first == width) {
+      continue;
+    }
+    Uint32 last = width - 1;
+    while (row[last * 4 + 3] <= alphaThreshold) {
+      last--;
+    }
+    double left = SDL_max((double)first - margin, 0.0);
+    double right = SDL_min((double)last + 1.0 + margin, (double)width);
+    double top = SDL_max((double)y - margin, 0.0);
+    double bottom = SDL_min((double)y + 1.0 + margin, (double)height);
+    points.push_back({left, top});
+    points.push_back({right, top});
+    points.push_back({left, bottom});
+    points.push_back({right, bottom});
+  }
+  // Nothing to draw: one corner, so every triangle of the fan is empty.
+  if (points.empty()) {
+    return 1;
+  }
+
+  std::vector<ShapePoint> hull;
+  convexHull(points, hull);
+  if (!cutCorners(hull, width, height)) {
+    return 0;
+  }
+
+  double area = 0.0;
+  for (size_t i = 0; i < hull.size(); i++) {
+    area += cross({0.0, 0.0}, hull[i], hull[(i + 1) % hull.size()]);
+  }
+  areaFraction = (float)(std::fabs(area) * 0.5 / ((double)width * height));
+
+  Uint32 count = (Uint32)hull.size();
+  for (Uint32 i = 0; i < SPRITE_SHAPE_VERTICES; i++) {
+    const ShapePoint &corner = hull[SDL_min(i, count - 1)];
+    out.corners[i][0] = (float)(corner.x / width);
+    out.corners[i][1] = (float)(corner.y / height);
+  }
+  return count;
+}
+
+bool SpriteShapeTable::init(SDL_GPUDevice *device,
+                            const SpriteShapeSettings &settings) {
+  this->device = device;
+  this->settings = settings;
+  this->settings.capacity = SDL_max(settings.capacity, 1u);
+
+  // Entry 0, the full quad, in the order a fan covers it.
+  SpriteShape quad{};
+  const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  for (Uint32 i = 0; i < SPRITE_SHAPE_VERTICES; i++) {
+    quad.corners[i][0] = corners[SDL_min(i, 3u)][0];
+    quad.corners[i][1] = corners[SDL_min(i, 3u)][1];
+  }
+  shapes.assign(1, quad);
+  saved.assign(1, 0.0f);
+  freeShapes.clear();
+  liveShapes = 0;
+  dirtyFirst = 0;
+  dirtyEnd = 1;
+
+  Uint32 size = this->settings.capacity * sizeof(SpriteShape);
+  SDL_GPUBufferCreateInfo bufferInfo{};
+  bufferInfo.size = size;
+  // Only the vertex shader reads it.
+  bufferInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  shapeBuffer = SDL_CreateGPUBuffer(device, &bufferInfo);
+
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = size;
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+
+  if (!shapeBuffer || !transferBuffer) {
+    SDL_Log("Failed to create the shape table: %s", SDL_GetError());
+    release();
+    return false;
+  }
+  return true;
+}
+
+void SpriteShapeTable::release() {
+  if (!device) {
+    return;
+  }
+  SDL_ReleaseGPUBuffer(device, shapeBuffer);
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  shapeBuffer = nullptr;
+  transferBuffer = nullptr;
+  shapes.clear();
+  saved.clear();
+  freeShapes.clear();
+  liveShapes = 0;
+  dirtyFirst = dirtyEnd = 0;
+}
+
+Uint32 SpriteShapeTable::add(const Uint8 *pixels, Uint32 width,
+                             Uint32 height) {
+  SpriteShape shape;
+  float areaFraction;
+  if (trimSpriteShape(pixels, width, height, settings.alphaThreshold,
+                      settings.margin, shape, areaFraction) == 0 ||
+      1.0f - areaFraction < settings.minSavedFraction) {
+    return 0;
+  }
+
+  Uint32 index;
+  if (!freeShapes.empty()) {
+    index = freeShapes.back();
+    freeShapes.pop_back();
+  } else if (shapes.size() < settings.capacity) {
+    index = (Uint32)shapes.size();
+    shapes.emplace_back();
+    saved.push_back(0.0f);
+  } else {
+    return 0;
+  }
+  shapes[index] = shape;
+  saved[index] = 1.0f - areaFraction;
+  liveShapes++;
+
+  if (dirtyFirst >= dirtyEnd) {
+    dirtyFirst = index;
+    dirtyEnd = index + 1;
+  } else {
+    dirtyFirst = SDL_min(dirtyFirst, index);
+    dirtyEnd = SDL_max(dirtyEnd, index + 1);
+  }
+  return index;
+}
+
+void SpriteShapeTable::remove(Uint32 shape) {
+  if (shape == 0 || shape >= shapes.size()) {
+    return;
+  }
+  // No sprite draws it anymore, so the GPU copy can stay until it's reused.
+  saved[shape] = 0.0f;
+  freeShapes.push_back(shape);
+  liveShapes--;
+}
+
+bool SpriteShapeTable::upload(SDL_GPUCommandBuffer *commandBuffer) {
+  if (dirtyFirst >= dirtyEnd) {
+    return true;
+  }
+
+  Uint32 size = (dirtyEnd - dirtyFirst) * sizeof(SpriteShape);
+  void *data = SDL_MapGPUTransferBuffer(device, transferBuffer, true);
+  if (!data) {
+    SDL_Log("Failed to map the shape transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+  SDL_memcpy(data, &shapes[dirtyFirst], size);
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  SDL_GPUTransferBufferLocation source{};
+  source.transfer_buffer = transferBuffer;
+  SDL_GPUBufferRegion destination{};
+  destination.buffer = shapeBuffer;
+  destination.offset = dirtyFirst * sizeof(SpriteShape);
+  destination.size = size;
+  // Not cycled: the other entries are still in use.
+  SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+  SDL_EndGPUCopyPass(copyPass);
+
+  dirtyFirst = dirtyEnd = 0;
+  return true;
+}
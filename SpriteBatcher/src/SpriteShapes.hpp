@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include <vector>
+
+// Corners per shape. A shape with fewer repeats its last corner, which turns
+// the rest of its fan into triangles without area that the rasterizer skips.
+inline constexpr Uint32 SPRITE_SHAPE_VERTICES = 8;
+// Vertices per sprite with SpriteGeometry::Trimmed: a fan of
+// SPRITE_SHAPE_VERTICES - 2 triangles around the first corner.
+inline constexpr Uint32 SPRITE_SHAPE_FAN_VERTICES =
+    (SPRITE_SHAPE_VERTICES - 2) * 3;
+
+// GPU mirror of one shape in ShapeBuffer in shaders/vertex.vert (std430,
+// vec2 ShapeVertices[]). The corners are in the sprite's own unit square,
+// x to the right and y down like the image's rows, so the same point gives
+// both the position (times Scale) and the texture coordinate (times the
+// texture rect).
+struct SpriteShape {
+  float corners[SPRITE_SHAPE_VERTICES][2];
+};
+static_assert(sizeof(SpriteShape) == 64, "SpriteShape must be 8 vec2s");
+
+// The tightest convex polygon of at most SPRITE_SHAPE_VERTICES corners
+// around the texels of an RGBA8 image whose alpha is above alphaThreshold,
+// grown by margin texels. It starts from the convex hull of the visible
+// texels and cuts corners until it's down to the limit, each time the one
+// whose cut adds the least area. Returns the number of corners (the rest of
+// out repeats the last one), 0 when the hull can't be cut down without
+// leaving the image. Its area as a fraction of the image goes into
+// areaFraction. An image with nothing visible gets a single corner at 0, 0
+// and an area of 0.
+Uint32 trimSpriteShape(const Uint8 *pixels, Uint32 width, Uint32 height,
+                       Uint8 alphaThreshold, float margin, SpriteShape &out,
+                       float &areaFraction);
+
+struct SpriteShapeSettings {
+  // Shapes the table has room for, the full quad at 0 included. Images added
+  // once it's full are drawn as quads.
+  Uint32 capacity = 4096;
+  // Texels with an alpha above this count as visible. 0 keeps everything
+  // that shows at all.
+  Uint8 alphaThreshold = 0;
+  // Texels of transparent border kept around the visible ones. Half a texel
+  // is what bilinear filtering pulls in from outside; with nearest
+  // filtering 0 is exact.
+  float margin = 0.5f;
+  // An image only gets a shape when it leaves out at least this much of its
+  // quad.
+  float minSavedFraction = 0.1f;
+  // A sprite only draws its shape when that saves at least this many pixels
+  // on screen. The fan has 12 more vertices than the quad, and below this
+  // they cost more than the fragments they save.
+  float minSavedPixels = 256.0f;
+};
+
+// The shared vertex table for SpriteGeometry::Trimmed: one SpriteShape per
+// entry in a storage buffer, bound at set 0, binding 1 of the vertex shader
+// next to the sprites. SpriteData's shape picks the entry. Entry 0 is the
+// full quad, so any sprite can be drawn with a Trimmed pipeline.
+//
+// Shapes are computed once, when an image is loaded, and add() only copies
+// them into a CPU array. upload() writes the entries added since the last
+// upload in one copy pass; call it once per frame before the render pass,
+// like TextureAtlas::upload.
+//
+// Which sprites draw their shape is up to the caller, but worthDrawing()
+// makes the call from the area the shape saves at the sprite's size on
+// screen. A sprite that doesn't draw it goes through a quad pipeline.
+class SpriteShapeTable {
+public:
+  bool init(SDL_GPUDevice *device, const SpriteShapeSettings &settings);
+  void release();
+
+  // Trims an RGBA8 image (rows of width * 4 bytes, like TextureAtlas::insert
+  // takes) and returns its entry. Returns 0, the full quad, when the shape
+  // wouldn't save minSavedFraction or the table is full.
+  Uint32 add(const Uint8 *pixels, Uint32 width, Uint32 height);
+  // Frees an entry for later adds. Removing 0 does nothing.
+  void remove(Uint32 shape);
+
+  bool upload(SDL_GPUCommandBuffer *commandBuffer);
+
+  // The fraction of its quad a shape leaves out, 0 for the full quad.
+  float savedFraction(Uint32 shape) const {
+    return shape < saved.size() ? saved[shape] : 0.0f;
+  }
+  // Whether a sprite whose quad covers quadPixels pixels on screen should
+  // draw shape instead.
+  bool worthDrawing(Uint32 shape, float quadPixels) const {
+    return shape != 0 &&
+           quadPixels * savedFraction(shape) >= settings.minSavedPixels;
+  }
+
+  SDL_GPUBuffer *buffer() const { return shapeBuffer; }
+  // Entries in use, the full quad not counted.
+  Uint32 shapeCount() const { return liveShapes; }
+
+private:
+  SDL_GPUDevice *device = nullptr;
+  SpriteShapeSettings settings;
+  SDL_GPUBuffer *shapeBuffer = nullptr;
+  SDL_GPUTransferBuffer *transferBuffer = nullptr;
+
+  std::vector<SpriteShape> shapes;
+  std::vector<float> saved;
+  std::vector<Uint32> freeShapes;
+  Uint32 liveShapes = 0;
+  // Entries changed since the last upload, [dirtyFirst, dirtyEnd).
+  Uint32 dirtyFirst = 0;
+  Uint32 dirtyEnd = 0;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+// Shared by the SIMD kernels (packing, culling). Only included from .cpp
+// files, so the rest of the program never sees the intrinsics.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define SPRITE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that ask for
+// them. That way the rest of the program still runs on any x86-64 CPU and the
+// kernel is picked at runtime. MSVC doesn't need (or have) the attribute.
+#if defined(__GNUC__) || defined(__clang__)
+#define SPRITE_SIMD_TARGET(x) __attribute__((target(x)))
+#else
+#define SPRITE_SIMD_TARGET(x)
+#endif
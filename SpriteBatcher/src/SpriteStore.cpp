@@ -0,0 +1,159 @@
+#include "SpriteStore.hpp"
+
+void SpriteStore::clear() {
+  x.clear();
+  y.clear();
+  z.clear();
+  rotation.clear();
+  w.clear();
+  h.clear();
+  textureLayer.clear();
+  shape.clear();
+  texU.clear();
+  texV.clear();
+  texW.clear();
+  texH.clear();
+  r.clear();
+  g.clear();
+  b.clear();
+  a.clear();
+}
+
+void SpriteStore::reserve(Uint32 count) {
+  x.reserve(count);
+  y.reserve(count);
+  z.reserve(count);
+  rotation.reserve(count);
+  w.reserve(count);
+  h.reserve(count);
+  textureLayer.reserve(count);
+  shape.reserve(count);
+  texU.reserve(count);
+  texV.reserve(count);
+  texW.reserve(count);
+  texH.reserve(count);
+  r.reserve(count);
+  g.reserve(count);
+  b.reserve(count);
+  a.reserve(count);
+}
+
+void SpriteStore::push(const SpriteData &sprite) {
+  x.push_back(sprite.x);
+  y.push_back(sprite.y);
+  z.push_back(sprite.z);
+  rotation.push_back(sprite.rotation);
+  w.push_back(sprite.w);
+  h.push_back(sprite.h);
+  textureLayer.push_back(sprite.textureLayer);
+  shape.push_back(sprite.shape);
+  texU.push_back(sprite.texU);
+  texV.push_back(sprite.texV);
+  texW.push_back(sprite.texW);
+  texH.push_back(sprite.texH);
+  r.push_back(sprite.r);
+  g.push_back(sprite.g);
+  b.push_back(sprite.b);
+  a.push_back(sprite.a);
+}
+
+// Appends one attribute array to another.
+static void appendArray(std::vector<float> &to,
+                        const std::vector<float> &from) {
+  to.insert(to.end(), from.begin(), from.end());
+}
+
+void SpriteStore::append(const SpriteStore &other) {
+  appendArray(x, other.x);
+  appendArray(y, other.y);
+  appendArray(z, other.z);
+  appendArray(rotation, other.rotation);
+  appendArray(w, other.w);
+  appendArray(h, other.h);
+  appendArray(textureLayer, other.textureLayer);
+  appendArray(shape, other.shape);
+  appendArray(texU, other.texU);
+  appendArray(texV, other.texV);
+  appendArray(texW, other.texW);
+  appendArray(texH, other.texH);
+  appendArray(r, other.r);
+  appendArray(g, other.g);
+  appendArray(b, other.b);
+  appendArray(a, other.a);
+}
+
+SpriteData SpriteStore::get(Uint32 index) const {
+  SpriteData sprite{};
+  sprite.x = x[index];
+  sprite.y = y[index];
+  sprite.z = z[index];
+  sprite.rotation = rotation[index];
+  sprite.w = w[index];
+  sprite.h = h[index];
+  sprite.textureLayer = textureLayer[index];
+  sprite.shape = shape[index];
+  sprite.texU = texU[index];
+  sprite.texV = texV[index];
+  sprite.texW = texW[index];
+  sprite.texH = texH[index];
+  sprite.r = r[index];
+  sprite.g = g[index];
+  sprite.b = b[index];
+  sprite.a = a[index];
+  return sprite;
+}
+
+void SpriteStore::set(Uint32 index, const SpriteData &sprite) {
+  x[index] = sprite.x;
+  y[index] = sprite.y;
+  z[index] = sprite.z;
+  rotation[index] = sprite.rotation;
+  w[index] = sprite.w;
+  h[index] = sprite.h;
+  textureLayer[index] = sprite.textureLayer;
+  shape[index] = sprite.shape;
+  texU[index] = sprite.texU;
+  texV[index] = sprite.texV;
+  texW[index] = sprite.texW;
+  texH[index] = sprite.texH;
+  r[index] = sprite.r;
+  g[index] = sprite.g;
+  b[index] = sprite.b;
+  a[index] = sprite.a;
+}
+
+void SpriteStore::swapRemove(Uint32 index) {
+  Uint32 last = size() - 1;
+  x[index] = x[last];
+  y[index] = y[last];
+  z[index] = z[last];
+  rotation[index] = rotation[last];
+  w[index] = w[last];
+  h[index] = h[last];
+  textureLayer[index] = textureLayer[last];
+  shape[index] = shape[last];
+  texU[index] = texU[last];
+  texV[index] = texV[last];
+  texW[index] = texW[last];
+  texH[index] = texH[last];
+  r[index] = r[last];
+  g[index] = g[last];
+  b[index] = b[last];
+  a[index] = a[last];
+  x.pop_back();
+  y.pop_back();
+  z.pop_back();
+  rotation.pop_back();
+  w.pop_back();
+  h.pop_back();
+  textureLayer.pop_back();
+  shape.pop_back();
+  texU.pop_back();
+  texV.pop_back();
+  texW.pop_back();
+  texH.pop_back();
+  r.pop_back();
+  g.pop_back();
+  b.pop_back();
+  a.pop_back();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpriteData.hpp"
+
+#include <vector>
+
+// The same attributes as SpriteData, but one array per attribute
+// (structure-of-arrays). Gameplay code that touches only positions or colors
+// walks tightly packed floats, and the SIMD packers can load four or eight
+// sprites' worth of one attribute with a single instruction.
+struct SpriteStore {
+  std::vector<float> x, y, z;
+  std::vector<float> rotation;
+  std::vector<float> w, h;
+  std::vector<float> textureLayer;
+  std::vector<float> shape;
+  std::vector<float> texU, texV, texW, texH;
+  std::vector<float> r, g, b, a;
+
+  Uint32 size() const { return (Uint32)x.size(); }
+
+  // Keeps the allocations, so a store that is refilled every frame stops
+  // allocating once it has seen its largest frame.
+  void clear();
+  void reserve(Uint32 count);
+  void push(const SpriteData &sprite);
+  // Appends every sprite of other, one bulk copy per attribute array.
+  void append(const SpriteStore &other);
+  SpriteData get(Uint32 index) const;
+  void set(Uint32 index, const SpriteData &sprite);
+  // Moves the last sprite into index and shrinks by one. O(1), but the
+  // order changes.
+  void swapRemove(Uint32 index);
+};
@@ -0,0 +1,177 @@
+#include "TextRenderer.hpp"
+
+#include "SDL3/SDL_log.h"
+
+#include "BatchKey.hpp"
+
+bool TextRenderer::init(const TextRendererSettings &settings) {
+  if (!settings.atlas || !settings.pageTexture) {
+    SDL_Log("A text renderer needs an atlas and a way to bind its pages");
+    return false;
+  }
+  this->settings = settings;
+  textStats = {};
+  frame = 0;
+  atlasFullLogged = false;
+  return true;
+}
+
+void TextRenderer::release() {
+  // The glyphs stay in the atlas until it's released; they're not evicted
+  // one by one.
+  fonts.clear();
+  glyphs.clear();
+  runs.clear();
+  key.clear();
+  glyphPixels.clear();
+  textStats = {};
+}
+
+Uint16 TextRenderer::addFont(const BitmapFont &font) {
+  fonts.push_back(font);
+  return (Uint16)(fonts.size() - 1);
+}
+
+void TextRenderer::beginFrame() {
+  Uint32 evicted = 0;
+  if (runs.size() > settings.maxRuns) {
+    // Whatever wasn't drawn last frame. Labels that are on screen keep
+    // their runs, however many there are.
+    for (auto it = runs.begin(); it != runs.end();) {
+      if (it->second.lastFrame != frame) {
+        it = runs.erase(it);
+        evicted++;
+      } else {
+        ++it;
+      }
+    }
+  }
+  frame++;
+
+  Uint64 glyphTexels = textStats.glyphTexels;
+  textStats = {};
+  textStats.evictedRuns = evicted;
+  textStats.glyphTexels = glyphTexels;
+  textStats.cachedRuns = (Uint32)runs.size();
+  textStats.cachedGlyphs = (Uint32)glyphs.size();
+  float occupancy = 0.0f;
+  for (Uint32 page = 0; page < settings.atlas->pageCount(); page++) {
+    occupancy += settings.atlas->pageOccupancy(page);
+  }
+  textStats.atlasOccupancy =
+      occupancy / SDL_max(settings.atlas->pageCount(), 1u);
+}
+
+const TextRenderer::Glyph &TextRenderer::glyph(Uint16 font, Uint16 size,
+                                               Uint32 codepoint) {
+  Uint64 glyphKey = (Uint64)font << 48 | (Uint64)size << 32 | codepoint;
+  auto found = glyphs.find(glyphKey);
+  if (found != glyphs.end()) {
+    return found->second;
+  }
+
+  Glyph &glyph = glyphs[glyphKey];
+  glyph = {};
+  if (!rasterizeGlyph(fonts[font], codepoint, size, glyphPixels)) {
+    // A space: it advances, nothing more.
+    return glyph;
+  }
+  GlyphLayout layout = glyphLayout(fonts[font], size);
+  int id = settings.atlas->insert(glyphPixels.data(), layout.width,
+                                  layout.height);
+  if (id < 0) {
+    // Cached as invisible too, so a full atlas isn't retried every frame.
+    if (!atlasFullLogged) {
+      SDL_Log("The atlas is full, glyphs from now on are left out");
+      atlasFullLogged = true;
+    }
+    return glyph;
+  }
+  const AtlasRegion &region = settings.atlas->region(id);
+  glyph.texU = region.texU;
+  glyph.texV = region.texV;
+  glyph.texW = region.texW;
+  glyph.texH = region.texH;
+  glyph.textureLayer = region.textureLayer;
+  glyph.texture = settings.pageTexture(region.page, settings.userdata);
+  glyph.visible = true;
+  textStats.glyphsRasterized++;
+  textStats.glyphTexels += (Uint64)layout.width * layout.height;
+  return glyph;
+}
+
+void TextRenderer::layout(Uint16 font, Uint16 size, const char *text,
+                          Run &run) {
+  GlyphLayout glyphSize = glyphLayout(fonts[font], size);
+  run.quads.clear();
+  run.width = 0.0f;
+  float penX = 0.0f, penY = 0.0f;
+  for (const char *c = text; *c; c++) {
+    Uint8 byte = (Uint8)*c;
+    if (byte == '\n') {
+      run.width = SDL_max(run.width, penX);
+      penX = 0.0f;
+      penY += glyphSize.lineHeight;
+      continue;
+    }
+    if ((byte & 0xC0) == 0x80) {
+      // The rest of a UTF-8 sequence. Its first byte already stood in for
+      // the whole character.
+      continue;
+    }
+    const Glyph &g = glyph(font, size, byte < 0x80 ? byte : '?');
+    if (g.visible) {
+      run.quads.push_back({penX, penY, (float)glyphSize.width,
+                           (float)glyphSize.height, g.texU, g.texV, g.texW,
+                           g.texH, g.textureLayer, g.texture});
+    }
+    penX += glyphSize.advance;
+  }
+  run.width = SDL_max(run.width, penX);
+}
+
+float TextRenderer::draw(SpriteBatch &batch, const TextStyle &style,
+                         const char *text, float x, float y) {
+  if (style.font >= fonts.size() || style.size == 0) {
+    return 0.0f;
+  }
+
+  key.clear();
+  key.append((const char *)&style.font, sizeof(style.font));
+  key.append((const char *)&style.size, sizeof(style.size));
+  key.append(text);
+  auto found = runs.find(key);
+  if (found != runs.end()) {
+    textStats.runHits++;
+  } else {
+    textStats.runMisses++;
+    found = runs.emplace(key, Run{}).first;
+    layout(style.font, style.size, text, found->second);
+    textStats.cachedRuns = (Uint32)runs.size();
+    textStats.cachedGlyphs = (Uint32)glyphs.size();
+  }
+  Run &run = found->second;
+  run.lastFrame = frame;
+
+  for (const Quad &quad : run.quads) {
+    SpriteData sprite{};
+    sprite.x = x + quad.x;
+    sprite.y = y + quad.y;
+    sprite.z = style.z;
+    sprite.w = quad.w;
+    sprite.h = quad.h;
+    sprite.textureLayer = quad.textureLayer;
+    sprite.texU = quad.texU;
+    sprite.texV = quad.texV;
+    sprite.texW = quad.texW;
+    sprite.texH = quad.texH;
+    sprite.r = style.r;
+    sprite.g = style.g;
+    sprite.b = style.b;
+    sprite.a = style.a;
+    batch.draw(sprite,
+               makeBatchKey(style.layer, style.pipeline, quad.texture, style.z));
+  }
+  textStats.quads += (Uint32)run.quads.size();
+  return run.width;
+}
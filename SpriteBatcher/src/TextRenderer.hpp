@@ -0,0 +1,127 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include "BitmapFont.hpp"
+#include "SpriteBatch.hpp"
+#include "TextureAtlas.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Counters since the last beginFrame(), except the cache sizes.
+struct TextStats {
+  // draw() calls whose run was cached, and the ones that were laid out.
+  Uint32 runHits;
+  Uint32 runMisses;
+  // Glyphs rasterized into the atlas. 0 once every glyph in use was seen.
+  Uint32 glyphsRasterized;
+  // Sprites emitted, one per glyph with pixels.
+  Uint32 quads;
+  // Runs dropped by beginFrame() to stay within maxRuns.
+  Uint32 evictedRuns;
+  Uint32 cachedRuns;
+  Uint32 cachedGlyphs;
+  // Atlas texels the glyphs take, and how full the atlas's pages are, with
+  // whatever else is packed into them.
+  Uint64 glyphTexels;
+  float atlasOccupancy;
+};
+
+struct TextRendererSettings {
+  // Where glyphs are rasterized to. Sharing the sprites' atlas lets text
+  // share their draws when it's a texture array.
+  TextureAtlas *atlas = nullptr;
+  // The SpriteBatch texture id to draw the glyphs on an atlas page with.
+  // Called when a glyph is rasterized, so a new page can be registered.
+  Uint16 (*pageTexture)(Uint32 page, void *userdata) = nullptr;
+  void *userdata = nullptr;
+  // Runs kept between frames. Past this, beginFrame() drops the ones the
+  // last frame didn't draw.
+  Uint32 maxRuns = 4096;
+};
+
+struct TextStyle {
+  Uint16 font = 0;
+  // Glyph height in pixels, what the glyphs are rasterized at. Every size
+  // is a separate set of glyphs in the atlas.
+  Uint16 size = 14;
+  float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+  // Go into the batch key, like any other sprite's.
+  Uint8 layer = 0;
+  Uint8 pipeline = 0;
+  float z = 0.0f;
+};
+
+// Text as sprites, for debug overlays with thousands of labels. Each glyph
+// is rasterized once per (font, size), into a TextureAtlas, the first time
+// it's drawn. The layout of a whole string, a run of glyph quads relative to
+// its top left, is cached by (font, size, string). draw() looks the run up
+// and emits its quads into a SpriteBatch as ordinary sprites, so text is
+// culled, sorted and batched with everything else; no pass or pipeline of
+// its own. A label that doesn't change costs a hash lookup and a copy per
+// glyph.
+//
+// Usage:
+//   addFont() once
+//   per frame: beginFrame() -> draw() ... before the batch's upload()
+//              the atlas's upload() after the draws, so new glyphs make it
+class TextRenderer {
+public:
+  bool init(const TextRendererSettings &settings);
+  void release();
+
+  Uint16 addFont(const BitmapFont &font);
+
+  // Resets the counters and evicts runs.
+  void beginFrame();
+  // Emits text with its top left at x, y. '\n' starts a new line. Returns
+  // the width of its widest line.
+  float draw(SpriteBatch &batch, const TextStyle &style, const char *text,
+             float x, float y);
+
+  const TextStats &stats() const { return textStats; }
+  // Of this frame's draw() calls, the fraction that found its run cached.
+  float runHitRate() const {
+    Uint32 draws = textStats.runHits + textStats.runMisses;
+    return draws > 0 ? (float)textStats.runHits / draws : 0.0f;
+  }
+
+private:
+  // Where a glyph is in the atlas. Glyphs without pixels only advance.
+  struct Glyph {
+    float texU, texV, texW, texH;
+    float textureLayer;
+    Uint16 texture;
+    bool visible;
+  };
+  // A glyph placed in a run, relative to the run's top left.
+  struct Quad {
+    float x, y, w, h;
+    float texU, texV, texW, texH;
+    float textureLayer;
+    Uint16 texture;
+  };
+  struct Run {
+    std::vector<Quad> quads;
+    float width;
+    Uint64 lastFrame;
+  };
+
+  const Glyph &glyph(Uint16 font, Uint16 size, Uint32 codepoint);
+  void layout(Uint16 font, Uint16 size, const char *text, Run &run);
+
+  TextRendererSettings settings;
+  std::vector<BitmapFont> fonts;
+  // Keyed by font << 48 | size << 32 | codepoint.
+  std::unordered_map<Uint64, Glyph> glyphs;
+  // Keyed by the font and size bytes followed by the string.
+  std::unordered_map<std::string, Run> runs;
+  // Reused for every lookup, so a hit doesn't allocate.
+  std::string key;
+  std::vector<Uint8> glyphPixels;
+  Uint64 frame = 0;
+  bool atlasFullLogged = false;
+  TextStats textStats{};
+};
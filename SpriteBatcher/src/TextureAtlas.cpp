@@ -0,0 +1,208 @@
+#include "TextureAtlas.hpp"
+
+#include "SDL3/SDL_log.h"
+
+bool TextureAtlas::init(SDL_GPUDevice *device,
+                        const TextureAtlasSettings &settings) {
+  this->device = device;
+  this->settings = settings;
+
+  if (settings.textureArray) {
+    SDL_GPUTextureCreateInfo textureInfo{};
+    textureInfo.type = SDL_GPU_TEXTURETYPE_2D_ARRAY;
+    textureInfo.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    textureInfo.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    textureInfo.width = settings.pageSize;
+    textureInfo.height = settings.pageSize;
+    textureInfo.layer_count_or_depth = settings.maxPages;
+    textureInfo.num_levels = 1;
+    arrayTexture = SDL_CreateGPUTexture(device, &textureInfo);
+    if (!arrayTexture) {
+      SDL_Log("Failed to create atlas texture array: %s", SDL_GetError());
+      return false;
+    }
+  }
+
+  // Pages are created when they're needed, but there is always at least one
+  // to bind.
+  return addPage();
+}
+
+void TextureAtlas::release() {
+  if (!device) {
+    return;
+  }
+  if (arrayTexture) {
+    SDL_ReleaseGPUTexture(device, arrayTexture);
+    arrayTexture = nullptr;
+  } else {
+    for (Page &page : pages) {
+      SDL_ReleaseGPUTexture(device, page.texture);
+    }
+  }
+  pages.clear();
+  images.clear();
+  freeIds.clear();
+  liveImages = 0;
+  pendingUploads.clear();
+  stagingPixels.clear();
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  transferBuffer = nullptr;
+  transferBufferSize = 0;
+}
+
+bool TextureAtlas::addPage() {
+  if (pages.size() >= settings.maxPages) {
+    return false;
+  }
+
+  Page page;
+  page.packer.init(settings.pageSize, settings.pageSize);
+  if (arrayTexture) {
+    // Nothing to create, the layer already exists.
+    page.texture = arrayTexture;
+    pages.push_back(page);
+    return true;
+  }
+
+  SDL_GPUTextureCreateInfo textureInfo{};
+  textureInfo.type = SDL_GPU_TEXTURETYPE_2D;
+  textureInfo.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+  textureInfo.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+  textureInfo.width = settings.pageSize;
+  textureInfo.height = settings.pageSize;
+  textureInfo.layer_count_or_depth = 1;
+  textureInfo.num_levels = 1;
+  SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, &textureInfo);
+  if (!texture) {
+    SDL_Log("Failed to create atlas page: %s", SDL_GetError());
+    return false;
+  }
+
+  page.texture = texture;
+  pages.push_back(page);
+  return true;
+}
+
+int TextureAtlas::insert(const Uint8 *pixels, Uint32 width, Uint32 height) {
+  // Neither fits any page; an empty one would only add a page it never uses.
+  if (width == 0 || height == 0 || width > settings.pageSize ||
+      height > settings.pageSize) {
+    return -1;
+  }
+  // Only the padding is clamped, so an image as large as a page still fits.
+  Uint32 paddedWidth = SDL_min(width + settings.padding, settings.pageSize);
+  Uint32 paddedHeight = SDL_min(height + settings.padding, settings.pageSize);
+
+  // First fit over the pages, then a new page.
+  AtlasRect rect;
+  Uint32 page = 0;
+  for (; page < pages.size(); page++) {
+    if (pages[page].packer.insert(paddedWidth, paddedHeight, rect)) {
+      break;
+    }
+  }
+  if (page == pages.size()) {
+    if (!addPage() ||
+        !pages[page].packer.insert(paddedWidth, paddedHeight, rect)) {
+      return -1;
+    }
+  }
+
+  // The padding stays on the packer's rect, but the region only covers the
+  // image. The padded size is worked out the same way again on evict.
+  int id;
+  if (!freeIds.empty()) {
+    id = freeIds.back();
+    freeIds.pop_back();
+  } else {
+    id = (int)images.size();
+    images.push_back({});
+  }
+  Image &image = images[id];
+  image.live = true;
+  image.region.page = page;
+  image.region.rect = {rect.x, rect.y, width, height};
+  float inverseSize = 1.0f / (float)settings.pageSize;
+  image.region.texU = rect.x * inverseSize;
+  image.region.texV = rect.y * inverseSize;
+  image.region.texW = width * inverseSize;
+  image.region.texH = height * inverseSize;
+  image.region.textureLayer = arrayTexture ? (float)page : 0.0f;
+  liveImages++;
+
+  Uint32 offset = (Uint32)stagingPixels.size();
+  stagingPixels.insert(stagingPixels.end(), pixels,
+                       pixels + (size_t)width * height * 4);
+  pendingUploads.push_back({page, image.region.rect, offset});
+  return id;
+}
+
+void TextureAtlas::evict(int id) {
+  Image &image = images[id];
+  if (!image.live) {
+    return;
+  }
+  AtlasRect padded = image.region.rect;
+  padded.w = SDL_min(padded.w + settings.padding, settings.pageSize);
+  padded.h = SDL_min(padded.h + settings.padding, settings.pageSize);
+  pages[image.region.page].packer.free(padded);
+  image.live = false;
+  freeIds.push_back(id);
+  liveImages--;
+}
+
+bool TextureAtlas::upload(SDL_GPUCommandBuffer *commandBuffer) {
+  if (pendingUploads.empty()) {
+    return true;
+  }
+
+  Uint32 size = (Uint32)stagingPixels.size();
+  if (size > transferBufferSize) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_GPUTransferBufferCreateInfo transferInfo{};
+    transferInfo.size = size;
+    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+    if (!transferBuffer) {
+      SDL_Log("Failed to create atlas transfer buffer: %s", SDL_GetError());
+      transferBufferSize = 0;
+      return false;
+    }
+    transferBufferSize = size;
+  }
+
+  Uint8 *data = (Uint8 *)SDL_MapGPUTransferBuffer(device, transferBuffer, true);
+  if (!data) {
+    SDL_Log("Failed to map atlas transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+  SDL_memcpy(data, stagingPixels.data(), size);
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  for (const PendingUpload &pending : pendingUploads) {
+    SDL_GPUTextureTransferInfo source{};
+    source.transfer_buffer = transferBuffer;
+    source.offset = pending.offset;
+    source.pixels_per_row = pending.rect.w;
+    source.rows_per_layer = pending.rect.h;
+
+    SDL_GPUTextureRegion destination{};
+    destination.texture = pages[pending.page].texture;
+    destination.layer = arrayTexture ? pending.page : 0;
+    destination.x = pending.rect.x;
+    destination.y = pending.rect.y;
+    destination.w = pending.rect.w;
+    destination.h = pending.rect.h;
+    destination.d = 1;
+
+    // Not cycled: the rest of the page is still in use.
+    SDL_UploadToGPUTexture(copyPass, &source, &destination, false);
+  }
+  SDL_EndGPUCopyPass(copyPass);
+
+  pendingUploads.clear();
+  stagingPixels.clear();
+  return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "AtlasPacker.hpp"
+
+#include <vector>
+
+struct TextureAtlasSettings {
+  // Pages are square RGBA8 textures.
+  Uint32 pageSize = 2048;
+  Uint32 maxPages = 4;
+  // Empty texels left between images, so filtering doesn't pull in a
+  // neighbor. Dropped for images too large to fit with it.
+  Uint32 padding = 1;
+  // Pages are the layers of a single SDL_GPU_TEXTURETYPE_2D_ARRAY texture,
+  // for SpriteTexturing::Array. All maxPages layers are allocated up front.
+  // Otherwise every page is a 2D texture of its own.
+  bool textureArray = true;
+};
+
+// Where an image ended up. The tex fields go straight into SpriteData.
+struct AtlasRegion {
+  Uint32 page;
+  AtlasRect rect;
+  float texU, texV, texW, texH;
+  // The page's layer in the texture array, 0 without one.
+  float textureLayer;
+};
+
+// Packs RGBA8 images into a few large page textures with AtlasPacker, so a
+// scene needs one texture binding per page instead of one per image. With
+// textureArray the pages are layers of one texture, so it's one binding for
+// the whole atlas. An image as large as a page (a whole sprite sheet) simply
+// gets a layer to itself.
+//
+// insert() only reserves space and copies the pixels into a CPU staging
+// array. upload() then writes everything inserted since the last upload in a
+// single copy pass: one mapped transfer buffer and one SDL_UploadToGPUTexture
+// per image. Call it once per frame, before the render pass.
+//
+// Images are addressed by ids that stay valid until evicted. Evicting frees
+// the space for later inserts; sprites still using the image will show
+// whatever is uploaded there next.
+class TextureAtlas {
+public:
+  bool init(SDL_GPUDevice *device, const TextureAtlasSettings &settings);
+  void release();
+
+  // Returns the image id, or -1 when no page has room left (or the image is
+  // empty or larger than a page).
+  int insert(const Uint8 *pixels, Uint32 width, Uint32 height);
+  void evict(int id);
+  const AtlasRegion &region(int id) const { return images[id].region; }
+
+  bool upload(SDL_GPUCommandBuffer *commandBuffer);
+
+  // With textureArray, every page returns the same texture.
+  Uint32 pageCount() const { return (Uint32)pages.size(); }
+  SDL_GPUTexture *pageTexture(Uint32 page) const {
+    return pages[page].texture;
+  }
+  float pageOccupancy(Uint32 page) const {
+    return pages[page].packer.occupancy();
+  }
+  Uint32 imageCount() const { return liveImages; }
+
+private:
+  struct Page {
+    SDL_GPUTexture *texture;
+    AtlasPacker packer;
+  };
+  struct Image {
+    AtlasRegion region;
+    bool live;
+  };
+  // Pixels waiting for upload(), at offset in stagingPixels.
+  struct PendingUpload {
+    Uint32 page;
+    AtlasRect rect;
+    Uint32 offset;
+  };
+
+  bool addPage();
+
+  SDL_GPUDevice *device = nullptr;
+  TextureAtlasSettings settings;
+  SDL_GPUTexture *arrayTexture = nullptr;
+  std::vector<Page> pages;
+  std::vector<Image> images;
+  std::vector<int> freeIds;
+  Uint32 liveImages = 0;
+
+  std::vector<PendingUpload> pendingUploads;
+  std::vector<Uint8> stagingPixels;
+  SDL_GPUTransferBuffer *transferBuffer = nullptr;
+  Uint32 transferBufferSize = 0;
+};
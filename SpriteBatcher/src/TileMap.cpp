@@ -0,0 +1,312 @@
+#include "TileMap.hpp"
+
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_timer.h"
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Must match TileLayerBlock in shaders/tiles.vert (std140).
+struct TileLayerUniforms {
+  float originX, originY;
+  float tileSize;
+  float depth;
+  Uint32 chunksX;
+  // The slot of the layer's first chunk, so the shader can tell where a
+  // chunk is from its place in the buffer.
+  Uint32 firstChunk;
+  Uint32 padding[2];
+};
+
+// chunkFlags bits. A chunk that was never uploaded holds garbage on the GPU,
+// so render() skips it until it's there.
+static const Uint8 CHUNK_DIRTY = 1;
+static const Uint8 CHUNK_ON_GPU = 2;
+
+bool TileMap::init(SDL_GPUDevice *device, const TileMapSettings &settings) {
+  this->device = device;
+  this->settings = settings;
+  this->settings.layers = SDL_max(settings.layers, 1u);
+  this->settings.frameCapacity = SDL_max(settings.frameCapacity, 2u);
+  chunksX = (settings.width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+  chunksY = (settings.height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+  Uint32 slots = chunkCount();
+
+  Uint64 size = (Uint64)slots * TILE_CHUNK_BYTES;
+  if (slots == 0 || size > SDL_MAX_UINT32) {
+    SDL_Log("A %u x %u tile map with %u layers doesn't fit in a buffer",
+            settings.width, settings.height, this->settings.layers);
+    return false;
+  }
+  tiles.assign((size_t)slots * TILE_CHUNK_TILES, 0);
+  chunkTiles.assign(slots, 0);
+  chunkFlags.assign(slots, 0);
+  dirtySlots.clear();
+  frames.assign(1, TileFrame{});
+  framesDirty = true;
+  transferBuffers.assign(SDL_max(settings.framesInFlight, 1u), nullptr);
+  transferSizes.assign(transferBuffers.size(), 0);
+  mapStats = {};
+
+  SDL_GPUBufferCreateInfo bufferInfo{};
+  bufferInfo.size = (Uint32)size;
+  bufferInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  buffer = SDL_CreateGPUBuffer(device, &bufferInfo);
+  bufferInfo.size = this->settings.frameCapacity * (Uint32)sizeof(TileFrame);
+  frameBuffer = SDL_CreateGPUBuffer(device, &bufferInfo);
+  if (!buffer || !frameBuffer) {
+    SDL_Log("Failed to create tile map buffers: %s", SDL_GetError());
+    release();
+    return false;
+  }
+  return true;
+}
+
+void TileMap::release() {
+  if (!device) {
+    return;
+  }
+  SDL_ReleaseGPUBuffer(device, buffer);
+  SDL_ReleaseGPUBuffer(device, frameBuffer);
+  buffer = nullptr;
+  frameBuffer = nullptr;
+  for (SDL_GPUTransferBuffer *&transferBuffer : transferBuffers) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    transferBuffer = nullptr;
+  }
+  tiles.clear();
+  chunkTiles.clear();
+  chunkFlags.clear();
+  dirtySlots.clear();
+  frames.clear();
+}
+
+Uint16 TileMap::addFrame(float texU, float texV, float texW, float texH,
+                         float textureLayer) {
+  if (frames.size() >= settings.frameCapacity) {
+    return 0;
+  }
+  TileFrame frame{};
+  frame.texU = texU;
+  frame.texV = texV;
+  frame.texW = texW;
+  frame.texH = texH;
+  frame.textureLayer = textureLayer;
+  frames.push_back(frame);
+  framesDirty = true;
+  return (Uint16)(frames.size() - 1);
+}
+
+void TileMap::set(Uint32 layer, Uint32 x, Uint32 y, Uint16 frame) {
+  if (layer >= settings.layers || x >= settings.width ||
+      y >= settings.height) {
+    return;
+  }
+  Uint16 &tile = tiles[tileIndex(layer, x, y)];
+  if (tile == frame) {
+    return;
+  }
+  Uint32 slot = chunkSlot(layer, x, y);
+  if (tile == 0) {
+    chunkTiles[slot]++;
+  } else if (frame == 0) {
+    chunkTiles[slot]--;
+  }
+  tile = frame;
+  if (!(chunkFlags[slot] & CHUNK_DIRTY)) {
+    chunkFlags[slot] |= CHUNK_DIRTY;
+    dirtySlots.push_back(slot);
+  }
+}
+
+bool TileMap::tileAt(float worldX, float worldY, Uint32 &x,
+                     Uint32 &y) const {
+  float tileX = (worldX - settings.originX) / settings.tileSize;
+  float tileY = (worldY - settings.originY) / settings.tileSize;
+  if (!(tileX >= 0.0f && tileY >= 0.0f && tileX < (float)settings.width &&
+        tileY < (float)settings.height)) {
+    return false;
+  }
+  x = SDL_min((Uint32)tileX, settings.width - 1);
+  y = SDL_min((Uint32)tileY, settings.height - 1);
+  return true;
+}
+
+bool TileMap::upload(SDL_GPUCommandBuffer *commandBuffer, Uint32 frameSlot) {
+  mapStats.uploadedChunks = 0;
+  mapStats.bytesUploaded = 0;
+  mapStats.uploadNS = 0;
+  mapStats.pendingChunks = (Uint32)dirtySlots.size();
+  if (dirtySlots.empty() && !framesDirty) {
+    return true;
+  }
+  TRACE_ZONE("tile upload");
+  Uint64 start = SDL_GetTicksNS();
+
+  // The oldest edits first, in slot order, so neighbors in a row end up
+  // next to each other and go out as one copy.
+  Uint32 count = (Uint32)dirtySlots.size();
+  if (settings.maxChunksPerUpload > 0) {
+    count = SDL_min(count, settings.maxChunksPerUpload);
+  }
+  std::sort(dirtySlots.begin(), dirtySlots.begin() + count);
+  Uint32 chunkBytes = count * TILE_CHUNK_BYTES;
+  Uint32 frameBytes =
+      framesDirty ? (Uint32)(frames.size() * sizeof(TileFrame)) : 0;
+  Uint32 size = chunkBytes + frameBytes;
+
+  // Grown, never shrunk, like RetainedSprites'. After the map is loaded an
+  // edit only needs a chunk's worth.
+  frameSlot %= (Uint32)transferBuffers.size();
+  SDL_GPUTransferBuffer *&transferBuffer = transferBuffers[frameSlot];
+  if (size > transferSizes[frameSlot]) {
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_GPUTransferBufferCreateInfo transferInfo{};
+    transferInfo.size = SDL_max(size, transferSizes[frameSlot] * 2);
+    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+    transferSizes[frameSlot] = transferBuffer ? transferInfo.size : 0;
+    if (!transferBuffer) {
+      SDL_Log("Failed to create tile transfer buffer: %s", SDL_GetError());
+      return false;
+    }
+  }
+
+  // Same rules as SpriteBatch::upload: the slot's buffer is free, or
+  // without a ring SDL cycles it.
+  Uint8 *data = (Uint8 *)SDL_MapGPUTransferBuffer(
+      device, transferBuffer, settings.framesInFlight == 0);
+  if (!data) {
+    SDL_Log("Failed to map tile transfer buffer: %s", SDL_GetError());
+    return false;
+  }
+  for (Uint32 i = 0; i < count; i++) {
+    SDL_memcpy(data + i * TILE_CHUNK_BYTES,
+               &tiles[(size_t)dirtySlots[i] * TILE_CHUNK_TILES],
+               TILE_CHUNK_BYTES);
+  }
+  if (framesDirty) {
+    SDL_memcpy(data + chunkBytes, frames.data(), frameBytes);
+  }
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+  // One copy per run of consecutive slots. Never cycled: every other chunk
+  // has to stay.
+  for (Uint32 first = 0; first < count;) {
+    Uint32 end = first + 1;
+    while (end < count && dirtySlots[end] == dirtySlots[end - 1] + 1) {
+      end++;
+    }
+    SDL_GPUTransferBufferLocation location{};
+    location.transfer_buffer = transferBuffer;
+    location.offset = first * TILE_CHUNK_BYTES;
+    SDL_GPUBufferRegion region{};
+    region.buffer = buffer;
+    region.offset = dirtySlots[first] * TILE_CHUNK_BYTES;
+    region.size = (end - first) * TILE_CHUNK_BYTES;
+    SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+    first = end;
+  }
+  if (framesDirty) {
+    SDL_GPUTransferBufferLocation location{};
+    location.transfer_buffer = transferBuffer;
+    location.offset = chunkBytes;
+    SDL_GPUBufferRegion region{};
+    region.buffer = frameBuffer;
+    region.size = frameBytes;
+    SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+    framesDirty = false;
+  }
+  SDL_EndGPUCopyPass(copyPass);
+
+  for (Uint32 i = 0; i < count; i++) {
+    chunkFlags[dirtySlots[i]] = CHUNK_ON_GPU;
+  }
+  dirtySlots.erase(dirtySlots.begin(), dirtySlots.begin() + count);
+
+  mapStats.uploadedChunks = count;
+  mapStats.pendingChunks = (Uint32)dirtySlots.size();
+  mapStats.bytesUploaded = size;
+  mapStats.uploadNS = SDL_GetTicksNS() - start;
+  return true;
+}
+
+// The range of chunk columns (or rows) that [minimum, maximum] touches,
+// false when it misses all of them.
+static bool chunkRange(float minimum, float maximum, float origin,
+                       float chunkSize, Uint32 chunks, Uint32 &first,
+                       Uint32 &last) {
+  float low = std::floor((minimum - origin) / chunkSize);
+  float high = std::floor((maximum - origin) / chunkSize);
+  if (!(high >= 0.0f && low < (float)chunks)) {
+    return false;
+  }
+  first = low > 0.0f ? (Uint32)low : 0;
+  last = high < (float)chunks ? (Uint32)high : chunks - 1;
+  return true;
+}
+
+void TileMap::render(SDL_GPUCommandBuffer *commandBuffer,
+                     SDL_GPURenderPass *renderPass,
+                     SDL_GPUGraphicsPipeline *pipeline,
+                     const SDL_GPUTextureSamplerBinding &texture,
+                     const SpatialRect &view) {
+  mapStats.visibleChunks = 0;
+  mapStats.drawCalls = 0;
+  float chunkSize = settings.tileSize * TILE_CHUNK_SIZE;
+  Uint32 firstX, lastX, firstY, lastY;
+  if (!buffer ||
+      !chunkRange(view.minX, view.maxX, settings.originX, chunkSize, chunksX,
+                  firstX, lastX) ||
+      !chunkRange(view.minY, view.maxY, settings.originY, chunkSize, chunksY,
+                  firstY, lastY)) {
+    return;
+  }
+
+  SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+  SDL_GPUBuffer *buffers[2] = {buffer, frameBuffer};
+  SDL_BindGPUVertexStorageBuffers(renderPass, 0, buffers, 2);
+  SDL_BindGPUFragmentSamplers(renderPass, 0, &texture, 1);
+
+  TileLayerUniforms uniforms{};
+  uniforms.originX = settings.originX;
+  uniforms.originY = settings.originY;
+  uniforms.tileSize = settings.tileSize;
+  uniforms.depth = settings.depth;
+  uniforms.chunksX = chunksX;
+  for (Uint32 layer = 0; layer < settings.layers; layer++) {
+    uniforms.firstChunk = layer * chunksY * chunksX;
+    SDL_PushGPUVertexUniformData(commandBuffer, 1, &uniforms,
+                                 sizeof(uniforms));
+    for (Uint32 y = firstY; y <= lastY; y++) {
+      Uint32 rowSlot = uniforms.firstChunk + y * chunksX;
+      // A chunk row is consecutive in the buffer, so a run of drawable
+      // chunks is one draw. The loop goes one past the end to close the
+      // last run.
+      Uint32 runStart = ~0u;
+      for (Uint32 x = firstX; x <= lastX + 1; x++) {
+        Uint32 slot = rowSlot + x;
+        bool drawable = x <= lastX && chunkTiles[slot] > 0 &&
+                        (chunkFlags[slot] & CHUNK_ON_GPU);
+        if (drawable) {
+          mapStats.visibleChunks++;
+          if (runStart == ~0u) {
+            runStart = x;
+          }
+        } else if (runStart != ~0u) {
+          // Six vertices per tile, and gl_VertexIndex starts at the run's
+          // first tile, so the shader can tell which tile it is.
+          SDL_DrawGPUPrimitives(renderPass,
+                                (x - runStart) * TILE_CHUNK_TILES * 6, 1,
+                                (rowSlot + runStart) * TILE_CHUNK_TILES * 6,
+                                0);
+          mapStats.drawCalls++;
+          runStart = ~0u;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "SDL3/SDL_stdinc.h"
+
+#include "SpatialGrid.hpp"
+#include "SpritePipeline.hpp"
+
+#include <vector>
+
+// Tiles per chunk side. Must match CHUNK_SIZE in shaders/tiles.vert.
+inline constexpr Uint32 TILE_CHUNK_SIZE = 32;
+inline constexpr Uint32 TILE_CHUNK_TILES = TILE_CHUNK_SIZE * TILE_CHUNK_SIZE;
+// A tile is a 16 bit frame id, 0 for no tile.
+inline constexpr Uint32 TILE_CHUNK_BYTES = TILE_CHUNK_TILES * sizeof(Uint16);
+
+// GPU mirror of TileFrame in shaders/tiles.vert (std430): which part of
+// which texture layer a tile id shows.
+struct TileFrame {
+  float texU, texV, texW, texH;
+  float textureLayer;
+  float padding[3];
+};
+static_assert(sizeof(TileFrame) == 32, "TileFrame must be 32 bytes");
+
+// Counters for the last upload() and render().
+struct TileMapStats {
+  // Chunks with at least one tile under the view, over all layers.
+  Uint32 visibleChunks;
+  // One per run of neighboring visible chunks in a chunk row.
+  Uint32 drawCalls;
+  Uint32 uploadedChunks;
+  // Chunks still waiting for an upload, see maxChunksPerUpload.
+  Uint32 pendingChunks;
+  Uint64 bytesUploaded;
+  Uint64 uploadNS;
+};
+
+struct TileMapSettings {
+  // In tiles. Rounded up to whole chunks on the GPU.
+  Uint32 width = 256;
+  Uint32 height = 256;
+  // Drawn bottom to top, each over the whole map.
+  Uint32 layers = 1;
+  // World position of the map's top left corner, and of a tile's side.
+  float originX = 0.0f, originY = 0.0f;
+  float tileSize = 16.0f;
+  // z of every tile. 1 is the back, behind every sprite.
+  float depth = 1.0f;
+  // Frames addFrame() has room for, the empty tile 0 included.
+  Uint32 frameCapacity = 256;
+  // Same as SpriteBatchSettings::framesInFlight.
+  Uint32 framesInFlight = 0;
+  // Chunks copied by one upload(), at most. The rest stays dirty for the
+  // next one, so loading a big map is spread over a few frames instead of
+  // one transfer buffer the size of the map. 0 uploads everything at once.
+  Uint32 maxChunksPerUpload = 2048;
+};
+
+// Tile layers too big to submit as sprites. A 4096 x 4096 map is 16M tiles;
+// SpriteBatch would cull, sort, pack and upload a million of them per frame
+// at any zoom that shows them. Here the map is split into chunks of
+// TILE_CHUNK_SIZE x TILE_CHUNK_SIZE tiles, and every chunk has its own
+// region of one storage buffer, uploaded once. Per frame render() walks the
+// chunks under the view and draws them straight from that buffer with
+// tiles.vert, one draw per run of neighboring chunks in a row. Nothing is
+// uploaded while the map doesn't change, and set() only re-uploads the
+// chunk it's in.
+//
+// A tile is 2 bytes, a frame id into a table of texture rects added with
+// addFrame(). Empty chunks aren't drawn at all; empty tiles become
+// triangles without area. Every frame has to be on the texture render() is
+// given, so they should share a texture array (see TextureAtlas).
+//
+// Usage:
+//   addFrame() / set() whenever tiles change
+//   per frame: upload(commandBuffer, frameSlot)   before the render pass
+//              render(commandBuffer, renderPass, ...)
+//                                                 ViewProjectionMatrix pushed
+class TileMap {
+public:
+  bool init(SDL_GPUDevice *device, const TileMapSettings &settings);
+  void release();
+
+  // Returns the frame's id, or 0 when the table is full.
+  Uint16 addFrame(float texU, float texV, float texW, float texH,
+                  float textureLayer);
+  void set(Uint32 layer, Uint32 x, Uint32 y, Uint16 frame);
+  Uint16 get(Uint32 layer, Uint32 x, Uint32 y) const {
+    return tiles[tileIndex(layer, x, y)];
+  }
+  // The tile under a world point, false when it's off the map.
+  bool tileAt(float worldX, float worldY, Uint32 &x, Uint32 &y) const;
+
+  // frameSlot picks the transfer buffer like SpriteBatch::begin's.
+  bool upload(SDL_GPUCommandBuffer *commandBuffer, Uint32 frameSlot = 0);
+  // Draws the chunks that overlap view, a world-space box like
+  // Camera2D::viewBounds(). Pushes the layer uniforms at vertex slot 1.
+  void render(SDL_GPUCommandBuffer *commandBuffer,
+              SDL_GPURenderPass *renderPass, SDL_GPUGraphicsPipeline *pipeline,
+              const SDL_GPUTextureSamplerBinding &texture,
+              const SpatialRect &view);
+
+  const TileMapStats &stats() const { return mapStats; }
+  Uint32 width() const { return settings.width; }
+  Uint32 height() const { return settings.height; }
+  Uint32 chunkCount() const { return chunksX * chunksY * settings.layers; }
+  Uint32 dirtyChunks() const { return (Uint32)dirtySlots.size(); }
+  SDL_GPUBuffer *tileBuffer() const { return buffer; }
+
+private:
+  // Tiles are stored chunk by chunk, like on the GPU, so a chunk's upload
+  // is one memcpy. A slot is a chunk's index over all layers.
+  Uint32 chunkSlot(Uint32 layer, Uint32 x, Uint32 y) const {
+    return (layer * chunksY + y / TILE_CHUNK_SIZE) * chunksX +
+           x / TILE_CHUNK_SIZE;
+  }
+  size_t tileIndex(Uint32 layer, Uint32 x, Uint32 y) const {
+    return (size_t)chunkSlot(layer, x, y) * TILE_CHUNK_TILES +
+           (y % TILE_CHUNK_SIZE) * TILE_CHUNK_SIZE + x % TILE_CHUNK_SIZE;
+  }
+
+  SDL_GPUDevice *device = nullptr;
+  TileMapSettings settings;
+  Uint32 chunksX = 0;
+  Uint32 chunksY = 0;
+  SDL_GPUBuffer *buffer = nullptr;
+  SDL_GPUBuffer *frameBuffer = nullptr;
+  // One per frame in flight, grown to the largest upload so far.
+  std::vector<SDL_GPUTransferBuffer *> transferBuffers;
+  std::vector<Uint32> transferSizes;
+
+  std::vector<Uint16> tiles;
+  // Non-empty tiles per chunk, so render() can skip empty chunks.
+  std::vector<Uint16> chunkTiles;
+  // Dirty and uploaded bits per chunk, see TileMap.cpp.
+  std::vector<Uint8> chunkFlags;
+  // The dirty chunks, in the order they were first changed.
+  std::vector<Uint32> dirtySlots;
+  std::vector<TileFrame> frames;
+  bool framesDirty = false;
+  TileMapStats mapStats{};
+};
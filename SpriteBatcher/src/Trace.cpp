@@ -0,0 +1,131 @@
+#include "Trace.hpp"
+
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_log.h"
+
+struct TraceEvent {
+  const char *name;
+  Uint64 startNS;
+  Uint64 endNS;
+};
+
+// Written by one thread only. head counts every event ever recorded; the
+// event goes into events[head % TRACE_RING_SIZE] before head is published.
+struct TraceRing {
+  char name[32];
+  std::atomic<Uint64> head{0};
+  TraceEvent events[TRACE_RING_SIZE];
+};
+
+std::atomic<bool> traceEnabledFlag{false};
+
+// Rings are registered once per thread and live until the process exits, so
+// a thread that is gone still shows up in the export.
+static std::atomic<TraceRing *> rings[MAX_TRACE_THREADS];
+static std::atomic<Uint32> ringCount{0};
+static thread_local TraceRing *threadRing;
+static thread_local char threadName[32] = "thread";
+static TraceRing *gpuRings[MAX_TRACE_GPU_TRACKS];
+
+static TraceRing *registerRing(const char *name) {
+  Uint32 index = ringCount.fetch_add(1);
+  if (index >= MAX_TRACE_THREADS) {
+    return nullptr;
+  }
+  TraceRing *ring = new TraceRing();
+  SDL_strlcpy(ring->name, name, sizeof(ring->name));
+  rings[index].store(ring, std::memory_order_release);
+  return ring;
+}
+
+static TraceRing *currentRing() {
+  if (!threadRing) {
+    threadRing = registerRing(threadName);
+  }
+  return threadRing;
+}
+
+static void push(TraceRing *ring, const char *name, Uint64 startNS,
+                 Uint64 endNS) {
+  if (!ring) {
+    return;
+  }
+  Uint64 head = ring->head.load(std::memory_order_relaxed);
+  ring->events[head % TRACE_RING_SIZE] = {name, startNS, endNS};
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void traceSetEnabled(bool enabled) {
+  traceEnabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+// Threads that never record, like worker pools built with tracing off,
+// don't cost a ring.
+void traceSetThreadName(const char *name) {
+  SDL_strlcpy(threadName, name, sizeof(threadName));
+  if (threadRing) {
+    SDL_strlcpy(threadRing->name, name, sizeof(threadRing->name));
+  }
+}
+
+void traceRecord(const char *name, Uint64 startNS, Uint64 endNS) {
+  push(currentRing(), name, startNS, endNS);
+}
+
+void traceRecordGPU(const char *name, Uint32 track, Uint64 startNS,
+                    Uint64 endNS) {
+  if (!traceEnabled() || track >= MAX_TRACE_GPU_TRACKS) {
+    return;
+  }
+  if (!gpuRings[track]) {
+    char trackName[32];
+    SDL_snprintf(trackName, sizeof(trackName), "GPU slot %u", track);
+    gpuRings[track] = registerRing(trackName);
+  }
+  push(gpuRings[track], name, startNS, endNS);
+}
+
+// Complete ("X") events with microsecond timestamps, one track per ring.
+bool traceWriteJSON(const char *path) {
+  SDL_IOStream *file = SDL_IOFromFile(path, "w");
+  if (!file) {
+    SDL_Log("Failed to open %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  SDL_IOprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  Uint64 written = 0;
+  Uint32 count = SDL_min(ringCount.load(), MAX_TRACE_THREADS);
+  for (Uint32 i = 0; i < count; i++) {
+    TraceRing *ring = rings[i].load(std::memory_order_acquire);
+    if (!ring) {
+      continue;
+    }
+    SDL_IOprintf(file,
+                 "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, "
+                 "\"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                 first ? "" : ",\n", i + 1, ring->name);
+    first = false;
+
+    Uint64 head = ring->head.load(std::memory_order_acquire);
+    Uint64 start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    for (Uint64 e = start; e < head; e++) {
+      const TraceEvent &event = ring->events[e % TRACE_RING_SIZE];
+      SDL_IOprintf(file,
+                   ",\n{\"ph\": \"X\", \"name\": \"%s\", \"pid\": 1, "
+                   "\"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                   event.name, i + 1, event.startNS / 1e3,
+                   (event.endNS - event.startNS) / 1e3);
+      written++;
+    }
+  }
+  SDL_IOprintf(file, "\n]}\n");
+
+  if (!SDL_CloseIO(file)) {
+    SDL_Log("Failed to write %s: %s", path, SDL_GetError());
+    return false;
+  }
+  SDL_Log("Wrote %" SDL_PRIu64 " trace events to %s", written, path);
+  return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
+
+#include <atomic>
+
+// A minimal CPU/GPU profiler that writes the Chrome trace event format, which
+// chrome://tracing and https://ui.perfetto.dev load directly.
+//
+// Every thread records into its own fixed ring of events, so recording takes
+// no lock and never allocates after the thread's first event. When a ring is
+// full the oldest events are overwritten; the export holds the last
+// TRACE_RING_SIZE events per thread. GPU work shows up on GPU tracks of its
+// own, one per frame slot so frames in flight don't overlap on one track.
+// A span there runs from submit until the CPU saw the fence signalled (see
+// FrameLoop), which is later than the GPU actually finished.
+//
+// Usage:
+//   traceSetEnabled(true);
+//   { TRACE_ZONE("sprite build"); ... }
+//   traceWriteJSON("trace.json");
+//
+// With tracing disabled a zone costs one relaxed atomic load.
+
+static const Uint32 TRACE_RING_SIZE = 16384;
+static const Uint32 MAX_TRACE_THREADS = 64;
+static const Uint32 MAX_TRACE_GPU_TRACKS = 4;
+
+extern std::atomic<bool> traceEnabledFlag;
+
+inline bool traceEnabled() {
+  return traceEnabledFlag.load(std::memory_order_relaxed);
+}
+void traceSetEnabled(bool enabled);
+
+// Shown as the thread's name in the viewer. The name is copied. The thread's
+// ring is only allocated once it records, with tracing enabled.
+void traceSetThreadName(const char *name);
+
+// name has to outlive the export; string literals are what zones use.
+void traceRecord(const char *name, Uint64 startNS, Uint64 endNS);
+// Only called from the thread that submits. track is below
+// MAX_TRACE_GPU_TRACKS; events on one track must not overlap.
+void traceRecordGPU(const char *name, Uint32 track, Uint64 startNS,
+                    Uint64 endNS);
+
+// Writes every ring to path. Call it from the main thread between frames:
+// threads still recording into their ring while it's being read may leave a
+// few garbled events behind.
+bool traceWriteJSON(const char *path);
+
+// Records the time from construction to destruction.
+class TraceZone {
+public:
+  explicit TraceZone(const char *name)
+      : name(traceEnabled() ? name : nullptr),
+        startNS(this->name ? SDL_GetTicksNS() : 0) {}
+  ~TraceZone() {
+    if (name) {
+      traceRecord(name, startNS, SDL_GetTicksNS());
+    }
+  }
+
+  TraceZone(const TraceZone &) = delete;
+  TraceZone &operator=(const TraceZone &) = delete;
+
+private:
+  const char *name;
+  Uint64 startNS;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
@@ -0,0 +1,93 @@
+#include "WorkerPool.hpp"
+
+#include "Trace.hpp"
+
+void WorkerPool::init(Uint32 workerCount) {
+  quit = false;
+  // Handed to the workers instead of letting them read it on startup.
+  // Otherwise a job dispatched before a thread gets scheduled would be missed.
+  Uint32 startGeneration = generation.load();
+  workers.reserve(workerCount);
+  for (Uint32 i = 0; i < workerCount; i++) {
+    // Slice 0 belongs to the calling thread, the workers take 1..N.
+    workers.emplace_back(&WorkerPool::workerMain, this, i + 1,
+                         startGeneration);
+  }
+}
+
+void WorkerPool::shutdown() {
+  quit = true;
+  generation.fetch_add(1);
+  generation.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void WorkerPool::workerMain(Uint32 index, Uint32 seen) {
+  char name[32];
+  SDL_snprintf(name, sizeof(name), "worker %u", index);
+  traceSetThreadName(name);
+
+  while (true) {
+    generation.wait(seen);
+    seen = generation.load();
+    if (quit) {
+      return;
+    }
+
+    runSlice(index);
+
+    if (pending.fetch_sub(1) == 1) {
+      pending.notify_one();
+    }
+  }
+}
+
+void WorkerPool::runSlice(Uint32 index) {
+  Uint32 first = index * jobSliceSize;
+  if (first >= jobTotal) {
+    return;
+  }
+  Uint32 count = jobTotal - first;
+  if (count > jobSliceSize) {
+    count = jobSliceSize;
+  }
+  jobFunction(jobContext, first, count);
+}
+
+void WorkerPool::parallelFor(Uint32 total, Uint32 granularity,
+                             SliceFunction function, void *context) {
+  if (total == 0) {
+    return;
+  }
+
+  Uint32 threads = threadCount();
+  Uint32 sliceSize = (total + threads - 1) / threads;
+  sliceSize = (sliceSize + granularity - 1) / granularity * granularity;
+
+  // Too little work to be worth waking anyone up.
+  if (workers.empty() || sliceSize >= total) {
+    function(context, 0, total);
+    return;
+  }
+
+  jobFunction = function;
+  jobContext = context;
+  jobTotal = total;
+  jobSliceSize = sliceSize;
+  pending = (Uint32)workers.size();
+
+  // The release in fetch_add publishes the job fields above to the workers.
+  generation.fetch_add(1);
+  generation.notify_all();
+
+  runSlice(0);
+
+  Uint32 remaining = pending.load();
+  while (remaining != 0) {
+    pending.wait(remaining);
+    remaining = pending.load();
+  }
+}
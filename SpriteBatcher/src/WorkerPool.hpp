@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SDL3/SDL_stdinc.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads for splitting one big loop (like packing sprites)
+// across cores. The threads are created once and sleep on an atomic between
+// jobs, so dispatching a job doesn't create threads or allocate.
+class WorkerPool {
+public:
+  // Called once per slice with a half-open range [first, first + count).
+  using SliceFunction = void (*)(void *context, Uint32 first, Uint32 count);
+
+  // workerCount extra threads are started. The calling thread always takes a
+  // slice too, so the job runs on workerCount + 1 threads.
+  void init(Uint32 workerCount);
+  void shutdown();
+
+  Uint32 threadCount() const { return (Uint32)workers.size() + 1; }
+
+  // Splits [0, total) into one contiguous slice per thread and blocks until
+  // every slice is done. Slices are multiples of `granularity`, so SIMD
+  // kernels keep working on full blocks, and a job smaller than one
+  // granularity runs inline without waking any thread.
+  void parallelFor(Uint32 total, Uint32 granularity, SliceFunction function,
+                   void *context);
+
+  template <typename Fn>
+  void parallelFor(Uint32 total, Uint32 granularity, Fn &fn) {
+    parallelFor(
+        total, granularity,
+        [](void *context, Uint32 first, Uint32 count) {
+          (*(Fn *)context)(first, count);
+        },
+        &fn);
+  }
+
+private:
+  void workerMain(Uint32 index, Uint32 seen);
+  void runSlice(Uint32 index);
+
+  std::vector<std::thread> workers;
+
+  // Bumped for every job. Workers wait for it to change.
+  std::atomic<Uint32> generation{0};
+  // Slices that haven't finished yet. The caller waits for it to hit zero.
+  std::atomic<Uint32> pending{0};
+  std::atomic<bool> quit{false};
+
+  SliceFunction jobFunction = nullptr;
+  void *jobContext = nullptr;
+  Uint32 jobTotal = 0;
+  Uint32 jobSliceSize = 0;
+};
@@ -1,37 +1,1223 @@
+#include "SDL3/SDL_cpuinfo.h"
 #include "SDL3/SDL_events.h"
 #include "SDL3/SDL_gpu.h"
 #include "SDL3/SDL_init.h"
+#include "SDL3/SDL_log.h"
+#include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
 #include "SDL3/SDL_video.h"
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
+#include "AllocationCounter.hpp"
+#include "Camera2D.hpp"
+#include "FlightRecorder.hpp"
+#include "FrameArena.hpp"
+#include "FrameLoop.hpp"
+#include "GeometryProbe.hpp"
+#include "GPUCullBatch.hpp"
+#include "LatencyStats.hpp"
+#include "ParticleSystem.hpp"
+#include "RetainedSprites.hpp"
+#include "SpatialGrid.hpp"
+#include "SpriteBatch.hpp"
+#include "SpritePipeline.hpp"
+#include "SpritePool.hpp"
+#include "SpriteShapes.hpp"
+#include "TextRenderer.hpp"
+#include "TextureAtlas.hpp"
+#include "TileMap.hpp"
+#include "Trace.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// A scene of sprites bouncing around the window. They are re-submitted to the
+// batch every frame, which is exactly what the batcher is built for.
+struct Sprite {
+  SpriteData data;
+  float vx, vy;
+  float spin;
+  Uint8 layer;
+  Uint32 image;
+  // Drawn by gpuCullBatch instead of the sprite batch, see --gpu-cull.
+  bool onGPU;
+};
+
+// A generated stand-in for a game's sprite image. With the atlas, texture is
+// the id of the atlas page it was packed into; without it, the id of its own
+// texture.
+struct SpriteImage {
+  int atlasId;
+  Uint16 texture;
+  Uint32 width, height;
+  float texU, texV, texW, texH;
+  float textureLayer;
+  // No texel is even partly transparent, so with --depth the sprites
+  // showing it go into the opaque pass.
+  bool opaque;
+  // Its entry in shapeTable, 0 (the full quad) without --trim.
+  Uint32 shape;
+};
+
 SDL_Window *window;
 SDL_GPUDevice *device;
+SDL_GPUGraphicsPipeline *spritePipeline;
+SDL_GPUSampler *sampler;
+Uint8 spritePipelineId;
+
+// Images are packed into the atlas pages, unless --no-atlas gives each one
+// its own texture to compare against.
+bool useAtlas = true;
+// --single-texture falls back to plain 2D textures, where each atlas page
+// needs its own binding.
+SpriteTexturing texturing = SpriteTexturing::Array;
+TextureAtlas atlas;
+std::vector<Uint16> atlasPageIds;
+std::vector<SDL_GPUTexture *> imageTextures;
+std::vector<SpriteImage> images;
+
+// Draws the SpriteData the GPU writes itself, for the particles and the GPU
+// culled sprites, and the retained sprites. That's always std140 and drawn
+// with vertex pulling, so with --compact or the instanced geometry it's a
+// pipeline of its own.
+SDL_GPUGraphicsPipeline *gpuSpritePipeline;
+// --particles N: a fountain simulated and drawn entirely on the GPU, on top
+// of the scene.
+ParticleSystem particles;
+SDL_GPUTextureSamplerBinding particleTexture;
+// --gpu-cull: the sprites that never move are uploaded once, in draw order,
+// and culled by compute passes every frame. They are drawn below everything
+// the sprite batch draws, whatever their layer. staticDirty re-uploads them
+// after a pick or an image replacement changed one.
+bool gpuCull = false;
+GPUCullBatch gpuCullBatch;
+std::vector<Uint32> staticOrder;
+// Only for picking them. They're not in spatialGrid, so the per-frame query
+// never walks over them.
+SpatialGrid staticGrid;
+std::vector<SpriteData> staticSprites;
+bool staticDirty;
+// --retained: every sprite lives in retainedSprites, in draw order, and only
+// the ones that changed are uploaded. Nothing goes through the sprite batch
+// and nothing is culled. retainedSlots maps a scene index to its sprite.
+// Meant for mostly static scenes, see --moving.
+bool retained = false;
+RetainedSprites retainedSprites;
+std::vector<Uint32> retainedSlots;
+// --bullets N: N bullets a second fly out of the window's center in a
+// spiral, each heading where its rotation points, and are destroyed once
+// they leave the window. They come and go far too often for the scene
+// vector, so they live in a SpritePool, and are drawn through the sprite
+// batch above both scene layers.
+SpritePool bullets;
+float bulletRate;
+// Fractional bullets carried over to the next frame, and where the spiral
+// points next.
+float bulletsOwed;
+float bulletAngle;
+static const float BULLET_SPEED = 240.0f;
+static const float BULLET_SIZE = 6.0f;
+static const Uint8 BULLET_LAYER = 2;
+// --labels, above everything else.
+static const Uint8 TEXT_LAYER = BULLET_LAYER + 1;
+// The two scene layers, the bullets' and the labels', for layeredDepth.
+static const Uint8 LAYER_COUNT = TEXT_LAYER + 1;
+// --depth: sprites with an opaque image go into opaqueBatch, which draws
+// them first, roughly front to back, writing depth. Everything else stays in
+// spriteBatch, sorted back to front and depth tested against them. Layers
+// no longer split the opaque pass, so every sprite's layer is folded into
+// its z. Half the generated images are opaque tiles for it.
+bool depthPasses = false;
+SpriteBatch opaqueBatch;
+SDL_GPUGraphicsPipeline *opaquePipeline;
+Uint8 opaquePipelineId;
+// Recreated when the swapchain changes size.
+SDL_GPUTexture *depthTexture;
+Uint32 depthWidth, depthHeight;
+// --trim: every image gets a convex shape around its visible texels when
+// it's loaded, and sprites that cover enough pixels on screen for it to pay
+// off are drawn as that shape through trimmedPipeline instead of as a quad.
+// So are the particles, with gpuTrimmedPipeline. The GPU culled and
+// retained sprites stay quads.
+bool trimShapes = false;
+SpriteShapeTable shapeTable;
+SDL_GPUGraphicsPipeline *trimmedPipeline;
+Uint8 trimmedPipelineId;
+SDL_GPUGraphicsPipeline *gpuTrimmedPipeline;
+// --tilemap N: an N x N map of 16 pixel tiles under everything else, a
+// ground layer and a sparse detail layer, drawn straight from per-chunk
+// regions of a storage buffer. Clicking where there's no sprite paints the
+// ground tile under the cursor, and only its chunk is uploaded again.
+Uint32 tileMapSize = 0;
+TileMap tileMap;
+SDL_GPUGraphicsPipeline *tilePipeline;
+Uint16 groundFrames[8];
+static const Uint32 DETAIL_FRAME_COUNT = 4;
+// --labels N: the first N visible sprites get a label with their id and
+// image, drawn by textRenderer into spriteBatch with everything else. The
+// glyphs go into the atlas, so labels share the sprites' texture binding.
+// With --retained the sprites skip the batch, but their labels don't.
+Uint32 labelCount = 0;
+TextRenderer textRenderer;
+TextStyle labelStyle;
+char labelText[32];
+
+// Submits with fences and hands out the slot of the per-frame transfer
+// buffers.
+FrameLoop frameLoop;
+// The last few seconds of frame stats, written to hitches.txt when a frame
+// goes over --hitch-budget.
+FlightRecorder flightRecorder;
+// Everything that only lives for one frame: the batch's culled indices and
+// sort scratch. Reset at the top of SDL_AppIterate.
+FrameArena frameArena;
+WorkerPool workerPool;
+SpriteBatch spriteBatch;
+std::vector<Sprite> scene;
+// Sprite indices by area. Only sprites under the view are submitted, and
+// mouse clicks pick through it.
+SpatialGrid spatialGrid;
+std::vector<Uint32> visibleSprites;
+std::vector<Uint32> pickedSprites;
+
+// Zoom > 1 zooms in, < 1 zooms out. Either way some sprites get culled:
+// off-screen ones or sub-pixel ones. The mouse wheel zooms around the cursor,
+// dragging with the right mouse button pans, Q and E rotate.
+Camera2D camera;
+static const float ROTATION_STEP = SDL_PI_F / 24.0f;
+bool panning;
+float panStartMouseX, panStartMouseY, panStartX, panStartY;
+
+// --present-mode picks one at startup, M cycles through them at runtime.
+SDL_GPUPresentMode presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+// --low-latency: SDL_AppIterate never blocks. A frame is only started when
+// its slot is free and a swapchain image is available right away. Otherwise
+// the iteration returns, and SDL gets to deliver newer input first.
+bool lowLatency = false;
+// The view used for culling is this many pixels larger than the window on
+// every side, so the late-latched pan can move the view a little without
+// sprites popping in at the edges.
+static const float LATE_LATCH_MARGIN = 64.0f;
+// Timestamp of the oldest input event that hasn't made it into a submitted
+// frame yet, 0 when there is none. latchedInputNS is the newest event that
+// latchInput already applied, so SDL_AppEvent doesn't count it again.
+Uint64 pendingInputNS;
+Uint64 latchedInputNS;
+LatencyStats inputLatency;
+
+Uint64 lastFrameNS;
+Uint64 statsTimerNS;
+// CPU time spent waiting for the GPU since the stats were last logged.
+Uint64 idleNS;
+Uint32 framesSinceStats;
+
+// Mouse positions come in window coordinates, the camera works in the
+// swapchain's pixels. They differ on high density displays.
+static void windowToPixels(float &x, float &y) {
+  int windowWidth, windowHeight, pixelWidth, pixelHeight;
+  SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+  SDL_GetWindowSizeInPixels(window, &pixelWidth, &pixelHeight);
+  if (windowWidth > 0 && windowHeight > 0) {
+    x *= (float)pixelWidth / windowWidth;
+    y *= (float)pixelHeight / windowHeight;
+  }
+}
+
+static void noteInput(Uint64 timestampNS) {
+  if (timestampNS > latchedInputNS && pendingInputNS == 0) {
+    pendingInputNS = timestampNS;
+  }
+}
+
+// The pan follows the mouse while dragging. It's computed from absolute
+// positions, so applying the newest one is all it takes to catch up.
+static void updatePan(float mouseX, float mouseY) {
+  if (panning) {
+    float dx = mouseX - panStartMouseX;
+    float dy = mouseY - panStartMouseY;
+    windowToPixels(dx, dy);
+    camera.setPosition(panStartX, panStartY);
+    camera.panScreen(-dx, -dy);
+  }
+}
+
+// Late latching: right before the view is pushed, pick up mouse motion that
+// arrived while the frame was being built. SDL_PumpEvents updates the mouse
+// state; the events themselves stay queued for SDL_AppEvent.
+static void latchInput() {
+  SDL_PumpEvents();
+  if (!panning) {
+    return;
+  }
+  SDL_Event events[64];
+  int count = SDL_PeepEvents(events, 64, SDL_PEEKEVENT, SDL_EVENT_MOUSE_MOTION,
+                             SDL_EVENT_MOUSE_MOTION);
+  for (int i = 0; i < count; i++) {
+    noteInput(events[i].common.timestamp);
+  }
+  if (count > 0) {
+    latchedInputNS =
+        SDL_max(latchedInputNS, events[count - 1].common.timestamp);
+  }
+  float mouseX, mouseY;
+  SDL_GetMouseState(&mouseX, &mouseY);
+  updatePan(mouseX, mouseY);
+}
+
+// VSYNC -> MAILBOX -> IMMEDIATE, skipping what the window doesn't support.
+static void cyclePresentMode() {
+  static const SDL_GPUPresentMode modes[] = {SDL_GPU_PRESENTMODE_VSYNC,
+                                             SDL_GPU_PRESENTMODE_MAILBOX,
+                                             SDL_GPU_PRESENTMODE_IMMEDIATE};
+  int current = 0;
+  while (modes[current] != presentMode) {
+    current++;
+  }
+  for (int step = 1; step < 3; step++) {
+    SDL_GPUPresentMode mode = modes[(current + step) % 3];
+    if (setPresentMode(device, window, mode)) {
+      presentMode = mode;
+      SDL_Log("Present mode: %s", presentModeName(presentMode));
+      return;
+    }
+  }
+}
+
+// One RGBA8 texture per image, uploaded right away. Only used with
+// --no-atlas, where every image is a texture of its own.
+static SDL_GPUTexture *createTexture(const Uint8 *pixels, Uint32 width,
+                                     Uint32 height) {
+  SDL_GPUTextureCreateInfo textureInfo{};
+  // The array variant of fragment.frag needs an array, even of one layer.
+  textureInfo.type = texturing == SpriteTexturing::Array
+                         ? SDL_GPU_TEXTURETYPE_2D_ARRAY
+                         : SDL_GPU_TEXTURETYPE_2D;
+  textureInfo.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+  textureInfo.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+  textureInfo.width = width;
+  textureInfo.height = height;
+  textureInfo.layer_count_or_depth = 1;
+  textureInfo.num_levels = 1;
+  SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, &textureInfo);
+
+  SDL_GPUTransferBufferCreateInfo transferInfo{};
+  transferInfo.size = width * height * 4;
+  transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  SDL_GPUTransferBuffer *transferBuffer =
+      SDL_CreateGPUTransferBuffer(device, &transferInfo);
+
+  Uint8 *data = (Uint8 *)SDL_MapGPUTransferBuffer(device, transferBuffer, false);
+  SDL_memcpy(data, pixels, width * height * 4);
+  SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+
+  SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+  SDL_GPUCopyPass *copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+
+  SDL_GPUTextureTransferInfo source{};
+  source.transfer_buffer = transferBuffer;
+  source.offset = 0;
+
+  SDL_GPUTextureRegion destination{};
+  destination.texture = texture;
+  destination.w = width;
+  destination.h = height;
+  destination.d = 1;
+
+  SDL_UploadToGPUTexture(copyPass, &source, &destination, false);
+  SDL_EndGPUCopyPass(copyPass);
+  SDL_SubmitGPUCommandBuffer(commandBuffer);
+
+  SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+  return texture;
+}
+
+// A soft edged disc in a random color, on a transparent background. Or, if
+// opaque, a tile in a random color with a darker border.
+static void generateImage(Uint32 width, Uint32 height, bool opaque,
+                          std::vector<Uint8> &pixels) {
+  pixels.resize((size_t)width * height * 4);
+  Uint8 r = (Uint8)(128 + SDL_rand(128));
+  Uint8 g = (Uint8)(128 + SDL_rand(128));
+  Uint8 b = (Uint8)(128 + SDL_rand(128));
+  float halfWidth = width * 0.5f, halfHeight = height * 0.5f;
+  for (Uint32 y = 0; y < height; y++) {
+    for (Uint32 x = 0; x < width; x++) {
+      float dx = (x + 0.5f - halfWidth) / halfWidth;
+      float dy = (y + 0.5f - halfHeight) / halfHeight;
+      Uint8 *pixel = &pixels[((size_t)y * width + x) * 4];
+      if (opaque) {
+        bool border = x == 0 || y == 0 || x == width - 1 || y == height - 1;
+        pixel[0] = border ? r / 2 : r;
+        pixel[1] = border ? g / 2 : g;
+        pixel[2] = border ? b / 2 : b;
+        pixel[3] = 255;
+        continue;
+      }
+      float edge = 1.0f - SDL_sqrtf(dx * dx + dy * dy);
+      float alpha = SDL_clamp(edge * 4.0f, 0.0f, 1.0f);
+      pixel[0] = r;
+      pixel[1] = g;
+      pixel[2] = b;
+      pixel[3] = (Uint8)(alpha * 255.0f);
+    }
+  }
+}
+
+// With --depth both batches get every texture, in the same order, so an id
+// means the same texture in either.
+static Uint16 addTexture(const SDL_GPUTextureSamplerBinding &binding) {
+  if (depthPasses) {
+    opaqueBatch.addTexture(binding);
+  }
+  return spriteBatch.addTexture(binding);
+}
+
+// Registers atlas pages the batch hasn't seen yet. Pages are only created
+// when an insert doesn't fit anymore. Pages that are layers of the same
+// texture array share one id, so they don't break the batch.
+static void registerAtlasPages() {
+  while (atlasPageIds.size() < atlas.pageCount()) {
+    Uint32 page = (Uint32)atlasPageIds.size();
+    SDL_GPUTexture *texture = atlas.pageTexture(page);
+    if (page > 0 && texture == atlas.pageTexture(page - 1)) {
+      atlasPageIds.push_back(atlasPageIds.back());
+    } else {
+      atlasPageIds.push_back(addTexture({texture, sampler}));
+    }
+  }
+}
+
+// (Re)generates image `index` with a random size between 8 and 64 texels.
+static bool loadImage(Uint32 index, std::vector<Uint8> &pixels) {
+  SpriteImage &image = images[index];
+  image.width = 8 + (Uint32)SDL_rand(57);
+  image.height = 8 + (Uint32)SDL_rand(57);
+  image.opaque = depthPasses && index % 2 == 1;
+  generateImage(image.width, image.height, image.opaque, pixels);
+  image.shape =
+      trimShapes ? shapeTable.add(pixels.data(), image.width, image.height) : 0;
+
+  if (!useAtlas) {
+    SDL_GPUTexture *texture = createTexture(pixels.data(), image.width,
+                                            image.height);
+    imageTextures.push_back(texture);
+    image.atlasId = -1;
+    image.texture = addTexture({texture, sampler});
+    image.texU = image.texV = 0.0f;
+    image.texW = image.texH = 1.0f;
+    image.textureLayer = 0.0f;
+    return true;
+  }
+
+  image.atlasId = atlas.insert(pixels.data(), image.width, image.height);
+  if (image.atlasId < 0) {
+    SDL_Log("Atlas is full");
+    return false;
+  }
+  registerAtlasPages();
+  const AtlasRegion &region = atlas.region(image.atlasId);
+  image.texture = atlasPageIds[region.page];
+  image.texU = region.texU;
+  image.texV = region.texV;
+  image.texW = region.texW;
+  image.texH = region.texH;
+  image.textureLayer = region.textureLayer;
+  return true;
+}
+
+static void applyImage(Sprite &sprite) {
+  const SpriteImage &image = images[sprite.image];
+  sprite.data.texU = image.texU;
+  sprite.data.texV = image.texV;
+  sprite.data.texW = image.texW;
+  sprite.data.texH = image.texH;
+  sprite.data.textureLayer = image.textureLayer;
+}
+
+// Moves the sprites that don't move to gpuCullBatch, sorted by layer and
+// depth like the batch keys would sort them.
+static bool createStaticSprites(float minPixelSize) {
+  for (Uint32 i = 0; i < (Uint32)scene.size(); i++) {
+    Sprite &sprite = scene[i];
+    if (sprite.vx == 0.0f && sprite.vy == 0.0f && sprite.spin == 0.0f) {
+      sprite.onGPU = true;
+      staticOrder.push_back(i);
+      spatialGrid.remove(i);
+      staticGrid.insert(i, spriteBounds(sprite.data.x, sprite.data.y,
+                                        sprite.data.w, sprite.data.h));
+    }
+  }
+  std::sort(staticOrder.begin(), staticOrder.end(), [](Uint32 a, Uint32 b) {
+    return makeBatchKey(scene[a].layer, 0, 0, scene[a].data.z) <
+           makeBatchKey(scene[b].layer, 0, 0, scene[b].data.z);
+  });
+  staticSprites.resize(staticOrder.size());
+  staticDirty = true;
+
+  GPUCullBatchSettings settings;
+  settings.capacity = (Uint32)staticOrder.size();
+  settings.minPixelSize = minPixelSize;
+  if (!gpuCullBatch.init(device, settings)) {
+    return false;
+  }
+  SDL_Log("GPU culling %u of %u sprites", (Uint32)staticOrder.size(),
+          (Uint32)scene.size());
+  return true;
+}
+
+// Adds the whole scene to retainedSprites, sorted by layer and depth like the
+// batch keys would sort them.
+static bool createRetainedSprites() {
+  std::vector<Uint32> order(scene.size());
+  for (Uint32 i = 0; i < (Uint32)scene.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [](Uint32 a, Uint32 b) {
+    return makeBatchKey(scene[a].layer, 0, 0, scene[a].data.z) <
+           makeBatchKey(scene[b].layer, 0, 0, scene[b].data.z);
+  });
+
+  RetainedSpritesSettings settings;
+  settings.capacity = (Uint32)scene.size();
+  settings.framesInFlight = frameLoop.framesInFlight();
+  if (!retainedSprites.init(device, settings)) {
+    return false;
+  }
+  retainedSlots.resize(scene.size());
+  for (Uint32 id : order) {
+    retainedSlots[id] = retainedSprites.add(scene[id].data);
+  }
+  return true;
+}
+
+// Every particle shows image 0.
+static void applyParticleImage() {
+  const SpriteImage &image = images[0];
+  ParticleSystemSettings &settings = particles.settings();
+  settings.texU = image.texU;
+  settings.texV = image.texV;
+  settings.texW = image.texW;
+  settings.texH = image.texH;
+  settings.textureLayer = image.textureLayer;
+  settings.shape = (float)image.shape;
+  particleTexture.texture =
+      useAtlas ? atlas.pageTexture(atlas.region(image.atlasId).page)
+               : imageTextures[0];
+  particleTexture.sampler = sampler;
+}
+
+// Evicts a random image and packs a new one of another size in its place,
+// to show insertion and eviction at runtime. Sprites using it pick up the
+// new region.
+static void replaceRandomImage() {
+  Uint32 index = (Uint32)SDL_rand((Sint32)images.size());
+  atlas.evict(images[index].atlasId);
+  shapeTable.remove(images[index].shape);
+  std::vector<Uint8> pixels;
+  if (!loadImage(index, pixels)) {
+    return;
+  }
+  for (Sprite &sprite : scene) {
+    if (sprite.image == index) {
+      applyImage(sprite);
+      if (retained) {
+        retainedSprites.set(retainedSlots[&sprite - scene.data()],
+                            sprite.data);
+      }
+    }
+  }
+  if (index == 0 && particles.count() > 0) {
+    applyParticleImage();
+  }
+  staticDirty = gpuCull;
+  SDL_Log("Replaced image %u, %u images on %u atlas pages", index,
+          atlas.imageCount(), atlas.pageCount());
+}
+
+// Packs 16 x 16 ground tiles and details into the atlas, and lays them out
+// over the map: ground everywhere, a detail on about one tile in twenty.
+static bool createTileMap() {
+  TileMapSettings settings;
+  settings.width = settings.height = tileMapSize;
+  settings.layers = 2;
+  settings.framesInFlight = frameLoop.framesInFlight();
+  if (!tileMap.init(device, settings)) {
+    return false;
+  }
+
+  Uint32 frameCount = SDL_arraysize(groundFrames) + DETAIL_FRAME_COUNT;
+  Uint16 frames[SDL_arraysize(groundFrames) + DETAIL_FRAME_COUNT];
+  std::vector<Uint8> pixels;
+  for (Uint32 i = 0; i < frameCount; i++) {
+    generateImage(16, 16, i < SDL_arraysize(groundFrames), pixels);
+    int atlasId = atlas.insert(pixels.data(), 16, 16);
+    if (atlasId < 0) {
+      SDL_Log("Atlas is full");
+      return false;
+    }
+    const AtlasRegion &region = atlas.region(atlasId);
+    frames[i] = tileMap.addFrame(region.texU, region.texV, region.texW,
+                                 region.texH, region.textureLayer);
+  }
+  registerAtlasPages();
+  SDL_memcpy(groundFrames, frames, sizeof(groundFrames));
+
+  for (Uint32 y = 0; y < tileMapSize; y++) {
+    for (Uint32 x = 0; x < tileMapSize; x++) {
+      tileMap.set(0, x, y, groundFrames[SDL_rand(SDL_arraysize(groundFrames))]);
+      if (SDL_rand(20) == 0) {
+        tileMap.set(1, x, y,
+                    frames[SDL_arraysize(groundFrames) +
+                           SDL_rand(DETAIL_FRAME_COUNT)]);
+      }
+    }
+  }
+  SDL_Log("Tile map: %u x %u tiles in %u chunks, %.1f MB", tileMapSize,
+          tileMapSize, tileMap.chunkCount(),
+          tileMap.chunkCount() * (double)TILE_CHUNK_BYTES / (1024.0 * 1024.0));
+  return true;
+}
+
+static void createScene(Uint32 count, float movingFraction) {
+  SpatialGridSettings gridSettings;
+  gridSettings.cellSize = 64.0f;
+  gridSettings.columns = 32;
+  gridSettings.rows = 32;
+  spatialGrid.init(gridSettings);
+  staticGrid.init(gridSettings);
+
+  scene.resize(count);
+  for (Uint32 i = 0; i < count; i++) {
+    Sprite &sprite = scene[i];
+    float size = 4.0f + SDL_randf() * 12.0f;
+    sprite.data = {};
+    sprite.data.x = SDL_randf() * 960.0f;
+    sprite.data.y = SDL_randf() * 540.0f;
+    sprite.data.rotation = SDL_randf() * 2.0f * SDL_PI_F;
+    sprite.data.w = size;
+    sprite.data.h = size;
+    sprite.data.r = 1.0f;
+    sprite.data.g = 1.0f;
+    sprite.data.b = 1.0f;
+    sprite.data.a = 1.0f;
+    sprite.vx = (SDL_randf() - 0.5f) * 200.0f;
+    sprite.vy = (SDL_randf() - 0.5f) * 200.0f;
+    sprite.spin = (SDL_randf() - 0.5f) * 4.0f;
+    // Two layers, and within a layer the images come in any order. The
+    // batch sorts them back into one draw per (layer, texture), which with
+    // the atlas means one draw per (layer, page).
+    sprite.layer = (Uint8)SDL_rand(2);
+    sprite.image = (Uint32)SDL_rand((Sint32)images.size());
+    applyImage(sprite);
+    sprite.data.z = SDL_randf();
+    if (SDL_randf() >= movingFraction) {
+      sprite.vx = sprite.vy = sprite.spin = 0.0f;
+    }
+    spatialGrid.insert(i, spriteBounds(sprite.data.x, sprite.data.y,
+                                       sprite.data.w, sprite.data.h));
+  }
+}
+
+static void updateScene(float dt, float width, float height) {
+  for (Uint32 i = 0; i < (Uint32)scene.size(); i++) {
+    Sprite &sprite = scene[i];
+    if (sprite.vx == 0.0f && sprite.vy == 0.0f && sprite.spin == 0.0f) {
+      continue;
+    }
+    sprite.data.x += sprite.vx * dt;
+    sprite.data.y += sprite.vy * dt;
+    sprite.data.rotation += sprite.spin * dt;
+
+    if (sprite.data.x < 0.0f || sprite.data.x > width) {
+      sprite.vx = -sprite.vx;
+    }
+    if (sprite.data.y < 0.0f || sprite.data.y > height) {
+      sprite.vy = -sprite.vy;
+    }
+    spatialGrid.move(i, spriteBounds(sprite.data.x, sprite.data.y,
+                                     sprite.data.w, sprite.data.h));
+    if (retained) {
+      retainedSprites.set(retainedSlots[i], sprite.data);
+    }
+  }
+}
+
+// Walks the pool from the back, so destroying a bullet only moves one that
+// was already updated into its place.
+static void updateBullets(float dt, float width, float height) {
+  SpriteStore &store = bullets.sprites();
+  for (Uint32 i = bullets.size(); i-- > 0;) {
+    store.x[i] += SDL_cosf(store.rotation[i]) * BULLET_SPEED * dt;
+    store.y[i] += SDL_sinf(store.rotation[i]) * BULLET_SPEED * dt;
+    if (store.x[i] < -BULLET_SIZE || store.x[i] > width + BULLET_SIZE ||
+        store.y[i] < -BULLET_SIZE || store.y[i] > height + BULLET_SIZE) {
+      bullets.destroy(bullets.handleAt(i));
+    }
+  }
+
+  const SpriteImage &image = images[0];
+  SpriteData bullet{};
+  bullet.x = width * 0.5f;
+  bullet.y = height * 0.5f;
+  bullet.w = bullet.h = BULLET_SIZE;
+  bullet.texU = image.texU;
+  bullet.texV = image.texV;
+  bullet.texW = image.texW;
+  bullet.texH = image.texH;
+  bullet.textureLayer = image.textureLayer;
+  bullet.r = bullet.g = bullet.b = bullet.a = 1.0f;
+  // What submitSprite() would do to every bullet every frame, done once:
+  // the pool goes into the batch as it is, see drawBullets().
+  bullet.z = depthPasses ? layeredDepth(BULLET_LAYER, 0.0f, LAYER_COUNT) : 0.0f;
+  bullet.shape = (float)image.shape;
+  bulletsOwed += bulletRate * dt;
+  for (; bulletsOwed >= 1.0f; bulletsOwed -= 1.0f) {
+    // Close to the golden angle, so the spiral's arms don't line up.
+    bulletAngle += 2.4f;
+    bullet.rotation = bulletAngle;
+    bullets.create(bullet);
+  }
+}
+
+// Is the world point inside the sprite's rotated quad? The point is rotated
+// back into the sprite's own space, where the quad is [0, w] x [0, h].
+static bool spriteContains(const SpriteData &sprite, float x, float y) {
+  float c = SDL_cosf(sprite.rotation);
+  float s = SDL_sinf(sprite.rotation);
+  float dx = x - sprite.x;
+  float dy = y - sprite.y;
+  float localX = c * dx + s * dy;
+  float localY = -s * dx + c * dy;
+  return localX >= 0.0f && localX <= sprite.w && localY >= 0.0f &&
+         localY <= sprite.h;
+}
+
+// The sprite drawn on top at a world point: the highest layer, then the
+// smallest z (larger z is drawn first). Returns false if there is none.
+static bool pickSprite(const SpatialGrid &grid, float x, float y,
+                       Uint32 &picked) {
+  grid.queryPoint(x, y, pickedSprites);
+  bool found = false;
+  for (Uint32 id : pickedSprites) {
+    const Sprite &sprite = scene[id];
+    if (!spriteContains(sprite.data, x, y)) {
+      continue;
+    }
+    if (!found || sprite.layer > scene[picked].layer ||
+        (sprite.layer == scene[picked].layer &&
+         sprite.data.z < scene[picked].data.z)) {
+      picked = id;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// The GPU culled sprites are drawn below the others.
+static bool pickSprite(float x, float y, Uint32 &picked) {
+  return pickSprite(spatialGrid, x, y, picked) ||
+         (gpuCull && pickSprite(staticGrid, x, y, picked));
+}
+
+// Into spriteBatch, or with --depth into the pass the sprite belongs to, at
+// the depth that keeps its layer in front of the ones below. With --trim,
+// the sprite's size on screen picks between its quad and its shape.
+static void submitSprite(SpriteData data, Uint8 layer, Uint32 image) {
+  Uint16 texture = images[image].texture;
+  if (depthPasses) {
+    data.z = layeredDepth(layer, data.z, LAYER_COUNT);
+    if (images[image].opaque && data.a == 1.0f) {
+      opaqueBatch.draw(data,
+                       makeOpaqueBatchKey(opaquePipelineId, texture, data.z));
+      return;
+    }
+  }
+  Uint8 pipeline = spritePipelineId;
+  float zoom = camera.zoom();
+  if (trimShapes && shapeTable.worthDrawing(images[image].shape,
+                                            data.w * data.h * zoom * zoom)) {
+    pipeline = trimmedPipelineId;
+    data.shape = (float)images[image].shape;
+  }
+  spriteBatch.draw(data, makeBatchKey(layer, pipeline, texture, data.z));
+}
+
+// The pool's dense arrays straight into spriteBatch, no SpriteData in
+// between. Bullets all show image 0, which is never opaque, so with --depth
+// they stay in the translucent pass. They're the same size, so --trim picks
+// for all of them at once; their shape is set when they're created, and the
+// quad pipeline ignores it.
+static void drawBullets() {
+  if (bullets.size() == 0) {
+    return;
+  }
+  float zoom = camera.zoom();
+  float pixels = BULLET_SIZE * BULLET_SIZE * zoom * zoom;
+  bool trim = trimShapes && shapeTable.worthDrawing(images[0].shape, pixels);
+  Uint8 pipeline = trim ? trimmedPipelineId : spritePipelineId;
+  spriteBatch.drawStore(bullets.sprites(), BULLET_LAYER, pipeline,
+                        images[0].texture);
+}
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
+  installAllocationCounter();
+
+  Uint32 spriteCount = 200000;
+  Uint32 particleCount = 0;
+  // Every logical core packs, the main thread included.
+  int threadCount = SDL_GetNumLogicalCPUCores();
+  int imageCount = 64;
+  SpriteLayout layout = SpriteLayout::Std140;
+  // Probed at startup unless --geometry picks one.
+  bool probeGeometry = true;
+  SpriteGeometry geometry = SpriteGeometry::VertexPulling;
+  float minPixelSize = 0.5f;
+  float movingFraction = 1.0f;
+  FrameLoopSettings frameLoopSettings;
+  FlightRecorderSettings recorderSettings;
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--compact") == 0) {
+      layout = SpriteLayout::Compact;
+    } else if (SDL_strcmp(argv[i], "--no-atlas") == 0) {
+      useAtlas = false;
+    } else if (SDL_strcmp(argv[i], "--single-texture") == 0) {
+      texturing = SpriteTexturing::Single;
+    } else if (SDL_strcmp(argv[i], "--gpu-cull") == 0) {
+      gpuCull = true;
+    } else if (SDL_strcmp(argv[i], "--retained") == 0) {
+      retained = true;
+    } else if (SDL_strcmp(argv[i], "--depth") == 0) {
+      depthPasses = true;
+    } else if (SDL_strcmp(argv[i], "--trim") == 0) {
+      trimShapes = true;
+    } else if (SDL_strcmp(argv[i], "--low-latency") == 0) {
+      lowLatency = true;
+    } else if (SDL_strcmp(argv[i], "--trace") == 0) {
+      traceSetEnabled(true);
+      traceSetThreadName("main");
+    }
+  }
+  for (int i = 1; i < argc - 1; i++) {
+    if (SDL_strcmp(argv[i], "--sprites") == 0) {
+      spriteCount = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--bullets") == 0) {
+      bulletRate = SDL_max((float)SDL_atof(argv[i + 1]), 0.0f);
+    } else if (SDL_strcmp(argv[i], "--particles") == 0) {
+      particleCount = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--threads") == 0) {
+      threadCount = SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--images") == 0) {
+      imageCount = SDL_max(SDL_atoi(argv[i + 1]), 1);
+    } else if (SDL_strcmp(argv[i], "--zoom") == 0) {
+      camera.setZoom((float)SDL_atof(argv[i + 1]));
+    } else if (SDL_strcmp(argv[i], "--min-pixel-size") == 0) {
+      minPixelSize = (float)SDL_atof(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--moving") == 0) {
+      movingFraction = (float)SDL_atof(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--tilemap") == 0) {
+      tileMapSize = (Uint32)SDL_max(SDL_atoi(argv[i + 1]), 0);
+    } else if (SDL_strcmp(argv[i], "--labels") == 0) {
+      labelCount = (Uint32)SDL_max(SDL_atoi(argv[i + 1]), 0);
+    } else if (SDL_strcmp(argv[i], "--frames-in-flight") == 0) {
+      frameLoopSettings.framesInFlight = (Uint32)SDL_atoi(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--hitch-budget") == 0) {
+      recorderSettings.budgetMS = (float)SDL_atof(argv[i + 1]);
+    } else if (SDL_strcmp(argv[i], "--geometry") == 0) {
+      if (SDL_strcmp(argv[i + 1], "pulling") == 0) {
+        probeGeometry = false;
+        geometry = SpriteGeometry::VertexPulling;
+      } else if (SDL_strcmp(argv[i + 1], "instanced") == 0) {
+        probeGeometry = false;
+        geometry = SpriteGeometry::Instanced;
+      }
+    } else if (SDL_strcmp(argv[i], "--present-mode") == 0) {
+      if (SDL_strcmp(argv[i + 1], "mailbox") == 0) {
+        presentMode = SDL_GPU_PRESENTMODE_MAILBOX;
+      } else if (SDL_strcmp(argv[i + 1], "immediate") == 0) {
+        presentMode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+      }
+    }
+  }
   window = SDL_CreateWindow("SpriteBatcher", 960, 540, SDL_WINDOW_RESIZABLE);
   device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, NULL);
 
   SDL_ClaimWindowForGPUDevice(device, window);
+  // The scene is spread over the window, so start out looking at its middle.
+  int pixelWidth, pixelHeight;
+  SDL_GetWindowSizeInPixels(window, &pixelWidth, &pixelHeight);
+  camera.setViewport((float)pixelWidth, (float)pixelHeight);
+  camera.setPosition(pixelWidth * 0.5f, pixelHeight * 0.5f);
+  camera.setCullMargin(LATE_LATCH_MARGIN);
+  if (!frameLoop.init(device, frameLoopSettings)) {
+    return SDL_APP_FAILURE;
+  }
+  if (presentMode != SDL_GPU_PRESENTMODE_VSYNC &&
+      !setPresentMode(device, window, presentMode)) {
+    presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+  }
+
+  SDL_GPUTextureFormat swapchainFormat =
+      SDL_GetGPUSwapchainTextureFormat(device, window);
+  if (probeGeometry) {
+    GeometryProbeResult probe;
+    if (probeSpriteGeometry(device, swapchainFormat, layout, texturing,
+                            GeometryProbeSettings{}, probe)) {
+      geometry = probe.fastest;
+      SDL_Log("Sprite geometry: %s on %s (vertex pulling %.3f ms, instanced "
+              "%.3f ms)",
+              spriteGeometryName(geometry), SDL_GetGPUDeviceDriver(device),
+              probe.vertexPullingNS / 1e6, probe.instancedNS / 1e6);
+    }
+  }
+  spritePipeline = createSpritePipeline(
+      device, swapchainFormat, layout, texturing, geometry,
+      depthPasses ? SpriteDepth::Translucent : SpriteDepth::None);
+  if (!spritePipeline) {
+    return SDL_APP_FAILURE;
+  }
+  if (depthPasses) {
+    opaquePipeline = createSpritePipeline(device, swapchainFormat, layout,
+                                          texturing, geometry,
+                                          SpriteDepth::Opaque);
+    if (!opaquePipeline) {
+      return SDL_APP_FAILURE;
+    }
+  }
+  if (trimShapes) {
+    trimmedPipeline = createSpritePipeline(
+        device, swapchainFormat, layout, texturing, SpriteGeometry::Trimmed,
+        depthPasses ? SpriteDepth::Translucent : SpriteDepth::None);
+    if (!trimmedPipeline || !shapeTable.init(device, SpriteShapeSettings{})) {
+      return SDL_APP_FAILURE;
+    }
+  }
+
+  SDL_GPUSamplerCreateInfo samplerInfo{};
+  samplerInfo.min_filter = SDL_GPU_FILTER_NEAREST;
+  samplerInfo.mag_filter = SDL_GPU_FILTER_NEAREST;
+  samplerInfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+  samplerInfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+  samplerInfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+  samplerInfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+  sampler = SDL_CreateGPUSampler(device, &samplerInfo);
+
+  workerPool.init(threadCount > 1 ? (Uint32)threadCount - 1 : 0);
+
+  SpriteBatchSettings batchSettings;
+  batchSettings.capacity = spriteCount;
+  batchSettings.workerPool = &workerPool;
+  batchSettings.layout = layout;
+  batchSettings.geometry = geometry;
+  batchSettings.minPixelSize = minPixelSize;
+  batchSettings.framesInFlight = frameLoop.framesInFlight();
+  batchSettings.arena = &frameArena;
+  batchSettings.shapeBuffer = shapeTable.buffer();
+  // Grows on its own if a frame needs more, see FrameArena.
+  if (!frameArena.init((Uint64)spriteCount * 32)) {
+    return SDL_APP_FAILURE;
+  }
+  if (!spriteBatch.init(device, batchSettings)) {
+    return SDL_APP_FAILURE;
+  }
+  spritePipelineId = spriteBatch.addPipeline(spritePipeline);
+  if (trimShapes) {
+    trimmedPipelineId =
+        spriteBatch.addPipeline(trimmedPipeline, SpriteGeometry::Trimmed);
+  }
+  if (depthPasses) {
+    if (!opaqueBatch.init(device, batchSettings)) {
+      return SDL_APP_FAILURE;
+    }
+    opaquePipelineId = opaqueBatch.addPipeline(opaquePipeline);
+  }
+
+  TextureAtlasSettings atlasSettings;
+  atlasSettings.textureArray = texturing == SpriteTexturing::Array;
+  if (useAtlas && !atlas.init(device, atlasSettings)) {
+    return SDL_APP_FAILURE;
+  }
+  images.resize(imageCount);
+  std::vector<Uint8> pixels;
+  for (Uint32 i = 0; i < (Uint32)imageCount; i++) {
+    if (!loadImage(i, pixels)) {
+      return SDL_APP_FAILURE;
+    }
+  }
+  // Every image is a separate texture binding without the atlas. With it
+  // every page is, or a single texture array for all pages. Breaks are per
+  // layer, since layers always split draws.
+  if (useAtlas) {
+    int bindings = texturing == SpriteTexturing::Array
+                       ? 1
+                       : (int)atlas.pageCount();
+    SDL_Log("Atlas: %d images on %u pages (%.0f%% of the first used), %d "
+            "texture bindings. Removes up to %d texture breaks per layer.",
+            imageCount, atlas.pageCount(), atlas.pageOccupancy(0) * 100.0f,
+            bindings, imageCount - bindings);
+  }
+
+  // One texture binding has to cover every image.
+  if (gpuCull && (!useAtlas || texturing != SpriteTexturing::Array)) {
+    SDL_Log("--gpu-cull needs the texture array atlas, culling on the CPU");
+    gpuCull = false;
+  }
+  if (tileMapSize > 0 && (!useAtlas || texturing != SpriteTexturing::Array)) {
+    SDL_Log("--tilemap needs the texture array atlas, no tile map");
+    tileMapSize = 0;
+  }
+  if (retained && (!useAtlas || texturing != SpriteTexturing::Array)) {
+    SDL_Log("--retained needs the texture array atlas, using the sprite batch");
+    retained = false;
+  }
+  if (labelCount > 0 && !useAtlas) {
+    SDL_Log("--labels rasterizes glyphs into the atlas, no labels");
+    labelCount = 0;
+  }
+  if (retained && gpuCull) {
+    SDL_Log("--retained draws every sprite, ignoring --gpu-cull");
+    gpuCull = false;
+  }
+  // Both keep their own draw order, with the layers left out of z.
+  if (depthPasses && (gpuCull || retained)) {
+    SDL_Log("--depth draws through the sprite batches, ignoring --gpu-cull "
+            "and --retained");
+    gpuCull = retained = false;
+  }
+  if (particleCount > 0 || gpuCull || retained) {
+    gpuSpritePipeline =
+        layout == SpriteLayout::Std140 &&
+                geometry == SpriteGeometry::VertexPulling
+            ? spritePipeline
+            : createSpritePipeline(
+                  device, swapchainFormat, SpriteLayout::Std140, texturing,
+                  SpriteGeometry::VertexPulling,
+                  depthPasses ? SpriteDepth::Translucent : SpriteDepth::None);
+    if (!gpuSpritePipeline) {
+      return SDL_APP_FAILURE;
+    }
+  }
+  if (trimShapes && particleCount > 0) {
+    gpuTrimmedPipeline =
+        layout == SpriteLayout::Std140
+            ? trimmedPipeline
+            : createSpritePipeline(
+                  device, swapchainFormat, SpriteLayout::Std140, texturing,
+                  SpriteGeometry::Trimmed,
+                  depthPasses ? SpriteDepth::Translucent : SpriteDepth::None);
+    if (!gpuTrimmedPipeline) {
+      return SDL_APP_FAILURE;
+    }
+  }
+  if (tileMapSize > 0) {
+    tilePipeline = createTilePipeline(
+        device, swapchainFormat, texturing,
+        depthPasses ? SpriteDepth::Translucent : SpriteDepth::None);
+    if (!tilePipeline || !createTileMap()) {
+      return SDL_APP_FAILURE;
+    }
+  }
+  if (labelCount > 0) {
+    TextRendererSettings textSettings;
+    textSettings.atlas = &atlas;
+    textSettings.pageTexture = [](Uint32 page, void *) {
+      registerAtlasPages();
+      return atlasPageIds[page];
+    };
+    if (!textRenderer.init(textSettings)) {
+      return SDL_APP_FAILURE;
+    }
+    labelStyle.font = textRenderer.addFont(builtinFont());
+    labelStyle.size = 14;
+    labelStyle.layer = TEXT_LAYER;
+    labelStyle.pipeline = spritePipelineId;
+    labelStyle.z = depthPasses ? layeredDepth(TEXT_LAYER, 0.0f, LAYER_COUNT)
+                               : 0.0f;
+  }
+  if (particleCount > 0) {
+    ParticleSystemSettings particleSettings;
+    particleSettings.count = particleCount;
+    if (!particles.init(device, particleSettings)) {
+      return SDL_APP_FAILURE;
+    }
+    applyParticleImage();
+  }
+
+  createScene(spriteCount, movingFraction);
+  // Enough for a few seconds of them, the time one takes to cross the
+  // window.
+  bullets.init((Uint32)(bulletRate * 4.0f));
+  if (gpuCull && !createStaticSprites(minPixelSize)) {
+    return SDL_APP_FAILURE;
+  }
+  if (retained && !createRetainedSprites()) {
+    return SDL_APP_FAILURE;
+  }
+  flightRecorder.init(recorderSettings);
+  lastFrameNS = SDL_GetTicksNS();
+  statsTimerNS = lastFrameNS;
 
   return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
-  SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+  // Nothing allocated last frame is in use anymore.
+  frameArena.reset();
+  // In low-latency mode, come back later rather than wait. Otherwise begin()
+  // blocks only when the CPU is framesInFlight frames ahead of the GPU.
+  if (lowLatency && !frameLoop.ready()) {
+    return SDL_APP_CONTINUE;
+  }
+  TRACE_ZONE("frame");
+  FrameRecord &record = flightRecorder.beginFrame();
+  SDL_GPUCommandBuffer *commandBuffer;
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Acquire);
+    commandBuffer = frameLoop.begin();
+  }
+  if (!commandBuffer) {
+    return SDL_APP_FAILURE;
+  }
   SDL_GPUTexture *swapchainTexture;
 
   Uint32 width, height;
 
-  SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, window,
-                                        &swapchainTexture, &width, &height);
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Swapchain);
+    frameLoop.acquireSwapchainTexture(commandBuffer, window, &swapchainTexture,
+                                      &width, &height, !lowLatency);
+  }
+  idleNS += frameLoop.stats().fenceWaitNS + frameLoop.stats().swapchainWaitNS;
 
   if (swapchainTexture == NULL) {
     // swapchain texture has not finished updating. It's overloaded for example.
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    // Nothing has been recorded, so the frame is simply dropped.
+    frameLoop.cancel(commandBuffer);
+    flightRecorder.endFrame();
     return SDL_APP_CONTINUE;
   }
+  framesSinceStats++;
+
+  Uint64 now = SDL_GetTicksNS();
+  float dt = (now - lastFrameNS) / 1e9f;
+  lastFrameNS = now;
+
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Update);
+    updateScene(dt, (float)width, (float)height);
+    if (bulletRate > 0.0f) {
+      updateBullets(dt, (float)width, (float)height);
+    }
+  }
+
+  // Culling and the grid query use a slightly larger view than the one that
+  // ends up on screen, see LATE_LATCH_MARGIN.
+  camera.setViewport((float)width, (float)height);
+
+  // Build the batch first, so the glyphs its labels rasterize make this
+  // frame's copy passes. Copy passes can't happen inside a render pass, so
+  // the uploads are all recorded before it.
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Build);
+    spriteBatch.begin(frameLoop.frameSlot());
+    if (depthPasses) {
+      opaqueBatch.begin(frameLoop.frameSlot());
+    }
+    // Retained sprites were set() as they changed; the batch stays empty.
+    // The labels still need the visible ones.
+    if (!retained || labelCount > 0) {
+      spatialGrid.queryRect(camera.cullBounds(), visibleSprites);
+    }
+    if (!retained) {
+      for (Uint32 id : visibleSprites) {
+        const Sprite &sprite = scene[id];
+        submitSprite(sprite.data, sprite.layer, sprite.image);
+      }
+    }
+    drawBullets();
+    if (labelCount > 0) {
+      textRenderer.beginFrame();
+      Uint32 labels = SDL_min(labelCount, (Uint32)visibleSprites.size());
+      for (Uint32 i = 0; i < labels; i++) {
+        Uint32 id = visibleSprites[i];
+        const Sprite &sprite = scene[id];
+        SDL_snprintf(labelText, sizeof(labelText), "#%u\nimage %u", id,
+                     sprite.image);
+        textRenderer.draw(spriteBatch, labelStyle, labelText, sprite.data.x,
+                          sprite.data.y);
+      }
+    }
+  }
+
+  // Images inserted since last frame, and the glyphs the labels just
+  // rasterized, all in one copy pass.
+  if (useAtlas) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload,
+                        "atlas copy pass");
+    atlas.upload(commandBuffer);
+  }
+  // Shapes of the images loaded since, likewise.
+  if (trimShapes) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload,
+                        "shape table copy pass");
+    shapeTable.upload(commandBuffer);
+  }
+  // Chunks loaded or edited since, likewise. Nothing on most frames.
+  if (tileMapSize > 0) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "tile upload");
+    tileMap.upload(commandBuffer, frameLoop.frameSlot());
+  }
+
+  spriteBatch.setView(camera.cullViewProjection().m,
+                      width + 2.0f * LATE_LATCH_MARGIN,
+                      height + 2.0f * LATE_LATCH_MARGIN);
+  // A batch whose upload failed isn't drawn this frame.
+  bool batchUploaded;
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload);
+    batchUploaded = spriteBatch.upload(commandBuffer);
+  }
+  bool opaqueUploaded = false;
+  if (depthPasses) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "opaque upload");
+    opaqueBatch.setView(camera.cullViewProjection().m,
+                        width + 2.0f * LATE_LATCH_MARGIN,
+                        height + 2.0f * LATE_LATCH_MARGIN);
+    opaqueUploaded = opaqueBatch.upload(commandBuffer);
+  }
+  if (staticDirty) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "static upload");
+    for (size_t i = 0; i < staticOrder.size(); i++) {
+      staticSprites[i] = scene[staticOrder[i]].data;
+    }
+    // Still dirty if it failed, so it's retried next frame.
+    staticDirty = !gpuCullBatch.upload(commandBuffer, 0, staticSprites.data(),
+                                       (Uint32)staticSprites.size());
+  }
+  if (retained) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "retained upload");
+    retainedSprites.upload(commandBuffer, frameLoop.frameSlot());
+  }
+  // A compute pass, which also has to be outside the render pass. It
+  // uploads nothing but its uniforms.
+  if (particles.count() > 0) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "particles");
+    particles.settings().emitterX = width * 0.5f;
+    particles.settings().emitterY = height * 0.9f;
+    particles.update(commandBuffer, dt);
+  }
+
+  // Everything expensive is recorded. Only now is the view the sprites are
+  // drawn with computed, from the newest input there is.
+  latchInput();
+  // Culled on the GPU, so it can use the final view and needs no margin.
+  if (gpuCull) {
+    FramePhaseZone zone(flightRecorder, FramePhase::Upload, "GPU cull");
+    gpuCullBatch.cull(commandBuffer, camera.viewProjection().m,
+                      (float)width, (float)height);
+  }
 
   // Color target - where gpu draws
   SDL_GPUColorTargetInfo colorTargetInfo{};
@@ -41,12 +1227,181 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
   colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
   colorTargetInfo.texture = swapchainTexture;
 
-  SDL_GPURenderPass *renderPass =
-      SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
+  // Only needed while the pass runs, so it's neither loaded nor stored.
+  SDL_GPUDepthStencilTargetInfo depthTargetInfo{};
+  if (depthPasses) {
+    if (!depthTexture || depthWidth != width || depthHeight != height) {
+      SDL_ReleaseGPUTexture(device, depthTexture);
+      depthTexture = createSpriteDepthTexture(device, width, height);
+      depthWidth = width;
+      depthHeight = height;
+      // A command buffer that acquired a swapchain texture can't be
+      // cancelled, only submitted.
+      if (!depthTexture) {
+        frameLoop.submit(commandBuffer);
+        return SDL_APP_FAILURE;
+      }
+    }
+    depthTargetInfo.texture = depthTexture;
+    depthTargetInfo.clear_depth = 1.0f;
+    depthTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+    depthTargetInfo.store_op = SDL_GPU_STOREOP_DONT_CARE;
+    depthTargetInfo.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+    depthTargetInfo.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+    depthTargetInfo.cycle = true;
+  }
 
-  SDL_EndGPURenderPass(renderPass);
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Render);
+    SDL_GPURenderPass *renderPass = SDL_BeginGPURenderPass(
+        commandBuffer, &colorTargetInfo, 1,
+        depthPasses ? &depthTargetInfo : NULL);
+
+    // The batch binds the pipeline itself; uniforms are command buffer state
+    // and stay put.
+    camera.pushUniform(commandBuffer);
+
+    // Below everything, only the chunks under the final view.
+    if (tileMapSize > 0) {
+      tileMap.render(commandBuffer, renderPass, tilePipeline,
+                     {atlas.pageTexture(0), sampler}, camera.viewBounds());
+    }
+    if (gpuCull) {
+      gpuCullBatch.render(renderPass, gpuSpritePipeline,
+                          {atlas.pageTexture(0), sampler});
+    }
+    if (retained) {
+      retainedSprites.render(renderPass, gpuSpritePipeline,
+                             {atlas.pageTexture(0), sampler});
+    }
+    // Opaque sprites first, so the translucent ones are tested against them.
+    if (opaqueUploaded) {
+      opaqueBatch.render(renderPass);
+    }
+    if (batchUploaded) {
+      spriteBatch.render(renderPass);
+    }
+    if (particles.count() > 0) {
+      // Particles shrink over their life, so this is about the largest.
+      const ParticleSystemSettings &settings = particles.settings();
+      float size = settings.size * camera.zoom();
+      if (trimShapes &&
+          shapeTable.worthDrawing((Uint32)settings.shape, size * size)) {
+        particles.render(renderPass, gpuTrimmedPipeline, particleTexture,
+                         shapeTable.buffer());
+      } else {
+        particles.render(renderPass, gpuSpritePipeline, particleTexture);
+      }
+    }
+
+    SDL_EndGPURenderPass(renderPass);
+  }
+
+  {
+    FramePhaseZone zone(flightRecorder, FramePhase::Submit);
+    frameLoop.submit(commandBuffer);
+    camera.submitted();
+  }
+
+  const SpriteBatchStats &batchStats = spriteBatch.stats();
+  record.sprites = batchStats.sprites;
+  record.kept = batchStats.kept;
+  record.drawCalls = batchStats.drawCalls;
+  record.bytesUploaded = batchStats.bytesUploaded;
+  record.arenaBytes = frameArena.frameBytes();
+  if (depthPasses) {
+    const SpriteBatchStats &opaqueStats = opaqueBatch.stats();
+    record.sprites += opaqueStats.sprites;
+    record.kept += opaqueStats.kept;
+    record.drawCalls += opaqueStats.drawCalls;
+    record.bytesUploaded += opaqueStats.bytesUploaded;
+  }
+  if (retained) {
+    record.sprites = record.kept = retainedSprites.count();
+    record.drawCalls = 1;
+    record.bytesUploaded = retainedSprites.stats().bytesUploaded;
+  }
+  if (tileMapSize > 0) {
+    record.drawCalls += tileMap.stats().drawCalls;
+    record.bytesUploaded += tileMap.stats().bytesUploaded;
+  }
+  flightRecorder.endFrame();
+  if (pendingInputNS != 0) {
+    inputLatency.add(SDL_GetTicksNS() - pendingInputNS);
+    pendingInputNS = 0;
+  }
+
+  if (now - statsTimerNS >= 1000000000) {
+    const SpriteBatchStats &stats = spriteBatch.stats();
+    SDL_Log("sprites: %u (kept %u, culled %u), draws: %u, state changes: %u, "
+            "uploaded: %" SDL_PRIu64 " bytes, upload: %.3f ms (cull: %.3f ms, "
+            "sort: %.3f ms), waiting for the GPU: %.3f ms/frame",
+            stats.sprites, stats.kept, stats.culled, stats.drawCalls,
+            stats.stateChanges, stats.bytesUploaded, stats.uploadNS / 1e6,
+            stats.cullNS / 1e6, stats.sortNS / 1e6,
+            idleNS / 1e6 / framesSinceStats);
+    SDL_Log("frame arena: %.1f KB this frame, %.1f KB peak, %.1f KB capacity, "
+            "grown %u times",
+            frameArena.frameBytes() / 1024.0, frameArena.peakBytes() / 1024.0,
+            frameArena.capacity() / 1024.0, frameArena.growCount());
+    if (depthPasses) {
+      const SpriteBatchStats &opaqueStats = opaqueBatch.stats();
+      SDL_Log("depth: %u opaque sprites front to back (sort: %.3f ms), %u "
+              "translucent back to front (sort: %.3f ms)",
+              opaqueStats.kept, opaqueStats.sortNS / 1e6, stats.kept,
+              stats.sortNS / 1e6);
+    }
+    if (trimShapes) {
+      SDL_Log("trim: %u of %u images have a shape, %u of %u sprites drawn "
+              "trimmed",
+              shapeTable.shapeCount(), (Uint32)images.size(), stats.trimmed,
+              stats.kept);
+    }
+    if (tileMapSize > 0) {
+      const TileMapStats &tileStats = tileMap.stats();
+      SDL_Log("tiles: %u of %u chunks drawn in %u draws, %u uploaded, %u "
+              "pending",
+              tileStats.visibleChunks, tileMap.chunkCount(),
+              tileStats.drawCalls, tileStats.uploadedChunks,
+              tileStats.pendingChunks);
+    }
+    if (labelCount > 0) {
+      const TextStats &textStats = textRenderer.stats();
+      SDL_Log("labels: %u quads, run cache hit rate %.1f%% (%u runs cached, "
+              "%u evicted), %u glyphs (%u new), atlas %.1f%% full",
+              textStats.quads, textRenderer.runHitRate() * 100.0f,
+              textStats.cachedRuns, textStats.evictedRuns,
+              textStats.cachedGlyphs, textStats.glyphsRasterized,
+              textStats.atlasOccupancy * 100.0f);
+    }
+    if (bulletRate > 0.0f) {
+      SDL_Log("bullets: %u live, %.0f created per second", bullets.size(),
+              bulletRate);
+    }
+    if (retained) {
+      const RetainedSpriteStats &retainedStats = retainedSprites.stats();
+      SDL_Log("retained: %u sprites, %u dirty in %u regions, uploaded: "
+              "%" SDL_PRIu64 " bytes (%.1f%% of all), upload: %.3f ms",
+              retainedSprites.count(), retainedStats.dirtySprites,
+              retainedStats.regions, retainedStats.bytesUploaded,
+              retainedStats.bytesUploaded * 100.0 /
+                  ((double)retainedSprites.count() * sizeof(SpriteData)),
+              retainedStats.uploadNS / 1e6);
+    }
+    if (inputLatency.count() > 0) {
+      LatencySummary latency = inputLatency.summarize();
+      SDL_Log("present mode: %s%s, input to submit: p50 %.3f ms, p95 %.3f "
+              "ms, p99 %.3f ms, max %.3f ms (%u frames)",
+              presentModeName(presentMode), lowLatency ? " (low latency)" : "",
+              latency.p50NS / 1e6, latency.p95NS / 1e6, latency.p99NS / 1e6,
+              latency.maxNS / 1e6, latency.count);
+      inputLatency.clear();
+    }
+    statsTimerNS = now;
+    idleNS = 0;
+    framesSinceStats = 0;
+  }
 
-  SDL_SubmitGPUCommandBuffer(commandBuffer);
   return SDL_APP_CONTINUE;
 }
 
@@ -54,7 +1409,126 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
   if (event->type == SDL_EVENT_WINDOW_CLOSE_REQUESTED) {
     return SDL_APP_SUCCESS;
   };
+  if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_R &&
+      useAtlas) {
+    replaceRandomImage();
+  }
+  if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_M) {
+    cyclePresentMode();
+  }
+  if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_Q) {
+    camera.setRotation(camera.rotation() - ROTATION_STEP);
+  }
+  if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_E) {
+    camera.setRotation(camera.rotation() + ROTATION_STEP);
+  }
+  // Zooms around the cursor: the world point under it stays under it.
+  if (event->type == SDL_EVENT_MOUSE_WHEEL && event->wheel.y != 0.0f) {
+    float mouseX = event->wheel.mouse_x;
+    float mouseY = event->wheel.mouse_y;
+    windowToPixels(mouseX, mouseY);
+    float beforeX, beforeY, afterX, afterY;
+    camera.screenToWorld(mouseX, mouseY, beforeX, beforeY);
+    camera.setZoom(camera.zoom() * SDL_powf(1.1f, event->wheel.y));
+    camera.screenToWorld(mouseX, mouseY, afterX, afterY);
+    camera.setPosition(camera.x() + beforeX - afterX,
+                       camera.y() + beforeY - afterY);
+  }
+  // Whatever the rings hold right now. Workers are idle between frames, so
+  // nothing is recording.
+  if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_T &&
+      traceEnabled()) {
+    traceWriteJSON("trace.json");
+  }
+  if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN &&
+      event->button.button == SDL_BUTTON_RIGHT) {
+    panning = true;
+    panStartMouseX = event->button.x;
+    panStartMouseY = event->button.y;
+    panStartX = camera.x();
+    panStartY = camera.y();
+  }
+  if (event->type == SDL_EVENT_MOUSE_BUTTON_UP &&
+      event->button.button == SDL_BUTTON_RIGHT) {
+    panning = false;
+  }
+  // Motion that latchInput has already applied is older than the pan.
+  if (event->type == SDL_EVENT_MOUSE_MOTION && panning &&
+      event->common.timestamp > latchedInputNS) {
+    noteInput(event->common.timestamp);
+    updatePan(event->motion.x, event->motion.y);
+  }
+  if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN &&
+      event->button.button == SDL_BUTTON_LEFT) {
+    float x = event->button.x;
+    float y = event->button.y;
+    windowToPixels(x, y);
+    camera.screenToWorld(x, y, x, y);
+
+    Uint32 picked;
+    if (pickSprite(x, y, picked)) {
+      // Stop it and paint it white, so the pick is visible.
+      Sprite &sprite = scene[picked];
+      SDL_Log("Picked sprite %u at (%.1f, %.1f)", picked, sprite.data.x,
+              sprite.data.y);
+      sprite.vx = sprite.vy = sprite.spin = 0.0f;
+      sprite.data.r = sprite.data.g = sprite.data.b = 1.0f;
+      if (sprite.onGPU) {
+        staticDirty = true;
+      }
+      if (retained) {
+        retainedSprites.set(retainedSlots[picked], sprite.data);
+      }
+    } else if (tileMapSize > 0) {
+      // The next ground tile, so every click shows.
+      Uint32 tileX, tileY;
+      if (tileMap.tileAt(x, y, tileX, tileY)) {
+        Uint16 ground = tileMap.get(0, tileX, tileY);
+        Uint32 next = 0;
+        while (next < SDL_arraysize(groundFrames) &&
+               groundFrames[next] != ground) {
+          next++;
+        }
+        next = (next + 1) % SDL_arraysize(groundFrames);
+        tileMap.set(0, tileX, tileY, groundFrames[next]);
+        SDL_Log("Painted tile (%u, %u)", tileX, tileY);
+      }
+    }
+  }
   return SDL_APP_CONTINUE;
 }
 
-void SDL_AppQuit(void *appstate, SDL_AppResult result) {}
+void SDL_AppQuit(void *appstate, SDL_AppResult result) {
+  frameLoop.release();
+  if (traceEnabled()) {
+    traceWriteJSON("trace.json");
+  }
+  spriteBatch.release();
+  opaqueBatch.release();
+  frameArena.release();
+  particles.release();
+  gpuCullBatch.release();
+  retainedSprites.release();
+  tileMap.release();
+  textRenderer.release();
+  SDL_ReleaseGPUGraphicsPipeline(device, tilePipeline);
+  if (gpuSpritePipeline && gpuSpritePipeline != spritePipeline) {
+    SDL_ReleaseGPUGraphicsPipeline(device, gpuSpritePipeline);
+  }
+  if (gpuTrimmedPipeline && gpuTrimmedPipeline != trimmedPipeline) {
+    SDL_ReleaseGPUGraphicsPipeline(device, gpuTrimmedPipeline);
+  }
+  SDL_ReleaseGPUGraphicsPipeline(device, trimmedPipeline);
+  shapeTable.release();
+  workerPool.shutdown();
+  atlas.release();
+  for (SDL_GPUTexture *texture : imageTextures) {
+    SDL_ReleaseGPUTexture(device, texture);
+  }
+  SDL_ReleaseGPUSampler(device, sampler);
+  SDL_ReleaseGPUGraphicsPipeline(device, spritePipeline);
+  SDL_ReleaseGPUGraphicsPipeline(device, opaquePipeline);
+  SDL_ReleaseGPUTexture(device, depthTexture);
+  SDL_DestroyGPUDevice(device);
+  SDL_DestroyWindow(window);
+}
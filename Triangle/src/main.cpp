@@ -7,6 +7,7 @@
 #include "SDL3/SDL_init.h"
 #include "SDL3/SDL_iostream.h"
 #include "SDL3/SDL_stdinc.h"
+#include "SDL3/SDL_timer.h"
 #include "SDL3/SDL_video.h"
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
@@ -45,11 +46,27 @@ SDL_GPUBuffer *vertexBuffer;
 SDL_GPUTransferBuffer *transferBuffer;
 SDL_GPUGraphicsPipeline *graphicsPipeline;
 
+// Frames in flight. The CPU may record this many frames before it has to
+// wait for the GPU to finish the oldest one. Every submit hands back a fence,
+// which signals when the GPU is done with that frame. Anything a frame
+// writes for the GPU (like a transfer buffer) can be reused once its fence
+// has signalled, without SDL having to cycle it.
+static const Uint32 FRAMES_IN_FLIGHT = 2;
+SDL_GPUFence *frameFences[FRAMES_IN_FLIGHT];
+Uint64 frameCount;
+
+// How long the CPU waited on fences, logged once per second.
+Uint64 idleNS;
+Uint64 idleFrames;
+Uint64 idleTimerNS;
+
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
   window = SDL_CreateWindow("Hello, Triangle", 960, 540, SDL_WINDOW_RESIZABLE);
 
   device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, NULL);
   SDL_ClaimWindowForGPUDevice(device, window);
+  // The swapchain shouldn't queue more frames than we have fences for.
+  SDL_SetGPUAllowedFramesInFlight(device, FRAMES_IN_FLIGHT);
 
   // It's time to then send this data to a GPU buffer. It should not be mistaken
   // for the command buffer, which is the total buffer storage desgination.
@@ -241,6 +258,24 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
 }
 
 SDL_AppResult SDL_AppIterate(void *appstate) {
+  // Wait for the frame that used this slot FRAMES_IN_FLIGHT frames ago. Most
+  // of the time it's done already and this doesn't block at all.
+  Uint32 slot = (Uint32)(frameCount % FRAMES_IN_FLIGHT);
+  if (frameFences[slot]) {
+    Uint64 waitStart = SDL_GetTicksNS();
+    SDL_WaitForGPUFences(device, true, &frameFences[slot], 1);
+    idleNS += SDL_GetTicksNS() - waitStart;
+    SDL_ReleaseGPUFence(device, frameFences[slot]);
+    frameFences[slot] = NULL;
+  }
+  idleFrames++;
+  if (SDL_GetTicksNS() - idleTimerNS >= 1000000000) {
+    SDL_Log("waiting for the GPU: %.3f ms/frame", idleNS / 1e6 / idleFrames);
+    idleNS = 0;
+    idleFrames = 0;
+    idleTimerNS = SDL_GetTicksNS();
+  }
+
   SDL_GPUCommandBuffer *commandBuffer = SDL_AcquireGPUCommandBuffer(device);
 
   SDL_GPUTexture *swapchainTexture;
@@ -254,8 +289,9 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 
   if (swapchainTexture == NULL) {
     // end the frame early if a swapchain texture is not available
-    // SDL_SubmitGPUCommandBuffer has to be called at the end of every frame.
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    // The command buffer has to be submitted at the end of every frame.
+    frameFences[slot] = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    frameCount++;
     return SDL_APP_CONTINUE;
   }
 
@@ -311,8 +347,10 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
   // end the render pass
   SDL_EndGPURenderPass(renderPass);
 
-  // submit the command buffer
-  SDL_SubmitGPUCommandBuffer(commandBuffer);
+  // submit the command buffer, and keep its fence for when this slot comes
+  // around again.
+  frameFences[slot] = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+  frameCount++;
   return SDL_APP_CONTINUE;
 }
 
@@ -324,6 +362,13 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 }
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
+  // Let the frames still in flight finish before releasing what they use.
+  for (Uint32 i = 0; i < FRAMES_IN_FLIGHT; i++) {
+    if (frameFences[i]) {
+      SDL_WaitForGPUFences(device, true, &frameFences[i], 1);
+      SDL_ReleaseGPUFence(device, frameFences[i]);
+    }
+  }
   SDL_ReleaseGPUBuffer(device, vertexBuffer);
   SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
   SDL_ReleaseGPUGraphicsPipeline(device, graphicsPipeline);